@@ -137,13 +137,25 @@ typedef enum {ISSID               = 0,   /* Service Set Identifier         */
 } tenuInfoElemID;
 
 
+/*
+ * One config exchange. Requests come from a small pool so that exchanges
+ * from different driver handles don't share a packet buffer; a response is
+ * matched to its request by sequence number and decoded straight from the
+ * received frame.
+ */
+#define CONFIG_PKT_POOL_SIZE	4
+
 typedef struct
-{    
-    WILC_Char* pcRespBuffer;
-    WILC_Sint32 s32MaxRespBuffLen;
-    WILC_Sint32 s32BytesRead;
-    WILC_Bool bRespRequired;
-} tstrConfigPktInfo;
+{
+    WILC_Bool bInUse;
+    WILC_Bool bPending;			/* sent, waiting for its response */
+    WILC_Uint8 u8Mode;
+    WILC_Uint8 u8SeqNo;
+    WILC_Sint8* ps8Packet;		/* MAX_PACKET_BUFF_SIZE */
+    tstrWID* pstrWIDs;			/* where a GET response is decoded to */
+    WILC_Sint32 s32Result;
+    WILC_SemaphoreHandle hSemResp;
+} tstrConfigPktReq;
 
 
 
@@ -162,12 +174,12 @@ extern void host_int_ScanCompleteReceived(WILC_Uint8 * pu8Buffer, WILC_Uint32 u3
 /*****************************************************************************/
 /* Global Variables                                                          */
 /*****************************************************************************/
+/* protects the request pool, g_oper_mode and g_seqno while a packet is built */
 static WILC_SemaphoreHandle SemHandleSendPkt;
-static WILC_SemaphoreHandle SemHandlePktResp;
-
-static WILC_Sint8* gps8ConfigPacket = NULL;
+/* counts the free requests */
+static WILC_SemaphoreHandle SemHandlePktPool;
 
-static tstrConfigPktInfo gstrConfigPktInfo;
+static tstrConfigPktReq gastrConfigPktPool[CONFIG_PKT_POOL_SIZE];
 
 static WILC_Uint8      g_seqno = 0;
 
@@ -681,29 +693,34 @@ WILC_Sint32 CoreConfiguratorInit(void)
 	WILC_Sint32 s32Error = WILC_SUCCESS;	
 	tstrWILC_SemaphoreAttrs strSemSendPktAttrs;
 	tstrWILC_SemaphoreAttrs strSemPktRespAttrs;
+	WILC_Uint32 i;
 	
 	PRINT_D(CORECONFIG_DBG,"CoreConfiguratorInit() \n");
 
 	WILC_SemaphoreFillDefault(&strSemSendPktAttrs);			
 	strSemSendPktAttrs.u32InitCount = 1;
 	WILC_SemaphoreCreate(&SemHandleSendPkt, &strSemSendPktAttrs);
+	strSemSendPktAttrs.u32InitCount = CONFIG_PKT_POOL_SIZE;
+	WILC_SemaphoreCreate(&SemHandlePktPool, &strSemSendPktAttrs);
 
 	WILC_SemaphoreFillDefault(&strSemPktRespAttrs);			
 	strSemPktRespAttrs.u32InitCount = 0;
-	WILC_SemaphoreCreate(&SemHandlePktResp, &strSemPktRespAttrs);
-	
-	gps8ConfigPacket = (WILC_Sint8*)WILC_MALLOC(MAX_PACKET_BUFF_SIZE);
-	if(gps8ConfigPacket == NULL)
+	WILC_memset((void*)gastrConfigPktPool, 0, sizeof(gastrConfigPktPool));
+	for(i = 0; i < CONFIG_PKT_POOL_SIZE; i++)
 	{
-		PRINT_ER("failed in gps8ConfigPacket allocation \n");
-		s32Error = WILC_NO_MEM;
-		goto _fail_;
+		WILC_SemaphoreCreate(&gastrConfigPktPool[i].hSemResp, &strSemPktRespAttrs);
+		#ifdef SIMULATION
+		/* only the simulation builds packets here, the driver packs WIDs in wilc_wlan_cfg */
+		gastrConfigPktPool[i].ps8Packet = (WILC_Sint8*)WILC_MALLOC(MAX_PACKET_BUFF_SIZE);
+		if(gastrConfigPktPool[i].ps8Packet == NULL)
+		{
+			PRINT_ER("failed in config packet allocation \n");
+			s32Error = WILC_NO_MEM;
+			break;
+		}
+		#endif
 	}
 
-	WILC_memset((void*)gps8ConfigPacket, 0, MAX_PACKET_BUFF_SIZE);
-
-	WILC_memset((void*)(&gstrConfigPktInfo), 0, sizeof(tstrConfigPktInfo));
-	_fail_:
 	return s32Error;
 }
 
@@ -779,20 +796,20 @@ WILC_Uint8 get_current_channel(WILC_Uint8 *pu8msa, WILC_Uint16 u16RxLen)
 }
 
 /**
-*  @brief 			parses the received 'N' message
-*  @details 	
+*  @brief 			parses the received 'N' message in place
+*  @details 	Fills a Network Info provided by the caller. Its pu8IEs points
+*  			into pu8MsgBuffer rather than to a copy, so nothing is allocated:
+*  			the Network Info is valid as long as pu8MsgBuffer is, and must
+*  			not be passed to DeallocateNetworkInfo().
 *  @param[in] 	pu8MsgBuffer The message to be parsed
-*  @param[out] 	ppstrNetworkInfo pointer to pointer to the structure containing the parsed Network Info
+*  @param[out] 	pstrNetworkInfo the structure to hold the parsed Network Info
 *  @return 		Error code indicating success/failure
 *  @note 		
-*  @author		mabubakr
-*  @date			1 Mar 2012
 *  @version		1.0
 */
-WILC_Sint32 ParseNetworkInfo(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo** ppstrNetworkInfo)
+WILC_Sint32 ParseNetworkInfoInPlace(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo* pstrNetworkInfo)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;
-	tstrNetworkInfo* pstrNetworkInfo = WILC_NULL;
 	WILC_Uint8  u8MsgType = 0;
 	WILC_Uint8  u8MsgID = 0;
     WILC_Uint16 u16MsgLen = 0;
@@ -830,13 +847,17 @@ WILC_Sint32 ParseNetworkInfo(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo** ppstrNe
 		WILC_Uint8  *pu8msa = 0;
 		WILC_Uint16 u16RxLen = 0;					
 		WILC_Uint8 *pu8TimElm = 0;
-		WILC_Uint8 *pu8IEs = 0;
-		WILC_Uint16 u16IEsLen = 0;
 		WILC_Uint8 u8index = 0;
 		WILC_Uint32 u32Tsf_Lo;
 		WILC_Uint32 u32Tsf_Hi;
+
+		/* rssi, then at least the fixed part of the frame */
+		if(u16WidLen < 1 + MAC_HDR_LEN + TIME_STAMP_LEN + BEACON_INTERVAL_LEN + CAP_INFO_LEN)
+		{
+			PRINT_ER("Network info too short: %d\n", u16WidLen);
+			WILC_ERRORREPORT(s32Error, WILC_FAIL);
+		}
 		
-		pstrNetworkInfo = (tstrNetworkInfo*)WILC_MALLOC(sizeof(tstrNetworkInfo));
 		WILC_memset((void*)(pstrNetworkInfo), 0, sizeof(tstrNetworkInfo));
 
 		pstrNetworkInfo->s8rssi = pu8WidVal[0];
@@ -884,19 +905,61 @@ WILC_Sint32 ParseNetworkInfo(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo** ppstrNe
         {
 			pstrNetworkInfo->u8DtimPeriod = pu8TimElm[3];
         }
-		pu8IEs = &pu8msa[MAC_HDR_LEN + TIME_STAMP_LEN + BEACON_INTERVAL_LEN + CAP_INFO_LEN];
-		u16IEsLen = u16RxLen - (MAC_HDR_LEN + TIME_STAMP_LEN + BEACON_INTERVAL_LEN + CAP_INFO_LEN);
-
-		if(u16IEsLen > 0)
+		pstrNetworkInfo->u16IEsLen = u16RxLen - (MAC_HDR_LEN + TIME_STAMP_LEN + BEACON_INTERVAL_LEN + CAP_INFO_LEN);
+		if(pstrNetworkInfo->u16IEsLen > 0)
 		{
-			pstrNetworkInfo->pu8IEs = (WILC_Uint8*)WILC_MALLOC(u16IEsLen);
-			WILC_memset((void*)(pstrNetworkInfo->pu8IEs), 0, u16IEsLen);
-			
-			WILC_memcpy(pstrNetworkInfo->pu8IEs, pu8IEs, u16IEsLen);
+			pstrNetworkInfo->pu8IEs = &pu8msa[MAC_HDR_LEN + TIME_STAMP_LEN + BEACON_INTERVAL_LEN + CAP_INFO_LEN];
 		}
-		pstrNetworkInfo->u16IEsLen = u16IEsLen;
 		
 	}
+
+ERRORHANDLER:
+	return s32Error;
+}
+
+/**
+*  @brief 			parses the received 'N' message
+*  @details 	The Network Info and its IEs are allocated, the caller frees
+*  			them with DeallocateNetworkInfo().
+*  @param[in] 	pu8MsgBuffer The message to be parsed
+*  @param[out] 	ppstrNetworkInfo pointer to pointer to the structure containing the parsed Network Info
+*  @return 		Error code indicating success/failure
+*  @note 		
+*  @author		mabubakr
+*  @date			1 Mar 2012
+*  @version		1.0
+*/
+WILC_Sint32 ParseNetworkInfo(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo** ppstrNetworkInfo)
+{
+	WILC_Sint32 s32Error = WILC_SUCCESS;
+	tstrNetworkInfo* pstrNetworkInfo = WILC_NULL;
+	WILC_Uint8 *pu8IEs = 0;
+
+	pstrNetworkInfo = (tstrNetworkInfo*)WILC_MALLOC(sizeof(tstrNetworkInfo));
+	if(pstrNetworkInfo == WILC_NULL)
+	{
+		WILC_ERRORREPORT(s32Error, WILC_NO_MEM);
+	}
+
+	s32Error = ParseNetworkInfoInPlace(pu8MsgBuffer, pstrNetworkInfo);
+	if(s32Error != WILC_SUCCESS)
+	{
+		WILC_FREE(pstrNetworkInfo);
+		WILC_ERRORREPORT(s32Error, s32Error);
+	}
+
+	/* give the Network Info its own copy of the IEs */
+	if(pstrNetworkInfo->u16IEsLen > 0)
+	{
+		pu8IEs = (WILC_Uint8*)WILC_MALLOC(pstrNetworkInfo->u16IEsLen);
+		if(pu8IEs == WILC_NULL)
+		{
+			WILC_FREE(pstrNetworkInfo);
+			WILC_ERRORREPORT(s32Error, WILC_NO_MEM);
+		}
+		WILC_memcpy(pu8IEs, pstrNetworkInfo->pu8IEs, pstrNetworkInfo->u16IEsLen);
+		pstrNetworkInfo->pu8IEs = pu8IEs;
+	}
 	
 	*ppstrNetworkInfo = pstrNetworkInfo;
 
@@ -942,6 +1005,166 @@ WILC_Sint32 DeallocateNetworkInfo(tstrNetworkInfo* pstrNetworkInfo)
 	return s32Error;
 }
 
+#if defined (WILC_DEBUGFS)
+/**
+*  @brief 			builds a synthetic 'N' message, for the scan benchmarks
+*  @details 	A beacon from pu8bssid carrying an SSID, supported rates, DS
+*  			parameter set, TIM and a vendor IE, followed by the driver
+*  			handle as the firmware appends it.
+*  @param[out] 	pu8Buffer at least NETWORK_INFO_MSG_MAX bytes
+*  @param[in] 	pu8bssid BSSID of the beacon
+*  @param[in] 	s8rssi RSSI the beacon was received at
+*  @param[in] 	drvHandler driver handle appended to the message
+*  @return 		length of the message, driver handle included
+*  @note 		
+*  @version		1.0
+*/
+WILC_Uint32 BuildNetworkInfoMsg(WILC_Uint8* pu8Buffer, const WILC_Uint8* pu8bssid, WILC_Sint8 s8rssi,
+		WILC_Uint32 drvHandler)
+{
+	static const WILC_Uint8 au8Rates[] = {0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24};
+	WILC_Uint8* pu8msa;
+	WILC_Uint16 u16WidLen;
+	WILC_Uint32 u32Len;
+	WILC_Uint16 i = 0;
+
+	/* the beacon: MAC header, fixed fields, then the IEs */
+	pu8msa = &pu8Buffer[9];
+	WILC_memset(pu8msa, 0, MAC_HDR_LEN + TIME_STAMP_LEN);
+	pu8msa[0] = BEACON;
+	WILC_memset(&pu8msa[4], 0xff, 6);
+	WILC_memcpy(&pu8msa[10], pu8bssid, 6);
+	WILC_memcpy(&pu8msa[16], pu8bssid, 6);
+	i = MAC_HDR_LEN + TIME_STAMP_LEN;
+	pu8msa[i++] = 100;			/* beacon interval */
+	pu8msa[i++] = 0;
+	pu8msa[i++] = 0x11;			/* ESS, privacy */
+	pu8msa[i++] = 0x04;
+
+	pu8msa[i++] = ISSID;
+	pu8msa[i++] = 10;
+	WILC_memcpy(&pu8msa[i], "wilc-bench", 10);
+	i += 10;
+	pu8msa[i++] = ISUPRATES;
+	pu8msa[i++] = sizeof(au8Rates);
+	WILC_memcpy(&pu8msa[i], au8Rates, sizeof(au8Rates));
+	i += sizeof(au8Rates);
+	pu8msa[i++] = IDSPARMS;
+	pu8msa[i++] = 1;
+	pu8msa[i++] = (pu8bssid[5] % 11) + 1;
+	pu8msa[i++] = ITIM;
+	pu8msa[i++] = 4;
+	pu8msa[i++] = 0;
+	pu8msa[i++] = 1;
+	pu8msa[i++] = 0;
+	pu8msa[i++] = 0;
+	/* vendor specific IE, beacons seen in the field are this size and
+	   more. The OUI is left zero, it matches nothing the driver parses */
+	pu8msa[i++] = IWPAELEMENT;
+	pu8msa[i++] = 128;
+	WILC_memset(&pu8msa[i], 0, 128);
+	i += 128;
+
+	/* rssi, then the frame */
+	u16WidLen = 1 + i;
+	pu8Buffer[8] = (WILC_Uint8)s8rssi;
+
+	u32Len = 8 + u16WidLen;
+	pu8Buffer[0] = 'N';
+	pu8Buffer[1] = 0;
+	pu8Buffer[2] = (WILC_Uint8)(u32Len & 0xff);
+	pu8Buffer[3] = (WILC_Uint8)(u32Len >> 8);
+	pu8Buffer[4] = (WILC_Uint8)(WID_NEWORK_INFO & 0xff);
+	pu8Buffer[5] = (WILC_Uint8)(WID_NEWORK_INFO >> 8);
+	pu8Buffer[6] = (WILC_Uint8)(u16WidLen & 0xff);
+	pu8Buffer[7] = (WILC_Uint8)(u16WidLen >> 8);
+
+	pu8Buffer[u32Len++] = (WILC_Uint8)drvHandler;
+	pu8Buffer[u32Len++] = (WILC_Uint8)(drvHandler >> 8);
+	pu8Buffer[u32Len++] = (WILC_Uint8)(drvHandler >> 16);
+	pu8Buffer[u32Len++] = (WILC_Uint8)(drvHandler >> 24);
+
+	return u32Len;
+}
+
+/*
+ * Parser benchmark, run each time wilc_bench_parse is read: the same
+ * synthetic 'N' messages go through ParseNetworkInfo() and
+ * DeallocateNetworkInfo(), as scan results used to, and through
+ * ParseNetworkInfoInPlace(). Allocations are counted over each run,
+ * other driver activity during the read is counted too.
+ */
+#define PARSE_BENCH_FRAMES	4096
+#define PARSE_BENCH_NETWORKS	256
+
+int ParseNetworkInfoBench(char *buf, int size)
+{
+	WILC_Uint8 (*pau8Msgs)[NETWORK_INFO_MSG_MAX];
+	tstrNetworkInfo strNetworkInfo;
+	tstrNetworkInfo* pstrNetworkInfo;
+	WILC_Uint8 au8bssid[6] = {0x02, 0xbe, 0x4c, 0, 0, 0};
+	WILC_Uint32 i, u32Len = 0, u32Allocs, u32Failed;
+	WILC_Uint64 u64Ns;
+	ktime_t tStart;
+	int len = 0;
+
+	pau8Msgs = WILC_MALLOC(PARSE_BENCH_NETWORKS * NETWORK_INFO_MSG_MAX);
+	if(pau8Msgs == WILC_NULL)
+	{
+		return scnprintf(buf, size, "out of memory\n");
+	}
+	for(i = 0; i < PARSE_BENCH_NETWORKS; i++)
+	{
+		au8bssid[5] = (WILC_Uint8)i;
+		u32Len = BuildNetworkInfoMsg(pau8Msgs[i], au8bssid, -50 - (WILC_Sint8)(i & 31), 0);
+	}
+
+	len += scnprintf(buf + len, size - len, "%u frames of %u bytes\n", PARSE_BENCH_FRAMES, u32Len);
+	len += scnprintf(buf + len, size - len, "%-9s %8s %12s %9s %7s\n",
+			"parser", "allocs", "allocs/frame", "ns/frame", "failed");
+
+	u32Failed = 0;
+	u32Allocs = atomic_read(&gWilcMemAllocs);
+	tStart = ktime_get();
+	for(i = 0; i < PARSE_BENCH_FRAMES; i++)
+	{
+		if(ParseNetworkInfo(pau8Msgs[i % PARSE_BENCH_NETWORKS], &pstrNetworkInfo) == WILC_SUCCESS)
+		{
+			DeallocateNetworkInfo(pstrNetworkInfo);
+		}
+		else
+		{
+			u32Failed++;
+		}
+	}
+	u64Ns = ktime_to_ns(ktime_sub(ktime_get(), tStart));
+	u32Allocs = atomic_read(&gWilcMemAllocs) - u32Allocs;
+	len += scnprintf(buf + len, size - len, "%-9s %8u %12u %9u %7u\n", "copy",
+			u32Allocs, u32Allocs / PARSE_BENCH_FRAMES,
+			(WILC_Uint32)div_u64(u64Ns, PARSE_BENCH_FRAMES), u32Failed);
+
+	u32Failed = 0;
+	u32Allocs = atomic_read(&gWilcMemAllocs);
+	tStart = ktime_get();
+	for(i = 0; i < PARSE_BENCH_FRAMES; i++)
+	{
+		if(ParseNetworkInfoInPlace(pau8Msgs[i % PARSE_BENCH_NETWORKS], &strNetworkInfo) != WILC_SUCCESS)
+		{
+			u32Failed++;
+		}
+	}
+	u64Ns = ktime_to_ns(ktime_sub(ktime_get(), tStart));
+	u32Allocs = atomic_read(&gWilcMemAllocs) - u32Allocs;
+	len += scnprintf(buf + len, size - len, "%-9s %8u %12u %9u %7u\n", "in_place",
+			u32Allocs, u32Allocs / PARSE_BENCH_FRAMES,
+			(WILC_Uint32)div_u64(u64Ns, PARSE_BENCH_FRAMES), u32Failed);
+
+	WILC_FREE(pau8Msgs);
+
+	return len;
+}
+#endif
+
 /**
 *  @brief 			parses the received Association Response frame
 *  @details 	
@@ -1588,7 +1811,6 @@ WILC_Sint32 further_process_response(WILC_Uint8*   resp,
     WILC_Uint8  cfg_chr  = 0;
     WILC_Uint16 cfg_sht  = 0;
     WILC_Uint32 cfg_int  = 0;
-    WILC_Uint8  cfg_str[256] = {0};   
     tenuWIDtype enuWIDtype = WID_UNDEF;
 
     if(process_wid_num)
@@ -1634,22 +1856,9 @@ WILC_Sint32 further_process_response(WILC_Uint8*   resp,
     	}
     case WID_STR:
 	{
-	        WILC_memcpy(cfg_str, resp + idx, cfg_len);
-	        //cfg_str[cfg_len] = '\0'; //mostafa: no need currently for NULL termination
-	        if(process_wid_num)
-	        {
-	            /*fprintf(out_file,"0x%4.4x = %s\n",g_wid_num,
-	                                            cfg_str);*/
-	        }
-	        else
-	        {
-	            /*fprintf(out_file,"%s = %s\n",gastrWIDs[cnt].cfg_switch,
-	                                         cfg_str);*/
-	        }
-
 		 if(pstrWIDresult->s32ValueSize >= cfg_len)
 		 {
-	        	WILC_memcpy(pstrWIDresult->ps8WidVal, cfg_str, cfg_len); //mostafa: no need currently for the extra NULL byte
+	        	WILC_memcpy(pstrWIDresult->ps8WidVal, resp + idx, cfg_len); //mostafa: no need currently for the extra NULL byte
 	        	pstrWIDresult->s32ValueSize = cfg_len;
 		 }
 		else
@@ -1662,38 +1871,12 @@ WILC_Sint32 further_process_response(WILC_Uint8*   resp,
     	}
 
     case WID_ADR:
-        create_mac_addr(cfg_str, resp + idx);
-		
-		WILC_strncpy(pstrWIDresult->ps8WidVal,cfg_str,WILC_strlen(cfg_str));
-		pstrWIDresult->ps8WidVal[WILC_strlen(cfg_str)] = '\0';
-        if(process_wid_num)
-        {
-            /*fprintf(out_file,"0x%4.4x = %s\n",g_wid_num,
-                                            cfg_str);*/
-        }
-        else
-        {
-            /*fprintf(out_file,"%s = %s\n",gastrWIDs[cnt].cfg_switch,
-                                         cfg_str);*/
-        }
+        /* "xx:xx:xx:xx:xx:xx" and its NULL, formatted in place */
+        create_mac_addr((WILC_Uint8*)pstrWIDresult->ps8WidVal, resp + idx);
         break;
 
     case WID_IP:
-        cfg_int = MAKE_WORD32(
-                    MAKE_WORD16(resp[idx], resp[idx + 1]),
-                    MAKE_WORD16(resp[idx + 2], resp[idx + 3])
-                    );
-        conv_int_to_ip(cfg_str, cfg_int);
-        if(process_wid_num)
-        {
-            /*fprintf(out_file,"0x%4.4x = %s\n",g_wid_num,
-                                            cfg_str);*/
-        }
-        else
-        {
-            /*fprintf(out_file,"%s = %s\n",gastrWIDs[cnt].cfg_switch,
-                                         cfg_str);*/
-        }
+        /* only ever formatted for the (removed) command line dump */
         break;
     case WID_BIN_DATA:
 	{
@@ -2002,28 +2185,32 @@ WILC_Sint32 CreateConfigPacket(WILC_Sint8* ps8packet, WILC_Sint32*ps32PacketLeng
     return s32Error;
 }
 
-WILC_Sint32 ConfigWaitResponse(WILC_Char* pcRespBuffer, WILC_Sint32 s32MaxRespBuffLen, WILC_Sint32 *ps32BytesRead, 
-						           WILC_Bool bRespRequired)
+#ifdef SIMULATION
+static tstrConfigPktReq* ConfigPktReqGet(void)
 {
-	WILC_Sint32 s32Error = WILC_SUCCESS;
-	/*bug 3878*/
-	/*removed to caller function*/
-	/*gstrConfigPktInfo.pcRespBuffer = pcRespBuffer;
-	gstrConfigPktInfo.s32MaxRespBuffLen = s32MaxRespBuffLen;
-	gstrConfigPktInfo.bRespRequired = bRespRequired;*/
-	
-	
-	if(gstrConfigPktInfo.bRespRequired == WILC_TRUE)
-	{
-		WILC_SemaphoreAcquire(&SemHandlePktResp, WILC_NULL);
+	WILC_Uint32 i;
 
-		*ps32BytesRead = gstrConfigPktInfo.s32BytesRead;
+	/* SemHandlePktPool guarantees a free one, SemHandleSendPkt is held */
+	for(i = 0; i < CONFIG_PKT_POOL_SIZE; i++)
+	{
+		if(!gastrConfigPktPool[i].bInUse)
+		{
+			gastrConfigPktPool[i].bInUse = WILC_TRUE;
+			return &gastrConfigPktPool[i];
+		}
 	}
-	
-	WILC_memset((void*)(&gstrConfigPktInfo), 0, sizeof(tstrConfigPktInfo));
-	
-	return s32Error;
+	return WILC_NULL;
+}
+
+static void ConfigPktReqPut(tstrConfigPktReq* pstrReq)
+{
+	WILC_SemaphoreAcquire(&SemHandleSendPkt, WILC_NULL);
+	pstrReq->bPending = WILC_FALSE;
+	pstrReq->bInUse = WILC_FALSE;
+	WILC_SemaphoreRelease(&SemHandleSendPkt, WILC_NULL);
+	WILC_SemaphoreRelease(&SemHandlePktPool, WILC_NULL);
 }
+#endif
 
 /**
 *  @brief 		sends certain Configuration Packet based on the input WIDs pstrWIDs
@@ -2044,103 +2231,101 @@ WILC_Sint32 SendConfigPkt(WILC_Uint8 u8Mode, tstrWID* pstrWIDs,
 		WILC_Uint32 u32WIDsCount,WILC_Bool bRespRequired,WILC_Uint32 drvHandler)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;	
-	WILC_Sint32 err = WILC_SUCCESS;
 	WILC_Sint32 s32ConfigPacketLen = 0;	
-	WILC_Sint32 s32RcvdRespLen = 0;
+	tstrConfigPktReq* pstrReq;
 		
+	WILC_SemaphoreAcquire(&SemHandlePktPool, WILC_NULL);
 	WILC_SemaphoreAcquire(&SemHandleSendPkt, WILC_NULL);
-	
+	pstrReq = ConfigPktReqGet();
+
 	/*set the packet mode*/
 	g_oper_mode = u8Mode;		
+	pstrReq->u8Mode = u8Mode;
+	pstrReq->u8SeqNo = g_seqno;
+	pstrReq->pstrWIDs = pstrWIDs;
+	pstrReq->s32Result = WILC_FAIL;
 
-	WILC_memset((void*)gps8ConfigPacket, 0, MAX_PACKET_BUFF_SIZE);	
-		
-	if(CreateConfigPacket(gps8ConfigPacket, &s32ConfigPacketLen, pstrWIDs, u32WIDsCount) != WILC_SUCCESS)
+	/* every byte up to s32ConfigPacketLen is written, no need to clear the buffer */
+	if(CreateConfigPacket(pstrReq->ps8Packet, &s32ConfigPacketLen, pstrWIDs, u32WIDsCount) != WILC_SUCCESS)
 	{
+		WILC_SemaphoreRelease(&SemHandleSendPkt, WILC_NULL);
 		s32Error = WILC_FAIL;
 		goto End_ConfigPkt;		
 	}
-	/*bug 3878*/
-	gstrConfigPktInfo.pcRespBuffer = gps8ConfigPacket;
-	gstrConfigPktInfo.s32MaxRespBuffLen = MAX_PACKET_BUFF_SIZE;
-	PRINT_INFO(CORECONFIG_DBG,"GLOBAL =bRespRequired =%d\n", bRespRequired);
-	gstrConfigPktInfo.bRespRequired = bRespRequired;
+	PRINT_INFO(CORECONFIG_DBG,"bRespRequired =%d\n", bRespRequired);
+	pstrReq->bPending = bRespRequired;
+	WILC_SemaphoreRelease(&SemHandleSendPkt, WILC_NULL);
 
-	s32Error = SendRawPacket(gps8ConfigPacket, s32ConfigPacketLen);
+	s32Error = SendRawPacket(pstrReq->ps8Packet, s32ConfigPacketLen);
 	if(s32Error != WILC_SUCCESS)
 	{		
 		goto End_ConfigPkt;
 	}
 	
-	WILC_memset((void*)gps8ConfigPacket, 0, MAX_PACKET_BUFF_SIZE);
-	
-	ConfigWaitResponse(gps8ConfigPacket, MAX_PACKET_BUFF_SIZE, &s32RcvdRespLen, bRespRequired);
-
-
+	/* ConfigProvideResponse() decodes the response into pstrWIDs */
 	if(bRespRequired == WILC_TRUE)
 	{
-		/* If the operating Mode is GET, then we expect a response frame from */
-    	/* the driver. Hence start listening to the port for response         */
-    		if(g_oper_mode == GET_CFG)
-		{
-			#if 1
-			err = ParseResponse(gps8ConfigPacket, pstrWIDs);
-			if(err != 0)
-			{
-				s32Error = WILC_FAIL;
-				goto End_ConfigPkt;
-			}
-			else
-			{
-				s32Error = WILC_SUCCESS;
-			}
-			#endif
-		 }
-   	     	else
-	    	{	        				
-			err = ParseWriteResponse(gps8ConfigPacket);
-			if(err != WRITE_RESP_SUCCESS)
-			{
-				s32Error = WILC_FAIL;
-				goto End_ConfigPkt;
-			}
-			else
-			{
-				s32Error = WILC_SUCCESS;
-			}
-	    	}
-
-		
+		WILC_SemaphoreAcquire(&pstrReq->hSemResp, WILC_NULL);
+		s32Error = pstrReq->s32Result;
 	}
 	
 	
 End_ConfigPkt:	
-	WILC_SemaphoreRelease(&SemHandleSendPkt, WILC_NULL);
+	ConfigPktReqPut(pstrReq);
 
 	return s32Error;
 }
+
+WILC_Sint32 SendConfigPktAsync(tstrWID* pstrWIDs, WILC_Uint32 u32WIDsCount, WILC_Uint32 drvHandler)
+{
+	return SendConfigPkt(SET_CFG, pstrWIDs, u32WIDsCount, WILC_FALSE, drvHandler);
+}
 #endif
 WILC_Sint32 ConfigProvideResponse(WILC_Char* pcRespBuffer, WILC_Sint32 s32RespLen)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;
+	WILC_Uint8* pu8Resp = (WILC_Uint8*)pcRespBuffer;
+	tstrConfigPktReq* pstrReq = WILC_NULL;
+	WILC_Uint32 i;
 
-	if(gstrConfigPktInfo.bRespRequired == WILC_TRUE)
+	if(s32RespLen < MSG_HEADER_LEN)
+		return WILC_FAIL;
+
+	WILC_SemaphoreAcquire(&SemHandleSendPkt, WILC_NULL);
+	for(i = 0; i < CONFIG_PKT_POOL_SIZE; i++)
 	{
-		if(s32RespLen <= gstrConfigPktInfo.s32MaxRespBuffLen)
-		{
-			WILC_memcpy(gstrConfigPktInfo.pcRespBuffer, pcRespBuffer, s32RespLen);
-			gstrConfigPktInfo.s32BytesRead = s32RespLen;
-		}
-		else
+		if(gastrConfigPktPool[i].bPending && gastrConfigPktPool[i].u8SeqNo == pu8Resp[1])
 		{
-			WILC_memcpy(gstrConfigPktInfo.pcRespBuffer, pcRespBuffer, gstrConfigPktInfo.s32MaxRespBuffLen);
-			gstrConfigPktInfo.s32BytesRead = gstrConfigPktInfo.s32MaxRespBuffLen;
-			PRINT_ER("BusProvideResponse() Response greater than the prepared Buffer Size \n");
+			pstrReq = &gastrConfigPktPool[i];
+			pstrReq->bPending = WILC_FALSE;
+			break;
 		}
-		
-		WILC_SemaphoreRelease(&SemHandlePktResp, WILC_NULL);
+	}
+	WILC_SemaphoreRelease(&SemHandleSendPkt, WILC_NULL);
+
+	if(pstrReq == WILC_NULL)
+	{
+		PRINT_D(CORECONFIG_DBG,"No request waiting for response %d\n",pu8Resp[1]);
+		return s32Error;
+	}
+
+	/* decoded from the received frame, without copying it first */
+	if(MAKE_WORD16(pu8Resp[2], pu8Resp[3]) > s32RespLen)
+	{
+		PRINT_ER("BusProvideResponse() Response longer than the received frame \n");
+		pstrReq->s32Result = WILC_FAIL;
+	}
+	else if(pstrReq->u8Mode == GET_CFG)
+	{
+		pstrReq->s32Result = (ParseResponse(pu8Resp, pstrReq->pstrWIDs) == 0) ? WILC_SUCCESS : WILC_FAIL;
+	}
+	else
+	{
+		pstrReq->s32Result = (ParseWriteResponse(pu8Resp) == WRITE_RESP_SUCCESS) ? WILC_SUCCESS : WILC_FAIL;
 	}
 	
+	WILC_SemaphoreRelease(&pstrReq->hSemResp, WILC_NULL);
+	
 	return s32Error;
 }
 
@@ -2212,19 +2397,22 @@ WILC_Sint32 ConfigPktReceived(WILC_Uint8* pu8RxPacket, WILC_Sint32 s32RxPacketLe
 WILC_Sint32 CoreConfiguratorDeInit(void)
 {	
 	WILC_Sint32 s32Error = WILC_SUCCESS;		
+	WILC_Uint32 i;
 
 	PRINT_D(CORECONFIG_DBG,"CoreConfiguratorDeInit() \n");		
 
 
 	WILC_SemaphoreDestroy(&SemHandleSendPkt, WILC_NULL);
-	WILC_SemaphoreDestroy(&SemHandlePktResp, WILC_NULL);
+	WILC_SemaphoreDestroy(&SemHandlePktPool, WILC_NULL);
 
-		
-	if(gps8ConfigPacket != NULL)
+	for(i = 0; i < CONFIG_PKT_POOL_SIZE; i++)
 	{
-
-		WILC_FREE(gps8ConfigPacket);
-		gps8ConfigPacket = NULL;
+		WILC_SemaphoreDestroy(&gastrConfigPktPool[i].hSemResp, WILC_NULL);
+		if(gastrConfigPktPool[i].ps8Packet != NULL)
+		{
+			WILC_FREE(gastrConfigPktPool[i].ps8Packet);
+			gastrConfigPktPool[i].ps8Packet = NULL;
+		}
 	}
 
 	return s32Error;
@@ -2235,6 +2423,22 @@ WILC_Sint32 CoreConfiguratorDeInit(void)
 #if WILC_PLATFORM !=WILC_WIN32
 /*Using the global handle of the driver*/
 extern wilc_wlan_oup_t* gpstrWlanOps;
+extern void host_int_wid_shadow_sent(WILC_Uint32 drvHandler, tstrWID* pstrWIDs, WILC_Uint32 u32WIDsCount);
+extern WILC_Bool host_int_arbiter_yield(void);
+extern void host_int_arbiter_resume(void);
+extern void host_int_conn_trace_cfg(WILC_Uint32 drvHandler, WILC_Bool bDone, WILC_Sint32 s32Arg);
+
+/*
+ * Completion of a SET sent by SendConfigPktAsync(). Runs inline in the RX
+ * path, possibly from the interrupt handler with the bus held, so it only
+ * logs: no blocking, no sleeping locks.
+ */
+static void SendConfigPktDone(void *pvPriv, int s32Status)
+{
+	if(s32Status < 0)
+		PRINT_ER("[Sendconfigpkt]Set failed for drv handler %p\n", pvPriv);
+}
+
 /**
 *  @brief 		sends certain Configuration Packet based on the input WIDs pstrWIDs
 *  using driver config layer
@@ -2254,6 +2458,7 @@ WILC_Sint32 SendConfigPkt(WILC_Uint8 u8Mode, tstrWID* pstrWIDs,
 		WILC_Uint32 u32WIDsCount,WILC_Bool bRespRequired,WILC_Uint32 drvHandler)
 {
 	WILC_Sint32 counter = 0,ret = 0;
+	WILC_Bool bYielded;
 	if(gpstrWlanOps == NULL)
 	{
 		PRINT_D(CORECONFIG_DBG,"Net Dev is still not initialized\n");
@@ -2263,8 +2468,8 @@ WILC_Sint32 SendConfigPkt(WILC_Uint8 u8Mode, tstrWID* pstrWIDs,
 	{
 		PRINT_D(CORECONFIG_DBG,"Net Dev is initialized\n");
 	}
-	if( gpstrWlanOps->wlan_cfg_set == NULL ||
-			gpstrWlanOps->wlan_cfg_get == NULL)
+	if( gpstrWlanOps->wlan_cfg_txn_start == NULL ||
+			gpstrWlanOps->wlan_cfg_txn_commit == NULL)
 	{
 		PRINT_D(CORECONFIG_DBG,"Set and Get is still not initialized\n");
 			return 1;
@@ -2273,21 +2478,29 @@ WILC_Sint32 SendConfigPkt(WILC_Uint8 u8Mode, tstrWID* pstrWIDs,
 	{
 		PRINT_D(CORECONFIG_DBG,"SET is initialized\n");
 	}
+	host_int_conn_trace_cfg(drvHandler, WILC_FALSE, u8Mode);
+	/* One config transaction: the WIDs go out in as few frames as fit */
 	if(u8Mode == GET_CFG)
 	{
+		gpstrWlanOps->wlan_cfg_txn_start(drvHandler);
 		for(counter = 0;counter<u32WIDsCount;counter++)
 		{
-			PRINT_INFO(CORECONFIG_DBG,"Sending CFG packet [%d][%d]\n",!counter,
-					(counter == u32WIDsCount - 1));
-			if(!gpstrWlanOps->wlan_cfg_get(!counter,
-					pstrWIDs[counter].u16WIDid,
-					(counter == u32WIDsCount - 1),drvHandler))
+			PRINT_INFO(CORECONFIG_DBG,"Adding CFG query [%d] WID:%x\n",counter,
+					pstrWIDs[counter].u16WIDid);
+			if(!gpstrWlanOps->wlan_cfg_txn_get(pstrWIDs[counter].u16WIDid))
 			{
 				ret = -1;
-				printk("[Sendconfigpkt]Get Timed out\n");
-				break;				
+				break;
 			}
 		}
+		/* let the other host interface workers run while waiting */
+		bYielded = host_int_arbiter_yield();
+		/* the values are read from tables shared by every query, keep them
+		   locked until they have been copied out */
+		if(gpstrWlanOps->wlan_cfg_txn_commit_hold() < 0)
+			ret = -1;
+		if(ret < 0)
+			printk("[Sendconfigpkt]Get Timed out\n");
 		/**
 			get the value
 		**/
@@ -2300,23 +2513,83 @@ WILC_Sint32 SendConfigPkt(WILC_Uint8 u8Mode, tstrWID* pstrWIDs,
 					pstrWIDs[counter].ps8WidVal,pstrWIDs[counter].s32ValueSize);
 			
 		}
+		gpstrWlanOps->wlan_cfg_txn_end();
+		if(bYielded)
+			host_int_arbiter_resume();
 	}
 	else if(u8Mode == SET_CFG)
 	{
+		host_int_wid_shadow_sent(drvHandler, pstrWIDs, u32WIDsCount);
+		gpstrWlanOps->wlan_cfg_txn_start(drvHandler);
 		for(counter = 0;counter<u32WIDsCount;counter++)
 		{
 			PRINT_D(CORECONFIG_DBG,"Sending config SET PACKET WID:%x\n",pstrWIDs[counter].u16WIDid);
-			if(!gpstrWlanOps->wlan_cfg_set(!counter,
-					pstrWIDs[counter].u16WIDid,pstrWIDs[counter].ps8WidVal,
-					pstrWIDs[counter].s32ValueSize,
-					(counter == u32WIDsCount - 1),drvHandler))
+			if(!gpstrWlanOps->wlan_cfg_txn_set(pstrWIDs[counter].u16WIDid,
+					pstrWIDs[counter].ps8WidVal,
+					pstrWIDs[counter].s32ValueSize))
 			{
 				ret = -1;
-				printk("[Sendconfigpkt]Set Timed out\n");
 				break;
 			}
 		}
+		bYielded = host_int_arbiter_yield();
+		if(gpstrWlanOps->wlan_cfg_txn_commit() < 0)
+			ret = -1;
+		if(bYielded)
+			host_int_arbiter_resume();
+		if(ret < 0)
+			printk("[Sendconfigpkt]Set Timed out\n");
+	}
+	host_int_conn_trace_cfg(drvHandler, WILC_TRUE, ret);
+
+	return ret;
+}
+
+/**
+*  @brief 		sends a SET Configuration Packet without waiting for its response
+*  @details 	Only for callers that do nothing on failure but log it: a
+			failure reported by the firmware is logged from
+			SendConfigPktDone(), the return value only covers building
+			and queueing the packet. Callers that unwind on error use
+			SendConfigPkt().
+*  @param[in] 	pstrWIDs WIDs to be sent in the configuration packet
+*  @param[in] 	u32WIDsCount number of WIDs to be sent in the configuration packet
+*  @param[in] 	drvHandler driver handle the WIDs are meant for
+*  @return 	Error code indicating success/failure
+*  @note
+*  @version	1.0
+*/
+WILC_Sint32 SendConfigPktAsync(tstrWID* pstrWIDs, WILC_Uint32 u32WIDsCount, WILC_Uint32 drvHandler)
+{
+	WILC_Sint32 counter, ret = 0;
+
+	if(gpstrWlanOps == NULL || gpstrWlanOps->wlan_cfg_txn_start == NULL ||
+	   gpstrWlanOps->wlan_cfg_txn_commit_async == NULL)
+	{
+		PRINT_D(CORECONFIG_DBG,"Set is still not initialized\n");
+		return 1;
+	}
+
+	host_int_conn_trace_cfg(drvHandler, WILC_FALSE, SET_CFG);
+	host_int_wid_shadow_sent(drvHandler, pstrWIDs, u32WIDsCount);
+	gpstrWlanOps->wlan_cfg_txn_start(drvHandler);
+	for(counter = 0;counter<u32WIDsCount;counter++)
+	{
+		PRINT_D(CORECONFIG_DBG,"Sending config SET PACKET WID:%x\n",pstrWIDs[counter].u16WIDid);
+		if(!gpstrWlanOps->wlan_cfg_txn_set(pstrWIDs[counter].u16WIDid,
+				pstrWIDs[counter].ps8WidVal,
+				pstrWIDs[counter].s32ValueSize))
+		{
+			ret = -1;
+			break;
+		}
 	}
+	/* the commit is needed even after a failure, it releases the transaction */
+	if(gpstrWlanOps->wlan_cfg_txn_commit_async(SendConfigPktDone, (void *)drvHandler) < 0)
+		ret = -1;
+	if(ret < 0)
+		printk("[Sendconfigpkt]Async set failed\n");
+	host_int_conn_trace_cfg(drvHandler, WILC_TRUE, ret);
 
 	return ret;
 }
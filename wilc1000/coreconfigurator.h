@@ -484,8 +484,16 @@ extern WILC_Sint32 CoreConfiguratorDeInit(void);
 
 extern WILC_Sint32 SendConfigPkt(WILC_Uint8 u8Mode, tstrWID* pstrWIDs,
        WILC_Uint32 u32WIDsCount,WILC_Bool bRespRequired,WILC_Uint32 drvHandler);
+extern WILC_Sint32 SendConfigPktAsync(tstrWID* pstrWIDs, WILC_Uint32 u32WIDsCount, WILC_Uint32 drvHandler);
 extern WILC_Sint32 ParseNetworkInfo(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo** ppstrNetworkInfo);
+extern WILC_Sint32 ParseNetworkInfoInPlace(WILC_Uint8* pu8MsgBuffer, tstrNetworkInfo* pstrNetworkInfo);
 extern WILC_Sint32 DeallocateNetworkInfo(tstrNetworkInfo* pstrNetworkInfo);
+#if defined (WILC_DEBUGFS)
+/* synthetic 'N' messages fit in this, driver handle included */
+#define NETWORK_INFO_MSG_MAX	256
+extern WILC_Uint32 BuildNetworkInfoMsg(WILC_Uint8* pu8Buffer, const WILC_Uint8* pu8bssid, WILC_Sint8 s8rssi,
+		WILC_Uint32 drvHandler);
+#endif
 
 extern WILC_Sint32 ParseAssocRespInfo(WILC_Uint8* pu8Buffer, WILC_Uint32 u32BufferLen, 
 									      tstrConnectRespInfo** ppstrConnectRespInfo);
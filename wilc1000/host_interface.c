@@ -506,6 +506,7 @@ typedef struct _tstrHostIFmsg
 	WILC_Uint16 u16MsgId;						/*!< Message ID */
 	tuniHostIFmsgBody uniHostIFmsgBody;		/*!< Message body */
 	void * drvHandler;
+	ktime_t tQueued;					/*!< when the message was first posted */
 }tstrHostIFmsg;
 
 #ifdef CONNECT_DIRECT
@@ -569,6 +570,88 @@ typedef enum
        SCAN_CONNECT_TIMER_FORCE_32BIT = 0xFFFFFFFF
 }tenuScanConnTimer;
 
+/*
+ * Priority lanes of the host interface thread, highest first. Messages
+ * keep their order within a lane; a lane may only overtake the ones below
+ * it, so anything that must follow another message goes in the same lane
+ * or in a lower one. Scan, connect and disconnect change the state the
+ * control and key messages act on: while one of them is queued, those are
+ * queued behind it in the connection lane instead of overtaking it.
+ */
+typedef enum
+{
+	HOST_IF_LANE_CONTROL = 0,	/* driver setup, cfg and queries */
+	HOST_IF_LANE_SECURITY,		/* key installs */
+	HOST_IF_LANE_CONNECTION,	/* scan/connect requests, their timers and firmware events */
+	HOST_IF_LANE_BACKGROUND,	/* scan results, queue idle and exit barriers */
+	HOST_IF_LANES
+}tenuHostIFLane;
+
+/* a waiting lane is served after being overtaken this many times */
+#define HOST_IF_LANE_STARVE_LIMIT	8
+/* message ids below this are timed, HOST_IF_MSG_EXIT is not */
+#define HOST_IF_MSG_STATS_IDS		(HOST_IF_MSG_SET_ANTENNA_MODE + 1)
+
+typedef struct
+{
+	WILC_Uint32 u32Count;
+	WILC_Uint64 u64QueuedUs;	/* total time spent waiting in the lane */
+	WILC_Uint32 u32QueuedMaxUs;
+	WILC_Uint64 u64HandledUs;	/* total time spent in the handler */
+	WILC_Uint32 u32HandledMaxUs;
+}tstrHostIFMsgStats;
+
+typedef struct
+{
+	WILC_Uint32 u32Dispatched;
+	WILC_Uint32 u32Starved;		/* dispatched by the starvation limit */
+	WILC_Uint32 u32MaxDepth;
+}tstrHostIFLaneStats;
+
+/* conditions a message can be parked on by hostIFthread */
+typedef enum
+{
+	HOST_IF_WAIT_INIT = 0,		/* g_wilc_initialized */
+	HOST_IF_WAIT_SCAN_DONE,		/* no scan running on the message's driver handle */
+	HOST_IF_WAIT_CONDS
+}tenuHostIFWaitCond;
+
+typedef struct _tstrHostIFDeferred
+{
+	tstrHostIFmsg strHostIFmsg;
+	struct _tstrHostIFDeferred* pstrNext;
+}tstrHostIFDeferred;
+
+typedef struct
+{
+	tstrHostIFDeferred* pstrHead;
+	tstrHostIFDeferred* pstrTail;
+	WILC_Uint32 u32Deferred;
+	WILC_Uint32 u32Released;
+}tstrHostIFWaitList;
+
+/*
+ * A hostIFthread and its lanes. Every driver handle gets its own, so a
+ * handler blocked on the firmware only holds up its own interface; the
+ * default worker takes the messages of no particular (or an unknown)
+ * handle. Handlers of different workers never run at the same time: they
+ * take turns on the arbiter, which is only let go while a worker waits
+ * for a config response, see host_int_arbiter_yield().
+ */
+#define HOST_IF_MAX_WORKERS		4
+
+typedef struct
+{
+	void* drvHandler;			/* WILC_NULL for the default worker */
+	WILC_ThreadHandle hThread;
+	WILC_MsgQueueHandle astrLaneQ[HOST_IF_LANES];
+	WILC_SemaphoreHandle hSemMsg;		/* counts the messages queued over all the lanes */
+	WILC_SemaphoreHandle hSemThreadEnd;
+	atomic_t astrLaneCount[HOST_IF_LANES];
+	WILC_Uint32 au32LaneSkipped[HOST_IF_LANES];	/* only touched by the worker */
+	tstrHostIFLaneStats astrLaneStats[HOST_IF_LANES];
+}tstrHostIFWorker;
+
 /*****************************************************************************/
 /*																			 */
 /*							Global Variabls	 								 */
@@ -576,65 +659,1506 @@ typedef enum
 /*****************************************************************************/
 
 
-tstrWILC_WFIDrv* terminated_handle=WILC_NULL;
-tstrWILC_WFIDrv* gWFiDrvHandle = WILC_NULL;
-#ifdef DISABLE_PWRSAVE_AND_SCAN_DURING_IP
-WILC_Bool g_obtainingIP=WILC_FALSE;
+tstrWILC_WFIDrv* terminated_handle=WILC_NULL;
+tstrWILC_WFIDrv* gWFiDrvHandle = WILC_NULL;
+#ifdef DISABLE_PWRSAVE_AND_SCAN_DURING_IP
+WILC_Bool g_obtainingIP=WILC_FALSE;
+#endif
+WILC_Uint8 P2P_LISTEN_STATE=0;
+static tstrHostIFWorker gstrHostIFWorker;
+/* per driver handle workers, looked up by drvHandler under the lock */
+static DEFINE_SPINLOCK(gHostIFWorkerLock);
+static tstrHostIFWorker* gapstrHostIFWorkers[HOST_IF_MAX_WORKERS];
+/* slots preallocated for each lane, deeper bursts spill to the heap */
+static const WILC_Uint32 gau32HostIFLaneDepth[HOST_IF_LANES] = {16, 16, 16, 64};
+/* serializes the handlers of all the workers */
+static WILC_SemaphoreHandle hSemHostIFArbiter;
+static struct task_struct* gpstrHostIFArbiterOwner;
+/* updated by the worker holding the arbiter */
+static tstrHostIFMsgStats gastrHostIFMsgStats[HOST_IF_MSG_STATS_IDS];
+/* messages parked until their condition holds, in posting order */
+static DEFINE_SPINLOCK(gHostIFWaitLock);
+static tstrHostIFWaitList gastrHostIFWaitList[HOST_IF_WAIT_CONDS];
+
+WILC_SemaphoreHandle hSemDeinitDrvHandle;
+/* answers to the messages of no particular driver handle */
+static WILC_SemaphoreHandle hWaitResponse;
+/* a Q_IDLE was handled by one of the workers */
+static WILC_SemaphoreHandle hSemQueueIdle;
+WILC_SemaphoreHandle hSemHostIntDeinit;
+WILC_TimerHandle g_hPeriodicRSSI;
+
+
+
+WILC_Uint8 gau8MulticastMacAddrList[WILC_MULTICAST_TABLE_SIZE][ETH_ALEN] = {{0}};
+
+static WILC_Uint8 host_int_msg_lane(WILC_Uint16 u16MsgId)
+{
+	switch(u16MsgId)
+	{
+		case HOST_IF_MSG_KEY:
+			return HOST_IF_LANE_SECURITY;
+
+		case HOST_IF_MSG_SCAN:
+		case HOST_IF_MSG_CONNECT:
+		case HOST_IF_MSG_DISCONNECT:
+		case HOST_IF_MSG_FLUSH_CONNECT:
+		case HOST_IF_MSG_RCVD_GNRL_ASYNC_INFO:
+		case HOST_IF_MSG_SCAN_TIMER_FIRED:
+		case HOST_IF_MSG_CONNECT_TIMER_FIRED:
+			return HOST_IF_LANE_CONNECTION;
+
+		/* scan complete has to follow the network info of its scan */
+		case HOST_IF_MSG_RCVD_NTWRK_INFO:
+		case HOST_IF_MSG_RCVD_SCAN_COMPLETE:
+		case HOST_IF_MSG_Q_IDLE:
+		case HOST_IF_MSG_EXIT:
+			return HOST_IF_LANE_BACKGROUND;
+
+		default:
+			return HOST_IF_LANE_CONTROL;
+	}
+}
+
+static WILC_Sint32 host_int_worker_queue_msg(tstrHostIFWorker* pstrWorker, tstrHostIFmsg* pstrHostIFmsg, WILC_Uint8 u8Lane)
+{
+	WILC_Sint32 s32Error;
+	WILC_Uint32 u32Depth;
+
+	s32Error = WILC_MsgQueueSend(&pstrWorker->astrLaneQ[u8Lane], pstrHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	if(s32Error != WILC_SUCCESS)
+	{
+		return s32Error;
+	}
+
+	u32Depth = atomic_inc_return(&pstrWorker->astrLaneCount[u8Lane]);
+	if(u32Depth > pstrWorker->astrLaneStats[u8Lane].u32MaxDepth)
+	{
+		pstrWorker->astrLaneStats[u8Lane].u32MaxDepth = u32Depth;
+	}
+	WILC_SemaphoreRelease(&pstrWorker->hSemMsg, WILC_NULL);
+
+	return WILC_SUCCESS;
+}
+
+/* Must be called with gHostIFWorkerLock held */
+static tstrHostIFWorker* host_int_worker_find(void* drvHandler)
+{
+	WILC_Uint8 i;
+
+	if(drvHandler == WILC_NULL)
+	{
+		return &gstrHostIFWorker;
+	}
+
+	for(i = 0; i < HOST_IF_MAX_WORKERS; i++)
+	{
+		if((gapstrHostIFWorkers[i] != WILC_NULL) && (gapstrHostIFWorkers[i]->drvHandler == drvHandler))
+		{
+			return gapstrHostIFWorkers[i];
+		}
+	}
+
+	return &gstrHostIFWorker;
+}
+
+static WILC_Sint32 host_int_queue_msg(tstrHostIFmsg* pstrHostIFmsg, WILC_Uint8 u8Lane)
+{
+	tstrHostIFWorker* pstrWorker;
+	WILC_Sint32 s32Error;
+	unsigned long flags;
+
+	/* the lock keeps the worker from being torn down under us */
+	spin_lock_irqsave(&gHostIFWorkerLock, flags);
+	pstrWorker = host_int_worker_find(pstrHostIFmsg->drvHandler);
+	/* a key or a cfg change must not land before a connection state change
+	   that was asked for first. Only the worker lowers the count, once the
+	   message is taken, so at worst this keeps the order needlessly */
+	if(u8Lane < HOST_IF_LANE_CONNECTION && atomic_read(&pstrWorker->astrLaneCount[HOST_IF_LANE_CONNECTION]) > 0)
+	{
+		u8Lane = HOST_IF_LANE_CONNECTION;
+	}
+	s32Error = host_int_worker_queue_msg(pstrWorker, pstrHostIFmsg, u8Lane);
+	spin_unlock_irqrestore(&gHostIFWorkerLock, flags);
+
+	return s32Error;
+}
+
+/**
+*  @brief host_int_post_msg
+*  @details 	   Queues a message for the worker of its driver handle, in
+				the lane of its type
+*  @param[in]    tstrHostIFmsg* pstrHostIFmsg
+*  @return 	    Error code.
+*  @author	
+*  @date	
+*  @version	1.0
+*/
+static WILC_Sint32 host_int_post_msg(tstrHostIFmsg* pstrHostIFmsg)
+{
+	pstrHostIFmsg->tQueued = ktime_get();
+	return host_int_queue_msg(pstrHostIFmsg, host_int_msg_lane(pstrHostIFmsg->u16MsgId));
+}
+
+/*
+ * Semaphore a handler releases once its answer is ready. Each driver
+ * handle has its own, the workers of two handles may answer at the same
+ * time; the answers of a handle come in order from its own worker.
+ */
+static WILC_SemaphoreHandle* host_int_response_sem(void* drvHandler)
+{
+	if(drvHandler == WILC_NULL)
+	{
+		return &hWaitResponse;
+	}
+	return &((tstrWILC_WFIDrv*)drvHandler)->hSemWaitResponse;
+}
+
+/* Highest non-empty lane, unless a lower one has been overtaken too often */
+static WILC_Uint8 host_int_pick_lane(tstrHostIFWorker* pstrWorker)
+{
+	WILC_Sint8 s8Lane;
+	WILC_Uint8 u8Pick = HOST_IF_LANES;
+	WILC_Bool bStarved = WILC_FALSE;
+
+	for(s8Lane = HOST_IF_LANES - 1; s8Lane >= 0; s8Lane--)
+	{
+		if(atomic_read(&pstrWorker->astrLaneCount[s8Lane]) == 0)
+		{
+			continue;
+		}
+		if(pstrWorker->au32LaneSkipped[s8Lane] >= HOST_IF_LANE_STARVE_LIMIT)
+		{
+			u8Pick = s8Lane;
+			bStarved = WILC_TRUE;
+			break;
+		}
+	}
+
+	if(u8Pick == HOST_IF_LANES)
+	{
+		for(s8Lane = 0; s8Lane < HOST_IF_LANES; s8Lane++)
+		{
+			if(atomic_read(&pstrWorker->astrLaneCount[s8Lane]) > 0)
+			{
+				u8Pick = s8Lane;
+				break;
+			}
+		}
+	}
+
+	if(u8Pick == HOST_IF_LANES)
+	{
+		return HOST_IF_LANES;
+	}
+
+	/* lanes below the picked one that have work were overtaken */
+	for(s8Lane = u8Pick + 1; s8Lane < HOST_IF_LANES; s8Lane++)
+	{
+		if(atomic_read(&pstrWorker->astrLaneCount[s8Lane]) > 0)
+		{
+			pstrWorker->au32LaneSkipped[s8Lane]++;
+		}
+	}
+	pstrWorker->au32LaneSkipped[u8Pick] = 0;
+	pstrWorker->astrLaneStats[u8Pick].u32Dispatched++;
+	if(bStarved)
+	{
+		pstrWorker->astrLaneStats[u8Pick].u32Starved++;
+	}
+
+	return u8Pick;
+}
+
+static WILC_Sint32 host_int_recv_msg(tstrHostIFWorker* pstrWorker, tstrHostIFmsg* pstrHostIFmsg)
+{
+	WILC_Sint32 s32Error;
+	WILC_Uint32 u32Ret;
+	WILC_Uint8 u8Lane;
+
+	s32Error = WILC_SemaphoreAcquire(&pstrWorker->hSemMsg, WILC_NULL);
+	if(s32Error != WILC_SUCCESS)
+	{
+		return s32Error;
+	}
+
+	u8Lane = host_int_pick_lane(pstrWorker);
+	if(u8Lane == HOST_IF_LANES)
+	{
+		return WILC_FAIL;
+	}
+
+	/* the lane's count is only raised once its message is queued, so
+	   this doesn't block */
+	s32Error = WILC_MsgQueueRecv(&pstrWorker->astrLaneQ[u8Lane], pstrHostIFmsg, sizeof(tstrHostIFmsg), &u32Ret, WILC_NULL);
+	atomic_dec(&pstrWorker->astrLaneCount[u8Lane]);
+
+	return s32Error;
+}
+
+static void host_int_arbiter_acquire(void)
+{
+	WILC_SemaphoreAcquire(&hSemHostIFArbiter, WILC_NULL);
+	gpstrHostIFArbiterOwner = current;
+}
+
+static void host_int_arbiter_release(void)
+{
+	gpstrHostIFArbiterOwner = WILC_NULL;
+	WILC_SemaphoreRelease(&hSemHostIFArbiter, WILC_NULL);
+}
+
+/**
+*  @brief host_int_arbiter_yield
+*  @details 	   Lets the other workers run their handlers while the
+				caller waits for the firmware. Called by SendConfigPkt()
+				around the wait, the caller must not touch host interface
+				state until host_int_arbiter_resume().
+*  @return 	    WILC_TRUE if the caller held the arbiter and has to resume
+*  @author	
+*  @date	
+*  @version	1.0
+*/
+WILC_Bool host_int_arbiter_yield(void)
+{
+	if(gpstrHostIFArbiterOwner != current)
+	{
+		return WILC_FALSE;
+	}
+
+	host_int_arbiter_release();
+	return WILC_TRUE;
+}
+
+void host_int_arbiter_resume(void)
+{
+	host_int_arbiter_acquire();
+}
+
+static WILC_Bool host_int_wait_cond_met(tenuHostIFWaitCond enuCond, void* drvHandler)
+{
+	tstrWILC_WFIDrv* pstrWFIDrv = (tstrWILC_WFIDrv*)drvHandler;
+
+	if(enuCond == HOST_IF_WAIT_INIT)
+	{
+		return g_wilc_initialized ? WILC_TRUE : WILC_FALSE;
+	}
+
+	return ((pstrWFIDrv == WILC_NULL) || (pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult == NULL)) ? WILC_TRUE : WILC_FALSE;
+}
+
+/**
+*  @brief host_int_defer_msg
+*  @details 	   Parks a message until enuCond holds, instead of requeueing
+				it over and over. The condition is checked again under the
+				lock, so a release racing with this call isn't missed.
+*  @param[in]    tstrHostIFmsg* pstrHostIFmsg, tenuHostIFWaitCond enuCond
+*  @return 	    WILC_TRUE if the message was taken, WILC_FALSE if the
+				condition already holds and it should be handled now
+*  @author	
+*  @date	
+*  @version	1.0
+*/
+static WILC_Bool host_int_defer_msg(tstrHostIFmsg* pstrHostIFmsg, tenuHostIFWaitCond enuCond)
+{
+	tstrHostIFWaitList* pstrList = &gastrHostIFWaitList[enuCond];
+	tstrHostIFDeferred* pstrDeferred;
+	unsigned long flags;
+
+	pstrDeferred = (tstrHostIFDeferred*)WILC_MALLOC(sizeof(tstrHostIFDeferred));
+	if(pstrDeferred == WILC_NULL)
+	{
+		/* out of memory, fall back to requeueing behind the rest */
+		WILC_Sleep(2);
+		host_int_queue_msg(pstrHostIFmsg, HOST_IF_LANE_BACKGROUND);
+		return WILC_TRUE;
+	}
+	WILC_memcpy(&pstrDeferred->strHostIFmsg, pstrHostIFmsg, sizeof(tstrHostIFmsg));
+	pstrDeferred->pstrNext = WILC_NULL;
+
+	spin_lock_irqsave(&gHostIFWaitLock, flags);
+	if(host_int_wait_cond_met(enuCond, pstrHostIFmsg->drvHandler))
+	{
+		spin_unlock_irqrestore(&gHostIFWaitLock, flags);
+		WILC_FREE(pstrDeferred);
+		return WILC_FALSE;
+	}
+
+	if(pstrList->pstrTail == WILC_NULL)
+	{
+		pstrList->pstrHead = pstrDeferred;
+	}
+	else
+	{
+		pstrList->pstrTail->pstrNext = pstrDeferred;
+	}
+	pstrList->pstrTail = pstrDeferred;
+	pstrList->u32Deferred++;
+	spin_unlock_irqrestore(&gHostIFWaitLock, flags);
+
+	return WILC_TRUE;
+}
+
+/* Requeues, in order, the parked messages whose condition now holds */
+static void host_int_release_deferred(tenuHostIFWaitCond enuCond)
+{
+	tstrHostIFWaitList* pstrList = &gastrHostIFWaitList[enuCond];
+	tstrHostIFDeferred* pstrDeferred;
+	tstrHostIFDeferred* pstrPrev = WILC_NULL;
+	tstrHostIFDeferred* pstrReady = WILC_NULL;
+	tstrHostIFDeferred* pstrReadyTail = WILC_NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&gHostIFWaitLock, flags);
+	pstrDeferred = pstrList->pstrHead;
+	while(pstrDeferred != WILC_NULL)
+	{
+		tstrHostIFDeferred* pstrNext = pstrDeferred->pstrNext;
+
+		if(!host_int_wait_cond_met(enuCond, pstrDeferred->strHostIFmsg.drvHandler))
+		{
+			pstrPrev = pstrDeferred;
+			pstrDeferred = pstrNext;
+			continue;
+		}
+
+		/* unlink it and move it to the ready list */
+		if(pstrPrev == WILC_NULL)
+		{
+			pstrList->pstrHead = pstrNext;
+		}
+		else
+		{
+			pstrPrev->pstrNext = pstrNext;
+		}
+		if(pstrList->pstrTail == pstrDeferred)
+		{
+			pstrList->pstrTail = pstrPrev;
+		}
+
+		pstrDeferred->pstrNext = WILC_NULL;
+		if(pstrReadyTail == WILC_NULL)
+		{
+			pstrReady = pstrDeferred;
+		}
+		else
+		{
+			pstrReadyTail->pstrNext = pstrDeferred;
+		}
+		pstrReadyTail = pstrDeferred;
+		pstrList->u32Released++;
+
+		pstrDeferred = pstrNext;
+	}
+	spin_unlock_irqrestore(&gHostIFWaitLock, flags);
+
+	while(pstrReady != WILC_NULL)
+	{
+		pstrDeferred = pstrReady;
+		pstrReady = pstrReady->pstrNext;
+
+		PRINT_D(HOSTINF_DBG, "Releasing deferred msg %d\n", pstrDeferred->strHostIFmsg.u16MsgId);
+		host_int_queue_msg(&pstrDeferred->strHostIFmsg, host_int_msg_lane(pstrDeferred->strHostIFmsg.u16MsgId));
+		WILC_FREE(pstrDeferred);
+	}
+}
+
+static void host_int_set_initialized(WILC_Uint8 u8Initialized)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&gHostIFWaitLock, flags);
+	g_wilc_initialized = u8Initialized;
+	spin_unlock_irqrestore(&gHostIFWaitLock, flags);
+
+	if(u8Initialized)
+	{
+		host_int_release_deferred(HOST_IF_WAIT_INIT);
+	}
+}
+
+static void host_int_msg_stats_update(tstrHostIFmsg* pstrHostIFmsg, ktime_t tStart)
+{
+	tstrHostIFMsgStats* pstrStats;
+	WILC_Uint32 u32QueuedUs, u32HandledUs;
+
+	if(pstrHostIFmsg->u16MsgId >= HOST_IF_MSG_STATS_IDS)
+	{
+		return;
+	}
+
+	pstrStats = &gastrHostIFMsgStats[pstrHostIFmsg->u16MsgId];
+	u32QueuedUs = (WILC_Uint32)ktime_us_delta(tStart, pstrHostIFmsg->tQueued);
+	u32HandledUs = (WILC_Uint32)ktime_us_delta(ktime_get(), tStart);
+
+	pstrStats->u32Count++;
+	pstrStats->u64QueuedUs += u32QueuedUs;
+	pstrStats->u64HandledUs += u32HandledUs;
+	if(u32QueuedUs > pstrStats->u32QueuedMaxUs)
+	{
+		pstrStats->u32QueuedMaxUs = u32QueuedUs;
+	}
+	if(u32HandledUs > pstrStats->u32HandledMaxUs)
+	{
+		pstrStats->u32HandledMaxUs = u32HandledUs;
+	}
+}
+
+static void hostIFthread(void* pvArg);
+
+static WILC_Sint32 host_int_worker_create(tstrHostIFWorker* pstrWorker, void* drvHandler)
+{
+	WILC_Sint32 s32Error = WILC_SUCCESS;
+	tstrWILC_MsgQueueAttrs strMsgQueueAttrs;
+	tstrWILC_SemaphoreAttrs strSemaphoreAttrs;
+	WILC_Sint8 s8Lane;
+
+	WILC_memset(pstrWorker, 0, sizeof(tstrHostIFWorker));
+	pstrWorker->drvHandler = drvHandler;
+
+	WILC_SemaphoreFillDefault(&strSemaphoreAttrs);
+	strSemaphoreAttrs.u32InitCount = 0;
+	WILC_SemaphoreCreate(&pstrWorker->hSemMsg, &strSemaphoreAttrs);
+	WILC_SemaphoreCreate(&pstrWorker->hSemThreadEnd, &strSemaphoreAttrs);
+
+	for(s8Lane = 0; s8Lane < HOST_IF_LANES; s8Lane++)
+	{
+		WILC_MsgQueueFillDefault(&strMsgQueueAttrs);
+		strMsgQueueAttrs.u32MaxMsgSize = sizeof(tstrHostIFmsg);
+		strMsgQueueAttrs.u32MaxMsgs = gau32HostIFLaneDepth[s8Lane];
+		s32Error = WILC_MsgQueueCreate(&pstrWorker->astrLaneQ[s8Lane], &strMsgQueueAttrs);
+		if(s32Error < 0)
+		{
+			break;
+		}
+		atomic_set(&pstrWorker->astrLaneCount[s8Lane], 0);
+	}
+
+	if(s32Error < 0)
+	{
+		while(--s8Lane >= 0)
+		{
+			WILC_MsgQueueDestroy(&pstrWorker->astrLaneQ[s8Lane], WILC_NULL);
+		}
+		WILC_SemaphoreDestroy(&pstrWorker->hSemMsg, WILC_NULL);
+		WILC_SemaphoreDestroy(&pstrWorker->hSemThreadEnd, WILC_NULL);
+		return s32Error;
+	}
+
+	s32Error = WILC_ThreadCreate(&pstrWorker->hThread, hostIFthread, pstrWorker, WILC_NULL);
+	if(s32Error < 0)
+	{
+		for(s8Lane = 0; s8Lane < HOST_IF_LANES; s8Lane++)
+		{
+			WILC_MsgQueueDestroy(&pstrWorker->astrLaneQ[s8Lane], WILC_NULL);
+		}
+		WILC_SemaphoreDestroy(&pstrWorker->hSemMsg, WILC_NULL);
+		WILC_SemaphoreDestroy(&pstrWorker->hSemThreadEnd, WILC_NULL);
+	}
+
+	return s32Error;
+}
+
+/* Lets the worker finish what it has queued, then frees its lanes */
+static void host_int_worker_destroy(tstrHostIFWorker* pstrWorker)
+{
+	tstrHostIFmsg strHostIFmsg;
+	WILC_Uint8 u8Lane;
+
+	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
+	strHostIFmsg.u16MsgId = HOST_IF_MSG_EXIT;
+	strHostIFmsg.drvHandler = pstrWorker->drvHandler;
+
+	if(host_int_worker_queue_msg(pstrWorker, &strHostIFmsg, host_int_msg_lane(HOST_IF_MSG_EXIT)) != WILC_SUCCESS)
+	{
+		PRINT_ER("Error in sending deinit's message queue message function\n");
+	}
+	else
+	{
+		WILC_SemaphoreAcquire(&pstrWorker->hSemThreadEnd, NULL);
+	}
+
+	for(u8Lane = 0; u8Lane < HOST_IF_LANES; u8Lane++)
+	{
+		WILC_MsgQueueDestroy(&pstrWorker->astrLaneQ[u8Lane], WILC_NULL);
+	}
+	WILC_SemaphoreDestroy(&pstrWorker->hSemMsg, WILC_NULL);
+	WILC_SemaphoreDestroy(&pstrWorker->hSemThreadEnd, WILC_NULL);
+}
+
+/* Gives drvHandler a worker of its own, it stays on the default one if that fails */
+static void host_int_worker_start(void* drvHandler)
+{
+	tstrHostIFWorker* pstrWorker;
+	unsigned long flags;
+	WILC_Uint8 i;
+
+	pstrWorker = (tstrHostIFWorker*)WILC_MALLOC(sizeof(tstrHostIFWorker));
+	if(pstrWorker == WILC_NULL)
+	{
+		PRINT_ER("No worker for handle %p, using the default one\n", drvHandler);
+		return;
+	}
+
+	if(host_int_worker_create(pstrWorker, drvHandler) < 0)
+	{
+		PRINT_ER("No worker for handle %p, using the default one\n", drvHandler);
+		WILC_FREE(pstrWorker);
+		return;
+	}
+
+	spin_lock_irqsave(&gHostIFWorkerLock, flags);
+	for(i = 0; i < HOST_IF_MAX_WORKERS; i++)
+	{
+		if(gapstrHostIFWorkers[i] == WILC_NULL)
+		{
+			gapstrHostIFWorkers[i] = pstrWorker;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&gHostIFWorkerLock, flags);
+
+	if(i == HOST_IF_MAX_WORKERS)
+	{
+		PRINT_ER("No worker slot for handle %p, using the default one\n", drvHandler);
+		host_int_worker_destroy(pstrWorker);
+		WILC_FREE(pstrWorker);
+	}
+}
+
+/* Messages for drvHandler posted from now on go to the default worker */
+static void host_int_worker_stop(void* drvHandler)
+{
+	tstrHostIFWorker* pstrWorker = WILC_NULL;
+	unsigned long flags;
+	WILC_Uint8 i;
+
+	spin_lock_irqsave(&gHostIFWorkerLock, flags);
+	for(i = 0; i < HOST_IF_MAX_WORKERS; i++)
+	{
+		if((gapstrHostIFWorkers[i] != WILC_NULL) && (gapstrHostIFWorkers[i]->drvHandler == drvHandler))
+		{
+			pstrWorker = gapstrHostIFWorkers[i];
+			gapstrHostIFWorkers[i] = WILC_NULL;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&gHostIFWorkerLock, flags);
+
+	if(pstrWorker != WILC_NULL)
+	{
+		host_int_worker_destroy(pstrWorker);
+		WILC_FREE(pstrWorker);
+	}
+}
+
+/* The default worker and everything shared by the workers */
+static WILC_Sint32 host_int_create_msg_queues(void)
+{
+	tstrWILC_SemaphoreAttrs strSemaphoreAttrs;
+	WILC_Sint32 s32Error;
+
+	WILC_memset(gapstrHostIFWorkers, 0, sizeof(gapstrHostIFWorkers));
+
+	WILC_SemaphoreFillDefault(&strSemaphoreAttrs);
+	strSemaphoreAttrs.u32InitCount = 1;
+	WILC_SemaphoreCreate(&hSemHostIFArbiter, &strSemaphoreAttrs);
+	gpstrHostIFArbiterOwner = WILC_NULL;
+
+	WILC_memset(gastrHostIFWaitList, 0, sizeof(gastrHostIFWaitList));
+
+	strSemaphoreAttrs.u32InitCount = 0;
+	WILC_SemaphoreCreate(&hSemQueueIdle, &strSemaphoreAttrs);
+
+	s32Error = host_int_worker_create(&gstrHostIFWorker, WILC_NULL);
+	if(s32Error < 0)
+	{
+		WILC_SemaphoreDestroy(&hSemQueueIdle, WILC_NULL);
+		WILC_SemaphoreDestroy(&hSemHostIFArbiter, WILC_NULL);
+	}
+
+	return s32Error;
+}
+
+static void host_int_destroy_msg_queues(void)
+{
+	WILC_Uint8 u8Cond;
+	tstrHostIFDeferred* pstrDeferred;
+
+	host_int_worker_destroy(&gstrHostIFWorker);
+
+	/* the workers are gone, drop whatever is still parked */
+	for(u8Cond = 0; u8Cond < HOST_IF_WAIT_CONDS; u8Cond++)
+	{
+		while(gastrHostIFWaitList[u8Cond].pstrHead != WILC_NULL)
+		{
+			pstrDeferred = gastrHostIFWaitList[u8Cond].pstrHead;
+			gastrHostIFWaitList[u8Cond].pstrHead = pstrDeferred->pstrNext;
+			PRINT_D(HOSTINF_DBG, "Dropping deferred msg %d\n", pstrDeferred->strHostIFmsg.u16MsgId);
+			WILC_FREE(pstrDeferred);
+		}
+		gastrHostIFWaitList[u8Cond].pstrTail = WILC_NULL;
+	}
+
+	WILC_SemaphoreDestroy(&hSemQueueIdle, WILC_NULL);
+	WILC_SemaphoreDestroy(&hSemHostIFArbiter, WILC_NULL);
+}
+
+#if defined (WILC_DEBUGFS)
+int host_int_dump_msg_stats(char *buf, int size)
+{
+	static const char* apcLanes[HOST_IF_LANES] = {"control", "security", "connection", "background"};
+	tstrHostIFMsgStats* pstrStats;
+	tstrHostIFWorker* pstrWorker;
+	unsigned long flags;
+	int i, w, len = 0;
+
+	/* the lock keeps the workers around while they are printed */
+	spin_lock_irqsave(&gHostIFWorkerLock, flags);
+	for(w = -1; w < HOST_IF_MAX_WORKERS; w++)
+	{
+		pstrWorker = (w < 0) ? &gstrHostIFWorker : gapstrHostIFWorkers[w];
+		if(pstrWorker == WILC_NULL)
+		{
+			continue;
+		}
+
+		len += scnprintf(buf + len, size - len, "worker %p\n", pstrWorker->drvHandler);
+		len += scnprintf(buf + len, size - len, "%-12s %6s %10s %10s %10s\n",
+				"lane", "depth", "max_depth", "dispatched", "starved");
+		for(i = 0; i < HOST_IF_LANES; i++)
+		{
+			len += scnprintf(buf + len, size - len, "%-12s %6d %10u %10u %10u\n",
+					apcLanes[i], atomic_read(&pstrWorker->astrLaneCount[i]),
+					pstrWorker->astrLaneStats[i].u32MaxDepth, pstrWorker->astrLaneStats[i].u32Dispatched,
+					pstrWorker->astrLaneStats[i].u32Starved);
+		}
+		len += scnprintf(buf + len, size - len, "\n");
+	}
+	spin_unlock_irqrestore(&gHostIFWorkerLock, flags);
+
+	len += scnprintf(buf + len, size - len, "%-12s %10s %10s\n", "wait", "deferred", "released");
+	len += scnprintf(buf + len, size - len, "%-12s %10u %10u\n", "init",
+			gastrHostIFWaitList[HOST_IF_WAIT_INIT].u32Deferred, gastrHostIFWaitList[HOST_IF_WAIT_INIT].u32Released);
+	len += scnprintf(buf + len, size - len, "%-12s %10u %10u\n", "scan_done",
+			gastrHostIFWaitList[HOST_IF_WAIT_SCAN_DONE].u32Deferred, gastrHostIFWaitList[HOST_IF_WAIT_SCAN_DONE].u32Released);
+
+	len += scnprintf(buf + len, size - len, "\n%4s %10s %12s %12s %12s %12s\n",
+			"msg", "count", "queued_avg", "queued_max", "handled_avg", "handled_max");
+	for(i = 0; i < HOST_IF_MSG_STATS_IDS; i++)
+	{
+		pstrStats = &gastrHostIFMsgStats[i];
+		if(pstrStats->u32Count == 0)
+		{
+			continue;
+		}
+		len += scnprintf(buf + len, size - len, "%4d %10u %12llu %12u %12llu %12u\n",
+				i, pstrStats->u32Count,
+				div_u64(pstrStats->u64QueuedUs, pstrStats->u32Count), pstrStats->u32QueuedMaxUs,
+				div_u64(pstrStats->u64HandledUs, pstrStats->u32Count), pstrStats->u32HandledMaxUs);
+	}
+
+	return len;
+}
+
+/*
+ * Message queue benchmark, run each time wilc_bench_msgq is read: times
+ * send/receive pairs of host interface messages on a queue with a lane's
+ * ring and on one without a ring, where every message goes through the
+ * heap. Bursts deeper than the ring show the cost of spilling over.
+ */
+#define HOST_IF_BENCH_MSGS	4096
+
+static WILC_Uint32 host_int_bench_msg_queue_run(WILC_Uint32 u32Slots, WILC_Uint32 u32Burst,
+		tstrHostIFmsg* pstrMsg, WILC_Uint32* pu32Spilled)
+{
+	WILC_MsgQueueHandle strQueue;
+	tstrWILC_MsgQueueAttrs strAttrs;
+	WILC_Uint32 i, j, u32Sent, u32Len, u32Pairs = 0;
+	ktime_t tStart;
+	WILC_Uint64 u64Ns;
+
+	WILC_MsgQueueFillDefault(&strAttrs);
+	strAttrs.u32MaxMsgSize = sizeof(tstrHostIFmsg);
+	strAttrs.u32MaxMsgs = u32Slots;
+	if(WILC_MsgQueueCreate(&strQueue, &strAttrs) != WILC_SUCCESS)
+	{
+		return 0;
+	}
+
+	tStart = ktime_get();
+	for(i = 0; i < HOST_IF_BENCH_MSGS; i += u32Burst)
+	{
+		u32Sent = 0;
+		for(j = 0; j < u32Burst; j++)
+		{
+			if(WILC_MsgQueueSend(&strQueue, pstrMsg, sizeof(tstrHostIFmsg), WILC_NULL) == WILC_SUCCESS)
+			{
+				u32Sent++;
+			}
+		}
+		/* only what was queued, the receive would block otherwise */
+		for(j = 0; j < u32Sent; j++)
+		{
+			WILC_MsgQueueRecv(&strQueue, pstrMsg, sizeof(tstrHostIFmsg), &u32Len, WILC_NULL);
+		}
+		u32Pairs += u32Sent;
+	}
+	u64Ns = (WILC_Uint64)ktime_to_ns(ktime_sub(ktime_get(), tStart));
+
+	*pu32Spilled = strQueue.u32Overflows;
+	WILC_MsgQueueDestroy(&strQueue, WILC_NULL);
+
+	return (u32Pairs == 0) ? 0 : (WILC_Uint32)div_u64(u64Ns, u32Pairs);
+}
+
+int host_int_bench_msg_queue(char *buf, int size)
+{
+	static const WILC_Uint32 au32Bursts[] = {1, 16, 64};
+	tstrHostIFmsg* pstrMsg;
+	WILC_Uint32 u32Ns, u32Spilled;
+	int i, len = 0;
+
+	pstrMsg = (tstrHostIFmsg*)WILC_MALLOC(sizeof(tstrHostIFmsg));
+	if(pstrMsg == WILC_NULL)
+	{
+		return scnprintf(buf, size, "out of memory\n");
+	}
+	WILC_memset(pstrMsg, 0, sizeof(tstrHostIFmsg));
+
+	len += scnprintf(buf + len, size - len, "%u messages of %u bytes\n",
+			HOST_IF_BENCH_MSGS, (WILC_Uint32)sizeof(tstrHostIFmsg));
+	len += scnprintf(buf + len, size - len, "%-10s %6s %10s %10s\n", "queue", "burst", "ns/pair", "spilled");
+	for(i = 0; i < ARRAY_SIZE(au32Bursts); i++)
+	{
+		u32Ns = host_int_bench_msg_queue_run(gau32HostIFLaneDepth[HOST_IF_LANE_CONTROL], au32Bursts[i], pstrMsg, &u32Spilled);
+		len += scnprintf(buf + len, size - len, "ring(%-2u)   %6u %10u %10u\n",
+				gau32HostIFLaneDepth[HOST_IF_LANE_CONTROL], au32Bursts[i], u32Ns, u32Spilled);
+	}
+	for(i = 0; i < ARRAY_SIZE(au32Bursts); i++)
+	{
+		u32Ns = host_int_bench_msg_queue_run(0, au32Bursts[i], pstrMsg, &u32Spilled);
+		len += scnprintf(buf + len, size - len, "%-10s %6u %10u %10u\n",
+				"heap", au32Bursts[i], u32Ns, u32Spilled);
+	}
+
+	WILC_FREE(pstrMsg);
+
+	return len;
+}
+#endif
+
+#ifndef CONNECT_DIRECT
+static WILC_Uint8 gapu8RcvdSurveyResults[2][MAX_SURVEY_RESULT_FRAG_SIZE];
+#endif
+
+static WILC_Uint8 gapu8RcvdAssocResp[MAX_ASSOC_RESP_FRAME_SIZE];
+
+WILC_Bool gbScanWhileConnected = WILC_FALSE;
+
+static tstrWidCacheStats gastrWidCacheStats[WID_CACHE_ENTRIES];
+static WILC_Uint8 gs8SetIP[2][4] = {{0}};
+static WILC_Uint8 gs8GetIP[2][4] = {{0}};
+#ifdef WILC_AP_EXTERNAL_MLME
+static WILC_Uint8 gu8DelBcn = 0;
+#endif
+#ifndef SIMULATION
+static WILC_Uint32 gu32WidConnRstHack = 0;
+#endif
+
+/*BugID_5137*/
+WILC_Uint8* gu8FlushedJoinReq = NULL;
+WILC_Uint8* gu8FlushedInfoElemAsoc = NULL;
+WILC_Uint8 gu8Flushed11iMode;
+WILC_Uint8 gu8FlushedAuthType;
+WILC_Uint32 gu32FlushedJoinReqSize;
+WILC_Uint32 gu32FlushedInfoElemAsocSize;
+WILC_Uint32 gu8FlushedJoinReqDrvHandler = 0;
+#define REAL_JOIN_REQ 0
+#define FLUSHED_JOIN_REQ 1
+#define FLUSHED_BYTE_POS 79	//Position the byte indicating flushing in the flushed request
+
+/*Bug4218: Parsing Join Param*/
+#ifdef WILC_PARSE_SCAN_IN_HOST	
+/*Bug4218: Parsing Join Param*/
+static void* host_int_ParseJoinBssParam(tstrNetworkInfo* ptstrNetworkInfo);
+#endif /*WILC_PARSE_SCAN_IN_HOST*/
+
+extern void chip_sleep_manually(WILC_Uint32 u32SleepTime);
+static void host_int_wid_cache_invalidate(tstrWILC_WFIDrv* pstrWFIDrv);
+
+/**
+*  @brief WID shadow
+*  @details 	Config writes made through host_int_set_cfg_shadowed() skip the
+		WIDs whose value matches the last one written to the same
+		driver handle. Bumping the generation drops every shadow, the
+		next write of each WID goes to the chip again.
+*/
+static atomic_t gWidShadowGen = ATOMIC_INIT(1);
+static atomic_t gWidShadowWritten = ATOMIC_INIT(0);
+static atomic_t gWidShadowElided = ATOMIC_INIT(0);
+static atomic_t gWidShadowResyncs = ATOMIC_INIT(0);
+
+/*
+ * The firmware lost, or may have lost, what was written to it: it was
+ * restarted, the chip lost power, or an unacknowledged write failed.
+ */
+void host_int_wid_shadow_resync(void)
+{
+	atomic_inc(&gWidShadowGen);
+	atomic_inc(&gWidShadowResyncs);
+}
+
+/* Called with pstrShadow->lock held */
+static tstrWidShadowEntry* host_int_wid_shadow_find(tstrWidShadow* pstrShadow, WILC_Uint16 u16WIDid)
+{
+	int i;
+
+	for(i = 0; i < pstrShadow->u8Entries; i++)
+	{
+		if(pstrShadow->astrEntry[i].u16WIDid == u16WIDid)
+			return &pstrShadow->astrEntry[i];
+	}
+	return NULL;
+}
+
+/* Called with pstrShadow->lock held */
+static void host_int_wid_shadow_forget(tstrWidShadow* pstrShadow, WILC_Uint16 u16WIDid)
+{
+	tstrWidShadowEntry* pstrEntry = host_int_wid_shadow_find(pstrShadow, u16WIDid);
+
+	if(pstrEntry != NULL)
+		*pstrEntry = pstrShadow->astrEntry[--pstrShadow->u8Entries];
+}
+
+/* Called with pstrShadow->lock held */
+static void host_int_wid_shadow_store(tstrWidShadow* pstrShadow, tstrWID* pstrWID)
+{
+	tstrWidShadowEntry* pstrEntry;
+
+	if(pstrWID->s32ValueSize <= 0 || pstrWID->s32ValueSize > WID_SHADOW_VAL_MAX)
+	{
+		host_int_wid_shadow_forget(pstrShadow, pstrWID->u16WIDid);
+		return;
+	}
+
+	pstrEntry = host_int_wid_shadow_find(pstrShadow, pstrWID->u16WIDid);
+	if(pstrEntry == NULL)
+	{
+		if(pstrShadow->u8Entries == WID_SHADOW_ENTRIES)
+			return;
+		pstrEntry = &pstrShadow->astrEntry[pstrShadow->u8Entries++];
+		pstrEntry->u16WIDid = pstrWID->u16WIDid;
+	}
+	pstrEntry->u16Size = (WILC_Uint16)pstrWID->s32ValueSize;
+	WILC_memcpy(pstrEntry->au8Val, pstrWID->ps8WidVal, pstrWID->s32ValueSize);
+}
+
+/*
+ * Every SET goes through here from SendConfigPkt()/SendConfigPktAsync()
+ * before it is sent: what the shadow holds for those WIDs is no longer
+ * known to be in the firmware. WIDs written outside
+ * host_int_set_cfg_shadowed() (the connect WID lists, beacons, ...) are
+ * thereby never elided on a stale value.
+ */
+void host_int_wid_shadow_sent(WILC_Uint32 drvHandler, tstrWID* pstrWIDs, WILC_Uint32 u32WIDsCount)
+{
+	tstrWILC_WFIDrv* pstrWFIDrv = (tstrWILC_WFIDrv*)drvHandler;
+	unsigned long flags;
+	WILC_Uint32 i;
+
+	if(pstrWFIDrv == NULL)
+		return;
+
+	spin_lock_irqsave(&pstrWFIDrv->strWidShadow.lock, flags);
+	for(i = 0; i < u32WIDsCount; i++)
+		host_int_wid_shadow_forget(&pstrWFIDrv->strWidShadow, pstrWIDs[i].u16WIDid);
+	spin_unlock_irqrestore(&pstrWFIDrv->strWidShadow.lock, flags);
+}
+
+/*
+ * Drop the WIDs whose value matches the shadow, compacting pstrWIDs in
+ * place. Returns the number of WIDs left to send.
+ */
+static WILC_Uint32 host_int_wid_shadow_elide(tstrWILC_WFIDrv* pstrWFIDrv, tstrWID* pstrWIDs,
+		WILC_Uint32 u32WIDsCount)
+{
+	tstrWidShadow* pstrShadow = &pstrWFIDrv->strWidShadow;
+	tstrWidShadowEntry* pstrEntry;
+	WILC_Uint32 u32Gen = (WILC_Uint32)atomic_read(&gWidShadowGen);
+	WILC_Uint32 i, u32Send = 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pstrShadow->lock, flags);
+	if(pstrShadow->u32Gen != u32Gen)
+	{
+		pstrShadow->u8Entries = 0;
+		pstrShadow->u32Gen = u32Gen;
+	}
+
+	for(i = 0; i < u32WIDsCount; i++)
+	{
+		pstrEntry = host_int_wid_shadow_find(pstrShadow, pstrWIDs[i].u16WIDid);
+		if(pstrEntry != NULL && pstrEntry->u16Size == pstrWIDs[i].s32ValueSize &&
+		   WILC_memcmp(pstrEntry->au8Val, pstrWIDs[i].ps8WidVal, pstrEntry->u16Size) == 0)
+		{
+			PRINT_D(HOSTINF_DBG,"WID %x unchanged, not sent\n",pstrWIDs[i].u16WIDid);
+			atomic_inc(&gWidShadowElided);
+			continue;
+		}
+		pstrWIDs[u32Send++] = pstrWIDs[i];
+	}
+	spin_unlock_irqrestore(&pstrShadow->lock, flags);
+
+	return u32Send;
+}
+
+/*
+ * Send the WIDs whose value differs from the shadow and record what was
+ * written. pstrWIDs is compacted in place. SendConfigPkt() waits for the
+ * firmware to answer, so a value is only recorded once it was accepted;
+ * a write that fails or times out leaves the WID out of the shadow.
+ */
+static WILC_Sint32 host_int_set_cfg_shadowed(tstrWILC_WFIDrv* pstrWFIDrv, tstrWID* pstrWIDs,
+		WILC_Uint32 u32WIDsCount, WILC_Bool bRespRequired)
+{
+	tstrWidShadow* pstrShadow = &pstrWFIDrv->strWidShadow;
+	WILC_Uint32 i, u32Send, u32Gen;
+	WILC_Sint32 s32Error;
+	unsigned long flags;
+
+	u32Send = host_int_wid_shadow_elide(pstrWFIDrv, pstrWIDs, u32WIDsCount);
+	if(u32Send == 0)
+		return WILC_SUCCESS;
+
+	u32Gen = (WILC_Uint32)atomic_read(&gWidShadowGen);
+	s32Error = SendConfigPkt(SET_CFG, pstrWIDs, u32Send, bRespRequired,(WILC_Uint32)pstrWFIDrv);
+	atomic_add(u32Send, &gWidShadowWritten);
+	if(s32Error)
+		return s32Error;
+
+	spin_lock_irqsave(&pstrShadow->lock, flags);
+	/* a firmware restart while the write was in flight drops it as well */
+	if(pstrShadow->u32Gen == u32Gen && (WILC_Uint32)atomic_read(&gWidShadowGen) == u32Gen)
+	{
+		for(i = 0; i < u32Send; i++)
+			host_int_wid_shadow_store(pstrShadow, &pstrWIDs[i]);
+	}
+	spin_unlock_irqrestore(&pstrShadow->lock, flags);
+
+	return s32Error;
+}
+
+#if defined (WILC_DEBUGFS)
+int host_int_dump_wid_shadow_stats(char *buf, int size)
+{
+	return scnprintf(buf, size,
+			"wids written         %u\n"
+			"wids elided          %u\n"
+			"resyncs              %u\n",
+			atomic_read(&gWidShadowWritten), atomic_read(&gWidShadowElided),
+			atomic_read(&gWidShadowResyncs));
+}
 #endif
-WILC_Uint8 P2P_LISTEN_STATE=0;
-static WILC_ThreadHandle HostIFthreadHandler;
-static WILC_MsgQueueHandle gMsgQHostIF;
-static WILC_SemaphoreHandle hSemHostIFthrdEnd;
 
-WILC_SemaphoreHandle hSemDeinitDrvHandle;
-static WILC_SemaphoreHandle hWaitResponse;
-WILC_SemaphoreHandle hSemHostIntDeinit;
-WILC_TimerHandle g_hPeriodicRSSI;
+/*
+ * Connection trace: timestamped events of a connection attempt, from
+ * cfg80211 asking for it until the pairwise key is installed (or the
+ * attempt ends back in HOST_IF_IDLE). Nothing is recorded for a driver
+ * handle that has no connection being traced.
+ */
+#define CONN_TRACE_ENTRIES	256		/* power of 2 */
 
+typedef enum
+{
+	CONN_TRACE_START = 0,		/* WILC_WFI_CfgConnect() */
+	CONN_TRACE_STATE,		/* enuHostIFstate change, arg is the new state */
+	CONN_TRACE_CONNECT,		/* Handle_Connect() picked up */
+	CONN_TRACE_CFG_SEND,		/* SendConfigPkt(), arg is the mode */
+	CONN_TRACE_CFG_DONE,		/* SendConfigPkt() returned, arg is the result */
+	CONN_TRACE_ASYNC_RCVD,		/* async info from the firmware, arg is the mac status */
+	CONN_TRACE_ASYNC_HANDLED,	/* Handle_RcvdGnrlAsyncInfo() picked it up */
+	CONN_TRACE_RESULT,		/* connect result given to cfg80211, arg is the mac status */
+	CONN_TRACE_KEY,			/* Handle_Key() picked up, arg is the key type */
+	CONN_TRACE_KEY_DONE,
+	CONN_TRACE_END,
+	CONN_TRACE_EVENTS
+}tenuConnTraceEvent;
 
+typedef struct
+{
+	ktime_t tStamp;
+	void* drvHandler;
+	WILC_Uint32 u32ConnId;
+	WILC_Uint32 u32Arg;
+	WILC_Uint8 u8Event;
+}tstrConnTraceEntry;
+
+static DEFINE_SPINLOCK(gConnTraceLock);
+static tstrConnTraceEntry gastrConnTrace[CONN_TRACE_ENTRIES];
+static WILC_Uint32 gu32ConnTraceHead = 0;
+static WILC_Uint32 gu32ConnTraceLastId = 0;
+
+static void host_int_conn_trace_add(tstrWILC_WFIDrv* pstrWFIDrv, WILC_Uint32 u32ConnId,
+		WILC_Uint8 u8Event, WILC_Uint32 u32Arg)
+{
+	tstrConnTraceEntry* pstrEntry;
+	unsigned long flags;
+
+	spin_lock_irqsave(&gConnTraceLock, flags);
+	pstrEntry = &gastrConnTrace[gu32ConnTraceHead++ & (CONN_TRACE_ENTRIES - 1)];
+	pstrEntry->tStamp = ktime_get();
+	pstrEntry->drvHandler = pstrWFIDrv;
+	pstrEntry->u32ConnId = u32ConnId;
+	pstrEntry->u32Arg = u32Arg;
+	pstrEntry->u8Event = u8Event;
+	spin_unlock_irqrestore(&gConnTraceLock, flags);
+}
 
-WILC_Uint8 gau8MulticastMacAddrList[WILC_MULTICAST_TABLE_SIZE][ETH_ALEN] = {{0}};
+static void host_int_conn_trace(tstrWILC_WFIDrv* pstrWFIDrv, WILC_Uint8 u8Event, WILC_Uint32 u32Arg)
+{
+	WILC_Uint32 u32ConnId;
 
-#ifndef CONNECT_DIRECT
-static WILC_Uint8 gapu8RcvdSurveyResults[2][MAX_SURVEY_RESULT_FRAG_SIZE];
-#endif
+	if(pstrWFIDrv == WILC_NULL)
+	{
+		return;
+	}
 
-static WILC_Uint8 gapu8RcvdAssocResp[MAX_ASSOC_RESP_FRAME_SIZE];
+	u32ConnId = pstrWFIDrv->u32ConnTraceId;
+	if(u32ConnId != 0)
+	{
+		host_int_conn_trace_add(pstrWFIDrv, u32ConnId, u8Event, u32Arg);
+	}
+}
 
-WILC_Bool gbScanWhileConnected = WILC_FALSE;
+static void host_int_conn_trace_end(tstrWILC_WFIDrv* pstrWFIDrv)
+{
+	host_int_conn_trace(pstrWFIDrv, CONN_TRACE_END, 0);
+	pstrWFIDrv->u32ConnTraceId = 0;
+}
 
-static WILC_Sint8 gs8Rssi = 0;
-static WILC_Sint8 gs8lnkspd = 0;
-static WILC_Uint8 gu8Chnl = 0;
-static WILC_Uint8 gs8SetIP[2][4] = {{0}};
-static WILC_Uint8 gs8GetIP[2][4] = {{0}};
-#ifdef WILC_AP_EXTERNAL_MLME
-static WILC_Uint32 gu32InactiveTime = 0;
-static WILC_Uint8 gu8DelBcn = 0;
-#endif
-#ifndef SIMULATION
-static WILC_Uint32 gu32WidConnRstHack = 0;
-#endif
+/**
+*  @brief host_int_conn_trace_start
+*  @details 	   Starts tracing a new connection attempt on hWFIDrv
+*  @param[in]    WILC_WFIDrvHandle hWFIDrv
+*  @return 	    NONE
+*  @author	
+*  @date	
+*  @version	1.0
+*/
+void host_int_conn_trace_start(WILC_WFIDrvHandle hWFIDrv)
+{
+	tstrWILC_WFIDrv* pstrWFIDrv = (tstrWILC_WFIDrv*)hWFIDrv;
+	unsigned long flags;
 
-/*BugID_5137*/
-WILC_Uint8* gu8FlushedJoinReq = NULL;
-WILC_Uint8* gu8FlushedInfoElemAsoc = NULL;
-WILC_Uint8 gu8Flushed11iMode;
-WILC_Uint8 gu8FlushedAuthType;
-WILC_Uint32 gu32FlushedJoinReqSize;
-WILC_Uint32 gu32FlushedInfoElemAsocSize;
-WILC_Uint32 gu8FlushedJoinReqDrvHandler = 0;
-#define REAL_JOIN_REQ 0
-#define FLUSHED_JOIN_REQ 1
-#define FLUSHED_BYTE_POS 79	//Position the byte indicating flushing in the flushed request
+	if(pstrWFIDrv == WILC_NULL)
+	{
+		return;
+	}
 
-/*Bug4218: Parsing Join Param*/
-#ifdef WILC_PARSE_SCAN_IN_HOST	
-/*Bug4218: Parsing Join Param*/
-static void* host_int_ParseJoinBssParam(tstrNetworkInfo* ptstrNetworkInfo);
+	spin_lock_irqsave(&gConnTraceLock, flags);
+	if(++gu32ConnTraceLastId == 0)
+	{
+		gu32ConnTraceLastId = 1;
+	}
+	pstrWFIDrv->u32ConnTraceId = gu32ConnTraceLastId;
+	spin_unlock_irqrestore(&gConnTraceLock, flags);
+
+	host_int_conn_trace(pstrWFIDrv, CONN_TRACE_START, 0);
+}
+
+/* Called by SendConfigPkt() before sending and once it returns */
+void host_int_conn_trace_cfg(WILC_Uint32 drvHandler, WILC_Bool bDone, WILC_Sint32 s32Arg)
+{
+	host_int_conn_trace((tstrWILC_WFIDrv*)drvHandler, bDone ? CONN_TRACE_CFG_DONE : CONN_TRACE_CFG_SEND, (WILC_Uint32)s32Arg);
+}
+
+/*
+ * Fast reconnect: the join of the current connection is kept in the driver
+ * handle, and after a link loss it can be used again without scanning for
+ * the BSS. The statistics cover every reconnect after a link loss, from
+ * the firmware reporting the loss to the new connection carrying data.
+ */
+static DEFINE_SPINLOCK(gFastReconnectLock);
+static WILC_Uint32 gu32Reconnects = 0;
+static WILC_Uint32 gu32ReconnectsNoScan = 0;
+static WILC_Uint64 gu64ReconnectLastUs = 0;
+static WILC_Uint64 gu64ReconnectTotalUs = 0;
+
+static void host_int_set_state(tstrWILC_WFIDrv* pstrWFIDrv, tenuHostIFstate enuState)
+{
+	tenuHostIFstate enuPrevState = pstrWFIDrv->enuHostIFstate;
+
+	if(enuPrevState != enuState)
+	{
+		host_int_conn_trace(pstrWFIDrv, CONN_TRACE_STATE, enuState);
+	}
+	pstrWFIDrv->enuHostIFstate = enuState;
+
+	if(enuState == HOST_IF_IDLE)
+	{
+		/* the attempt failed or the connection is gone */
+		if(pstrWFIDrv->u32ConnTraceId != 0)
+		{
+			host_int_conn_trace_end(pstrWFIDrv);
+		}
+		/* a join that did not work is not worth retrying */
+		if(enuPrevState != HOST_IF_CONNECTED)
+		{
+			pstrWFIDrv->strFastReconnect.bStaged = WILC_FALSE;
+			pstrWFIDrv->strFastReconnect.bValid = WILC_FALSE;
+		}
+	}
+}
+
+#ifdef WILC_PARSE_SCAN_IN_HOST
+/* Handle_Connect(): keep a copy of the join being sent */
+static void host_int_fast_reconnect_stage(tstrWILC_WFIDrv* pstrWFIDrv, tstrHostIFconnectAttr* pstrHostIFconnectAttr,
+		tstrJoinBssParam* ptstrJoinBssParam)
+{
+	tstrFastReconnect* pstrFast = &pstrWFIDrv->strFastReconnect;
+	unsigned long flags;
+
+	pstrFast->bStaged = WILC_FALSE;
+	pstrFast->bValid = WILC_FALSE;
+
+	if((pstrHostIFconnectAttr->pu8bssid == NULL) || (pstrHostIFconnectAttr->pu8ssid == NULL)
+		|| (pstrHostIFconnectAttr->ssidLen > MAX_SSID_LEN))
+	{
+		return;
+	}
+
+	if(pstrFast->pJoinParams == NULL)
+	{
+		pstrFast->pJoinParams = WILC_MALLOC(sizeof(tstrJoinBssParam));
+		if(pstrFast->pJoinParams == NULL)
+		{
+			return;
+		}
+	}
+
+	spin_lock_irqsave(&gFastReconnectLock, flags);
+	WILC_memcpy(pstrFast->au8bssid, pstrHostIFconnectAttr->pu8bssid, ETH_ALEN);
+	WILC_memcpy(pstrFast->au8ssid, pstrHostIFconnectAttr->pu8ssid, pstrHostIFconnectAttr->ssidLen);
+	pstrFast->u8SsidLen = pstrHostIFconnectAttr->ssidLen;
+	pstrFast->u8channel = pstrHostIFconnectAttr->u8channel;
+	pstrFast->u8security = pstrHostIFconnectAttr->u8security;
+	pstrFast->tenuAuth_type = pstrHostIFconnectAttr->tenuAuth_type;
+	/* a fast reconnect joins with the copy itself */
+	if(ptstrJoinBssParam != pstrFast->pJoinParams)
+	{
+		WILC_memcpy(pstrFast->pJoinParams, ptstrJoinBssParam, sizeof(tstrJoinBssParam));
+	}
+	pstrFast->bStaged = WILC_TRUE;
+	spin_unlock_irqrestore(&gFastReconnectLock, flags);
+}
 #endif /*WILC_PARSE_SCAN_IN_HOST*/
 
-extern void chip_sleep_manually(WILC_Uint32 u32SleepTime);
+/*
+ * The firmware reported the link lost: start the reconnect clock and write
+ * the security settings of the lost BSS right away, so that a reconnect to
+ * it only has the join request left to send.
+ */
+static void host_int_fast_reconnect_link_lost(tstrWILC_WFIDrv* pstrWFIDrv)
+{
+	tstrFastReconnect* pstrFast = &pstrWFIDrv->strFastReconnect;
+	tstrWID astrWIDs[2];
+	unsigned long flags;
+
+	spin_lock_irqsave(&gFastReconnectLock, flags);
+	pstrFast->bLinkLost = WILC_TRUE;
+	pstrFast->bScanSkipped = WILC_FALSE;
+	pstrFast->bScanned = WILC_FALSE;
+	pstrFast->ulLinkLost = jiffies;
+	pstrFast->tLinkLost = ktime_get();
+	spin_unlock_irqrestore(&gFastReconnectLock, flags);
+
+	if(pstrFast->bValid == WILC_FALSE)
+	{
+		return;
+	}
+
+	astrWIDs[0].u16WIDid = (WILC_Uint16)WID_11I_MODE;
+	astrWIDs[0].enuWIDtype = WID_CHAR;
+	astrWIDs[0].s32ValueSize = sizeof(WILC_Char);
+	astrWIDs[0].ps8WidVal = (WILC_Sint8*)(&pstrFast->u8security);
+
+	astrWIDs[1].u16WIDid = (WILC_Uint16)WID_AUTH_TYPE;
+	astrWIDs[1].enuWIDtype = WID_CHAR;
+	astrWIDs[1].s32ValueSize = sizeof(WILC_Char);
+	astrWIDs[1].ps8WidVal = (WILC_Sint8*)(&pstrFast->tenuAuth_type);
+
+	/* always written: the shadow may predate the disconnection */
+	host_int_wid_shadow_sent((WILC_Uint32)pstrWFIDrv, astrWIDs, 2);
+	host_int_set_cfg_shadowed(pstrWFIDrv, astrWIDs, 2, WILC_FALSE);
+}
+
+static WILC_Bool host_int_fast_reconnect_fresh(tstrFastReconnect* pstrFast)
+{
+	return (pstrFast->bValid && pstrFast->bLinkLost &&
+		time_before(jiffies, pstrFast->ulLinkLost + FAST_RECONNECT_WINDOW)) ? WILC_TRUE : WILC_FALSE;
+}
+
+/**
+*  @brief host_int_fast_reconnect_scan
+*  @details 	   Whether a scan can be answered from the scan cache because
+		the link to a BSS was just lost. Only the first scan after
+		the loss is, the next ones go to the firmware.
+*  @param[in]    WILC_WFIDrvHandle hWFIDrv
+*  @param[out]   WILC_Uint8* pu8bssid, WILC_Uint8* pu8channel: the lost BSS
+*  @return 	    WILC_TRUE if the scan can be skipped
+*  @author	
+*  @date	
+*  @version	1.0
+*/
+WILC_Bool host_int_fast_reconnect_scan(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* pu8bssid, WILC_Uint8* pu8channel)
+{
+	tstrWILC_WFIDrv* pstrWFIDrv = (tstrWILC_WFIDrv*)hWFIDrv;
+	tstrFastReconnect* pstrFast;
+	WILC_Bool bSkip = WILC_FALSE;
+	unsigned long flags;
+
+	if(pstrWFIDrv == WILC_NULL)
+	{
+		return WILC_FALSE;
+	}
+	pstrFast = &pstrWFIDrv->strFastReconnect;
+
+	spin_lock_irqsave(&gFastReconnectLock, flags);
+	if(host_int_fast_reconnect_fresh(pstrFast) && !pstrFast->bScanSkipped)
+	{
+		WILC_memcpy(pu8bssid, pstrFast->au8bssid, ETH_ALEN);
+		*pu8channel = pstrFast->u8channel;
+		pstrFast->bScanSkipped = WILC_TRUE;
+		bSkip = WILC_TRUE;
+	}
+	spin_unlock_irqrestore(&gFastReconnectLock, flags);
+
+	return bSkip;
+}
+
+/**
+*  @brief host_int_fast_reconnect_bss
+*  @details 	   Looks up the BSS whose link was just lost, for a connect
+		request whose BSS is not in the scan results any more.
+*  @param[in]    WILC_WFIDrvHandle hWFIDrv
+*  @param[in]    pu8ssid, u8SsidLen: requested SSID
+*  @param[in]    pu8bssid: requested BSSID, NULL for any
+*  @param[out]   tstrNetworkInfo* pstrNetworkInfo: BSSID, SSID, channel and join
+		parameters of the lost BSS
+*  @return 	    WILC_TRUE if found
+*  @author	
+*  @date	
+*  @version	1.0
+*/
+WILC_Bool host_int_fast_reconnect_bss(WILC_WFIDrvHandle hWFIDrv, const WILC_Uint8* pu8ssid, WILC_Uint8 u8SsidLen,
+	const WILC_Uint8* pu8bssid, tstrNetworkInfo* pstrNetworkInfo)
+{
+	tstrWILC_WFIDrv* pstrWFIDrv = (tstrWILC_WFIDrv*)hWFIDrv;
+	tstrFastReconnect* pstrFast;
+	WILC_Bool bFound = WILC_FALSE;
+	unsigned long flags;
+
+	if(pstrWFIDrv == WILC_NULL)
+	{
+		return WILC_FALSE;
+	}
+	pstrFast = &pstrWFIDrv->strFastReconnect;
+
+	spin_lock_irqsave(&gFastReconnectLock, flags);
+	if(host_int_fast_reconnect_fresh(pstrFast)
+		&& (u8SsidLen == pstrFast->u8SsidLen) && (WILC_memcmp(pu8ssid, pstrFast->au8ssid, u8SsidLen) == 0)
+		&& ((pu8bssid == NULL) || (WILC_memcmp(pu8bssid, pstrFast->au8bssid, ETH_ALEN) == 0)))
+	{
+		WILC_memcpy(pstrNetworkInfo->au8bssid, pstrFast->au8bssid, ETH_ALEN);
+		WILC_memcpy(pstrNetworkInfo->au8ssid, pstrFast->au8ssid, pstrFast->u8SsidLen);
+		pstrNetworkInfo->u8SsidLen = pstrFast->u8SsidLen;
+		pstrNetworkInfo->u8channel = pstrFast->u8channel;
+		pstrNetworkInfo->pJoinParams = pstrFast->pJoinParams;
+		bFound = WILC_TRUE;
+	}
+	spin_unlock_irqrestore(&gFastReconnectLock, flags);
+
+	return bFound;
+}
+
+/* The connection can carry data: the pairwise key is in, or none is needed */
+static void host_int_link_ready(tstrWILC_WFIDrv* pstrWFIDrv)
+{
+	tstrFastReconnect* pstrFast = &pstrWFIDrv->strFastReconnect;
+	WILC_Uint64 u64Us;
+	unsigned long flags;
+
+	if(pstrWFIDrv->u32ConnTraceId != 0)
+	{
+		host_int_conn_trace_end(pstrWFIDrv);
+	}
+
+	spin_lock_irqsave(&gFastReconnectLock, flags);
+	if(pstrFast->bLinkLost)
+	{
+		u64Us = (WILC_Uint64)ktime_us_delta(ktime_get(), pstrFast->tLinkLost);
+		gu32Reconnects++;
+		if(!pstrFast->bScanned)
+		{
+			gu32ReconnectsNoScan++;
+		}
+		gu64ReconnectLastUs = u64Us;
+		gu64ReconnectTotalUs += u64Us;
+		pstrFast->bLinkLost = WILC_FALSE;
+	}
+	spin_unlock_irqrestore(&gFastReconnectLock, flags);
+}
+
+#if defined (WILC_DEBUGFS)
+/*
+ * Per connection breakdown, oldest first, followed by the event timeline
+ * of the most recent connection. All times in us.
+ *   queue   START to Handle_Connect picking the request up
+ *   cfg     config round trips of the attempt (count/total)
+ *   join    last config response to the firmware's async info
+ *   async   async info received to handled
+ *   result  START to the connect result reaching cfg80211
+ *   keys    connect result to the last key installed
+ */
+int host_int_dump_conn_trace(char *buf, int size)
+{
+	static const char* apcEvents[CONN_TRACE_EVENTS] = {"start", "state", "connect", "cfg_send", "cfg_done",
+		"async_rcvd", "async_handled", "result", "key", "key_done", "end"};
+	tstrConnTraceEntry* pstrTrace;
+	tstrConnTraceEntry* pstrEntry;
+	WILC_Uint32 u32Count, u32First, u32ConnId, u32LastId = 0;
+	unsigned long flags;
+	int i, j, len = 0;
+
+	pstrTrace = (tstrConnTraceEntry*)WILC_MALLOC(sizeof(gastrConnTrace));
+	if(pstrTrace == WILC_NULL)
+	{
+		return 0;
+	}
+
+	/* snapshot the ring in chronological order */
+	spin_lock_irqsave(&gConnTraceLock, flags);
+	u32Count = (gu32ConnTraceHead < CONN_TRACE_ENTRIES) ? gu32ConnTraceHead : CONN_TRACE_ENTRIES;
+	u32First = gu32ConnTraceHead - u32Count;
+	for(i = 0; i < u32Count; i++)
+	{
+		pstrTrace[i] = gastrConnTrace[(u32First + i) & (CONN_TRACE_ENTRIES - 1)];
+	}
+	spin_unlock_irqrestore(&gConnTraceLock, flags);
+
+	spin_lock_irqsave(&gFastReconnectLock, flags);
+	len += scnprintf(buf + len, size - len, "reconnects %u (without scan %u), link loss to data last %llu us avg %llu us\n\n",
+			gu32Reconnects, gu32ReconnectsNoScan, gu64ReconnectLastUs,
+			(gu32Reconnects != 0) ? div_u64(gu64ReconnectTotalUs, gu32Reconnects) : 0);
+	spin_unlock_irqrestore(&gFastReconnectLock, flags);
+
+	len += scnprintf(buf + len, size - len, "%6s %10s %10s %10s %10s %10s %10s %10s\n",
+			"conn", "queue", "cfg", "cfg_us", "join", "async", "result", "keys");
+
+	for(i = 0; i < u32Count; i++)
+	{
+		ktime_t tStart, tLastCfg, tAsync, tResult, tKey;
+		WILC_Sint64 s64Queue = -1, s64Join = -1, s64Async = -1, s64Result = -1, s64Keys = -1;
+		WILC_Uint32 u32Cfgs = 0;
+		WILC_Sint64 s64CfgUs = 0;
+		ktime_t tCfgSend;
+
+		if(pstrTrace[i].u8Event != CONN_TRACE_START)
+		{
+			continue;
+		}
+
+		u32ConnId = pstrTrace[i].u32ConnId;
+		u32LastId = u32ConnId;
+		tStart = pstrTrace[i].tStamp;
+		tLastCfg = tAsync = tResult = tKey = tCfgSend = ktime_set(0, 0);
+
+		for(j = i + 1; j < u32Count; j++)
+		{
+			pstrEntry = &pstrTrace[j];
+			if(pstrEntry->u32ConnId != u32ConnId)
+			{
+				continue;
+			}
+
+			switch(pstrEntry->u8Event)
+			{
+				case CONN_TRACE_CONNECT:
+					if(s64Queue < 0)
+						s64Queue = ktime_us_delta(pstrEntry->tStamp, tStart);
+					break;
+				case CONN_TRACE_CFG_SEND:
+					tCfgSend = pstrEntry->tStamp;
+					break;
+				case CONN_TRACE_CFG_DONE:
+					u32Cfgs++;
+					s64CfgUs += ktime_us_delta(pstrEntry->tStamp, tCfgSend);
+					if(ktime_to_ns(tAsync) == 0)
+						tLastCfg = pstrEntry->tStamp;
+					break;
+				case CONN_TRACE_ASYNC_RCVD:
+					if(ktime_to_ns(tAsync) == 0)
+					{
+						tAsync = pstrEntry->tStamp;
+						if(ktime_to_ns(tLastCfg) != 0)
+							s64Join = ktime_us_delta(tAsync, tLastCfg);
+					}
+					break;
+				case CONN_TRACE_ASYNC_HANDLED:
+					if((s64Async < 0) && (ktime_to_ns(tAsync) != 0))
+						s64Async = ktime_us_delta(pstrEntry->tStamp, tAsync);
+					break;
+				case CONN_TRACE_RESULT:
+					if(s64Result < 0)
+					{
+						tResult = pstrEntry->tStamp;
+						s64Result = ktime_us_delta(tResult, tStart);
+					}
+					break;
+				case CONN_TRACE_KEY_DONE:
+					if(ktime_to_ns(tResult) != 0)
+						s64Keys = ktime_us_delta(pstrEntry->tStamp, tResult);
+					break;
+				default:
+					break;
+			}
+		}
+
+		len += scnprintf(buf + len, size - len, "%6u %10lld %10u %10lld %10lld %10lld %10lld %10lld\n",
+				u32ConnId, s64Queue, u32Cfgs, s64CfgUs, s64Join, s64Async, s64Result, s64Keys);
+	}
+
+	/* timeline of the last connection */
+	if(u32LastId != 0)
+	{
+		ktime_t tPrev = ktime_set(0, 0);
+		ktime_t tStart = ktime_set(0, 0);
+
+		len += scnprintf(buf + len, size - len, "\nconn %u\n%10s %10s  %-14s %s\n",
+				u32LastId, "at", "delta", "event", "arg");
+		for(i = 0; i < u32Count; i++)
+		{
+			pstrEntry = &pstrTrace[i];
+			if(pstrEntry->u32ConnId != u32LastId)
+			{
+				continue;
+			}
+			if(pstrEntry->u8Event == CONN_TRACE_START)
+			{
+				tStart = tPrev = pstrEntry->tStamp;
+			}
+			len += scnprintf(buf + len, size - len, "%10lld %10lld  %-14s %d\n",
+					ktime_us_delta(pstrEntry->tStamp, tStart), ktime_us_delta(pstrEntry->tStamp, tPrev),
+					apcEvents[pstrEntry->u8Event], (WILC_Sint32)pstrEntry->u32Arg);
+			tPrev = pstrEntry->tStamp;
+		}
+	}
+
+	WILC_FREE(pstrTrace);
+	return len;
+}
+#endif
 
 /**
 *  @brief Handle_SetChannel
@@ -746,7 +2270,7 @@ static WILC_Sint32 Handle_SetOperationMode(void * drvHandler, tstrHostIfSetOpera
 	/*Sending Cfg*/
 	PRINT_INFO(HOSTINF_DBG,"(WILC_Uint32)pstrWFIDrv= %x \n",(WILC_Uint32)pstrWFIDrv);
 
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_TRUE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = host_int_set_cfg_shadowed(pstrWFIDrv, &strWID, 1, WILC_TRUE);
 					
 
 	if((pstrHostIfSetOperationMode->u32Mode)==(WILC_Uint32)NULL)
@@ -958,7 +2482,7 @@ static WILC_Sint32 Handle_GetMacAddress(void * drvHandler, tstrHostIfGetMacAddre
 	{
 
 	}
-	WILC_SemaphoreRelease(&hWaitResponse, NULL);
+	WILC_SemaphoreRelease(host_int_response_sem(drvHandler), NULL);
 
 	return s32Error;
 }
@@ -1329,7 +2853,7 @@ static WILC_Sint32 Handle_CfgParam(void * drvHandler,tstrHostIFCfgParamAttr* str
 			  }
 			  u8WidCnt++;
 		  }
-		  s32Error = SendConfigPkt(SET_CFG, strWIDList, u8WidCnt, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
+		  s32Error = host_int_set_cfg_shadowed(pstrWFIDrv, strWIDList, u8WidCnt, WILC_FALSE);
 
 		  if(s32Error)
 		  {
@@ -1356,8 +2880,7 @@ static WILC_Sint32 Handle_CfgParam(void * drvHandler,tstrHostIFCfgParamAttr* str
 static WILC_Sint32 Handle_wait_msg_q_empty(void)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;
-	g_wilc_initialized = 0;
-	WILC_SemaphoreRelease(&hWaitResponse, NULL);
+	WILC_SemaphoreRelease(&hSemQueueIdle, NULL);
 	return s32Error;
 }
 
@@ -1416,7 +2939,7 @@ static WILC_Sint32 Handle_Scan(void * drvHandler,tstrHostIFscanAttr* pstrHostIFs
 	PRINT_D(HOSTINF_DBG,"Setting SCAN params\n");
 
 
-	pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount = 0;	
+	host_int_found_ntwrk_reset(&pstrWFIDrv->strWILC_UsrScanReq);
 	
 	/*BugID_4189*/
 	strWIDList[u32WidsCount].u16WIDid = (WILC_Uint16)WID_SSID_PROBE_REQ;
@@ -1819,7 +3342,7 @@ static WILC_Sint32 Handle_Connect(void * drvHandler,tstrHostIFconnectAttr* pstrH
 		}
 		else
 		{
-			pstrWFIDrv->enuHostIFstate = HOST_IF_WAITING_CONN_RESP;
+			host_int_set_state(pstrWFIDrv, HOST_IF_WAITING_CONN_RESP);
 		}
 
 	}
@@ -1955,6 +3478,16 @@ static WILC_Sint32 Handle_Connect(void * drvHandler,tstrHostIFconnectAttr* pstrH
 		gu8FlushedAuthType = (WILC_Uint8)pstrWFIDrv->strWILC_UsrConnReq.tenuAuth_type;
 	
 	PRINT_INFO(HOSTINF_DBG,"Authentication Type = %x\n",pstrWFIDrv->strWILC_UsrConnReq.tenuAuth_type);
+
+	/* Reconnecting to the BSS whose link was lost: the security settings
+	   were written when the loss was reported, do not send them again */
+	if(pstrWFIDrv->strFastReconnect.bValid && pstrWFIDrv->strFastReconnect.bLinkLost
+		&& (pstrHostIFconnectAttr->pu8bssid != NULL)
+		&& (WILC_memcmp(pstrHostIFconnectAttr->pu8bssid, pstrWFIDrv->strFastReconnect.au8bssid, ETH_ALEN) == 0))
+	{
+		u32WidsCount -= 2;
+		u32WidsCount += host_int_wid_shadow_elide(pstrWFIDrv, &strWIDList[u32WidsCount], 2);
+	}
 	/*
 	strWIDList[u32WidsCount].u16WIDid = (WILC_Uint16)WID_11I_PSK;
 	strWIDList[u32WidsCount].enuWIDtype = WID_STR;
@@ -2191,7 +3724,10 @@ static WILC_Sint32 Handle_Connect(void * drvHandler,tstrHostIFconnectAttr* pstrH
 	else
 	{
 		PRINT_D(GENERIC_DBG,"set HOST_IF_WAITING_CONN_RESP\n");
-		pstrWFIDrv->enuHostIFstate = HOST_IF_WAITING_CONN_RESP;
+		host_int_set_state(pstrWFIDrv, HOST_IF_WAITING_CONN_RESP);
+		#ifdef WILC_PARSE_SCAN_IN_HOST
+		host_int_fast_reconnect_stage(pstrWFIDrv, pstrHostIFconnectAttr, ptstrJoinBssParam);
+		#endif
 	}		
 	#endif
 	
@@ -2221,13 +3757,14 @@ static WILC_Sint32 Handle_Connect(void * drvHandler,tstrHostIFconnectAttr* pstrH
 							  pstrHostIFconnectAttr->IEsLen);
 			}			
 		
+			host_int_conn_trace(pstrWFIDrv, CONN_TRACE_RESULT, MAC_DISCONNECTED);
 			pstrHostIFconnectAttr->pfConnectResult(CONN_DISCONN_EVENT_CONN_RESP,
 												   &strConnectInfo,
 												   MAC_DISCONNECTED,
 												   NULL,
 												   pstrHostIFconnectAttr->pvUserArg);
 			/*Change state to idle*/
-			pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;
+			host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);
 			/* Deallocation */
 			if(strConnectInfo.pu8ReqIEs != NULL)
 			{
@@ -2364,7 +3901,7 @@ static WILC_Sint32 Handle_ConnectTimeout(void* drvHandler)
 		return s32Error;		
 	}
 
-	pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;
+	host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);
 
 	gbScanWhileConnected = WILC_FALSE;			
 
@@ -2392,6 +3929,7 @@ static WILC_Sint32 Handle_ConnectTimeout(void* drvHandler)
 						  pstrWFIDrv->strWILC_UsrConnReq.ConnReqIEsLen);
 		}		
 		
+		host_int_conn_trace(pstrWFIDrv, CONN_TRACE_RESULT, MAC_DISCONNECTED);
 		pstrWFIDrv->strWILC_UsrConnReq.pfUserConnectResult(CONN_DISCONN_EVENT_CONN_RESP,
 														      &strConnectInfo,
 														      MAC_DISCONNECTED,
@@ -2451,16 +3989,99 @@ static WILC_Sint32 Handle_ConnectTimeout(void* drvHandler)
 	/*Freeing flushed join request params on connect timeout*/
 	if(gu8FlushedJoinReq != NULL && gu8FlushedJoinReqDrvHandler==(WILC_Uint32)drvHandler)
 	{
-		WILC_FREE(gu8FlushedJoinReq);
-		gu8FlushedJoinReq = NULL;
+		WILC_FREE(gu8FlushedJoinReq);
+		gu8FlushedJoinReq = NULL;
+	}
+	if(gu8FlushedInfoElemAsoc != NULL && gu8FlushedJoinReqDrvHandler==(WILC_Uint32)drvHandler)
+	{
+		WILC_FREE(gu8FlushedInfoElemAsoc);
+		gu8FlushedInfoElemAsoc = NULL;
+	}
+	
+	return s32Error;
+}
+
+/*
+ * Found networks table: lookups cost the same however many networks the
+ * scan has found, so the number kept is bound by MAX_NUM_FOUND_NETWORKS
+ * only.
+ */
+static WILC_Uint32 host_int_found_ntwrk_hash(const WILC_Uint8* pu8bssid, WILC_Uint8 u8Bits)
+{
+	WILC_Uint32 u32Key;
+
+	/* the OUI changes least between BSSes, fold it onto the rest */
+	u32Key = (((WILC_Uint32)pu8bssid[2] << 24) | (pu8bssid[3] << 16) | (pu8bssid[4] << 8) | pu8bssid[5])
+		^ ((pu8bssid[0] << 8) | pu8bssid[1]);
+	return (u32Key * 0x9E3779B1) >> (32 - u8Bits);
+}
+
+/* The slot holding pu8bssid, or the free one it would go to */
+static tstrFoundNetworkInfo* host_int_found_ntwrk_slot(tstrWILC_UsrScanReq* pstrScanReq, const WILC_Uint8* pu8bssid)
+{
+	WILC_Uint32 u32Mask = (1 << pstrScanReq->u8FoundSlotBits) - 1;
+	WILC_Uint32 i = host_int_found_ntwrk_hash(pu8bssid, pstrScanReq->u8FoundSlotBits);
+	tstrFoundNetworkInfo* pstrSlot;
+
+	/* never full, see host_int_found_ntwrk_reserve() */
+	while(1)
+	{
+		pstrSlot = &pstrScanReq->pastrFoundNetworkInfo[i];
+		if(!pstrSlot->u8Used || (WILC_memcmp(pstrSlot->au8bssid, pu8bssid, 6) == 0))
+		{
+			return pstrSlot;
+		}
+		i = (i + 1) & u32Mask;
+	}
+}
+
+/* Makes room for one more network */
+static WILC_Sint32 host_int_found_ntwrk_reserve(tstrWILC_UsrScanReq* pstrScanReq)
+{
+	tstrFoundNetworkInfo* pastrOld = pstrScanReq->pastrFoundNetworkInfo;
+	WILC_Uint32 u32OldSlots = (pastrOld != WILC_NULL) ? (1 << pstrScanReq->u8FoundSlotBits) : 0;
+	WILC_Uint8 u8Bits;
+	WILC_Uint32 i;
+
+	if((pstrScanReq->u32RcvdChCount + 1) * 4 <= u32OldSlots * 3)
+	{
+		return WILC_SUCCESS;
+	}
+
+	u8Bits = (pastrOld != WILC_NULL) ? (pstrScanReq->u8FoundSlotBits + 1) : FOUND_NETWORKS_MIN_SLOT_BITS;
+	pstrScanReq->pastrFoundNetworkInfo = (tstrFoundNetworkInfo*)WILC_MALLOC(sizeof(tstrFoundNetworkInfo) << u8Bits);
+	if(pstrScanReq->pastrFoundNetworkInfo == WILC_NULL)
+	{
+		pstrScanReq->pastrFoundNetworkInfo = pastrOld;
+		return WILC_NO_MEM;
 	}
-	if(gu8FlushedInfoElemAsoc != NULL && gu8FlushedJoinReqDrvHandler==(WILC_Uint32)drvHandler)
+	WILC_memset(pstrScanReq->pastrFoundNetworkInfo, 0, sizeof(tstrFoundNetworkInfo) << u8Bits);
+	pstrScanReq->u8FoundSlotBits = u8Bits;
+
+	for(i = 0; i < u32OldSlots; i++)
 	{
-		WILC_FREE(gu8FlushedInfoElemAsoc);
-		gu8FlushedInfoElemAsoc = NULL;
+		if(pastrOld[i].u8Used)
+		{
+			*host_int_found_ntwrk_slot(pstrScanReq, pastrOld[i].au8bssid) = pastrOld[i];
+		}
+	}
+	if(pastrOld != WILC_NULL)
+	{
+		WILC_FREE(pastrOld);
+	}
+
+	return WILC_SUCCESS;
+}
+
+/* A new scan starts: forget the networks, keep the table */
+static void host_int_found_ntwrk_reset(tstrWILC_UsrScanReq* pstrScanReq)
+{
+	pstrScanReq->u32RcvdChCount = 0;
+	if(pstrScanReq->pastrFoundNetworkInfo != WILC_NULL)
+	{
+		WILC_memset(pstrScanReq->pastrFoundNetworkInfo, 0,
+			sizeof(tstrFoundNetworkInfo) << pstrScanReq->u8FoundSlotBits);
 	}
-	
-	return s32Error;
 }
 
 /**
@@ -2474,12 +4095,13 @@ static WILC_Sint32 Handle_ConnectTimeout(void* drvHandler)
 */
 static WILC_Sint32 Handle_RcvdNtwrkInfo(void* drvHandler,tstrRcvdNetworkInfo* pstrRcvdNetworkInfo)
 {
-	WILC_Uint32 i;
 	WILC_Bool bNewNtwrkFound;
+	tstrFoundNetworkInfo* pstrFound = WILC_NULL;
 	
 
 	
 	WILC_Sint32 s32Error = WILC_SUCCESS;
+	tstrNetworkInfo strNetworkInfo;
 	tstrNetworkInfo * pstrNetworkInfo = NULL;	
 	void* pJoinParams = NULL;
 	
@@ -2494,7 +4116,11 @@ static WILC_Sint32 Handle_RcvdNtwrkInfo(void* drvHandler,tstrRcvdNetworkInfo* ps
 	if(pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult)
 	{
 		PRINT_D(HOSTINF_DBG,"State: Scanning, parsing network information received\n");
-		ParseNetworkInfo(pstrRcvdNetworkInfo->pu8Buffer, &pstrNetworkInfo);
+		/* the record and its IEs point into pu8Buffer, which outlives every use below */
+		if(ParseNetworkInfoInPlace(pstrRcvdNetworkInfo->pu8Buffer, &strNetworkInfo) == WILC_SUCCESS)
+		{
+			pstrNetworkInfo = &strNetworkInfo;
+		}
 		if((pstrNetworkInfo == NULL) 
 		    ||(pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult == WILC_NULL))
 		{
@@ -2502,31 +4128,25 @@ static WILC_Sint32 Handle_RcvdNtwrkInfo(void* drvHandler,tstrRcvdNetworkInfo* ps
 		}		
 		
 		/* check whether this network is discovered before */
-		for(i = 0; i < pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount; i++)
+		if(pstrWFIDrv->strWILC_UsrScanReq.pastrFoundNetworkInfo != WILC_NULL)
 		{
-
-			if((pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[i].au8bssid != NULL) &&
-			   (pstrNetworkInfo->au8bssid != NULL))
+			pstrFound = host_int_found_ntwrk_slot(&pstrWFIDrv->strWILC_UsrScanReq, pstrNetworkInfo->au8bssid);
+			if(pstrFound->u8Used)
 			{
-				if(WILC_memcmp(pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[i].au8bssid,
-								  pstrNetworkInfo->au8bssid, 6) == 0)
+				if(pstrNetworkInfo->s8rssi <= pstrFound->s8rssi)
 				{
-					if(pstrNetworkInfo->s8rssi <= pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[i].s8rssi)
-					{
-						/*we have already found this network with better rssi, so keep the old cached one and don't 
-						    send anything to the upper layer */
-						PRINT_D(HOSTINF_DBG,"Network previously discovered\n");
-						goto done;
-					}
-					else
-					{
-						/* here the same already found network is found again but with a better rssi, so just update 
-				     		     the rssi for this cached network and send this updated network to the upper layer but 
-				     		     don't add a new record for it */
-				     	 	pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[i].s8rssi = pstrNetworkInfo->s8rssi;
-						bNewNtwrkFound = WILC_FALSE;
-						break;
-					}
+					/*we have already found this network with better rssi, so keep the old cached one and don't 
+					    send anything to the upper layer */
+					PRINT_D(HOSTINF_DBG,"Network previously discovered\n");
+					goto done;
+				}
+				else
+				{
+					/* here the same already found network is found again but with a better rssi, so just update 
+			     		     the rssi for this cached network and send this updated network to the upper layer but 
+			     		     don't add a new record for it */
+			     	 	pstrFound->s8rssi = pstrNetworkInfo->s8rssi;
+					bNewNtwrkFound = WILC_FALSE;
 				}
 			}
 		}
@@ -2538,17 +4158,20 @@ static WILC_Sint32 Handle_RcvdNtwrkInfo(void* drvHandler,tstrRcvdNetworkInfo* ps
 
 			PRINT_D(HOSTINF_DBG,"New network found\n");
 
-			if(pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount < MAX_NUM_SCANNED_NETWORKS)
+			if(pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount < MAX_NUM_FOUND_NETWORKS)
 			{
-				pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount].s8rssi = pstrNetworkInfo->s8rssi;
-				
-				if((pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount].au8bssid != NULL)
-					&& (pstrNetworkInfo->au8bssid != NULL))
+				if(host_int_found_ntwrk_reserve(&pstrWFIDrv->strWILC_UsrScanReq) != WILC_SUCCESS)
 				{
-					WILC_memcpy(pstrWFIDrv->strWILC_UsrScanReq.astrFoundNetworkInfo[pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount].au8bssid,
-							   pstrNetworkInfo->au8bssid, 6);
+					PRINT_ER("No memory to keep the discovered network\n");
+					goto done;
+				}
+				/* the table may have moved */
+				pstrFound = host_int_found_ntwrk_slot(&pstrWFIDrv->strWILC_UsrScanReq, pstrNetworkInfo->au8bssid);
+				pstrFound->s8rssi = pstrNetworkInfo->s8rssi;
+				pstrFound->u8Used = 1;
+				WILC_memcpy(pstrFound->au8bssid, pstrNetworkInfo->au8bssid, 6);
 
-					pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount++;
+				pstrWFIDrv->strWILC_UsrScanReq.u32RcvdChCount++;
 
 				pstrNetworkInfo->bNewNetwork = WILC_TRUE;
 				/*Bug4218: Parsing Join Param*/
@@ -2560,9 +4183,6 @@ static WILC_Sint32 Handle_RcvdNtwrkInfo(void* drvHandler,tstrRcvdNetworkInfo* ps
 				pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult(SCAN_EVENT_NETWORK_FOUND, pstrNetworkInfo,
 																	  pstrWFIDrv->strWILC_UsrScanReq.u32UserScanPvoid,
 																	  pJoinParams);
-
-
-				}
 			}
 			else
 			{
@@ -2591,17 +4211,160 @@ done:
 		WILC_FREE(pstrRcvdNetworkInfo->pu8Buffer);
 		pstrRcvdNetworkInfo->pu8Buffer = NULL;
 	}
-	
-	/*free structure allocated*/
-	if(pstrNetworkInfo != WILC_NULL)
-	{
-		DeallocateNetworkInfo(pstrNetworkInfo);
-		pstrNetworkInfo = WILC_NULL;
-	}
 		
 	return s32Error;
 }
 
+#if defined (WILC_DEBUGFS)
+/*
+ * Scan benchmark, run each time wilc_bench_scan is read. Synthetic 'N'
+ * messages from u32Networks BSSes, each heard HOST_IF_BENCH_SCAN_REPEATS
+ * times, are copied and handed to Handle_RcvdNtwrkInfo() the way
+ * NetworkInfoReceived() does, on a driver handle of the benchmark's own.
+ * The BSSIDs are then looked up again in the found networks table, and
+ * in a list walked from the start, the way networks were told apart
+ * before the table.
+ */
+#define HOST_IF_BENCH_SCAN_REPEATS	8
+
+static void host_int_bench_scan_result(tenuScanEvent enuEvent, tstrNetworkInfo* pstrNetworkInfo,
+		void* pvUserArg, void* pJoinParams)
+{
+	(*(WILC_Uint32*)pvUserArg)++;
+	/* cfg80211 would have kept them */
+	if(pJoinParams != NULL)
+	{
+		WILC_FREE(pJoinParams);
+	}
+}
+
+static void host_int_bench_scan_bssid(WILC_Uint32 u32Network, WILC_Uint8* pu8bssid)
+{
+	pu8bssid[0] = 0x02;			/* locally administered */
+	pu8bssid[1] = 0xbe;
+	pu8bssid[2] = 0x4c;
+	pu8bssid[3] = (WILC_Uint8)(u32Network >> 16);
+	pu8bssid[4] = (WILC_Uint8)(u32Network >> 8);
+	pu8bssid[5] = (WILC_Uint8)u32Network;
+}
+
+int host_int_bench_scan(char *buf, int size)
+{
+	static const WILC_Uint32 au32Networks[] = {64, 256, MAX_NUM_FOUND_NETWORKS};
+	tstrWILC_WFIDrv* pstrWFIDrv;
+	tstrRcvdNetworkInfo strRcvdNetworkInfo;
+	WILC_Uint8 au8Msg[NETWORK_INFO_MSG_MAX];
+	WILC_Uint8 (*pau8Walked)[6];
+	WILC_Uint8 au8bssid[6];
+	WILC_Uint32 u32Frames, u32Reported, u32Walked, u32Hits;
+	WILC_Uint32 i, n, r, u32Len;
+	WILC_Uint64 u64HandleNs, u64TableNs, u64WalkNs;
+	ktime_t tStart;
+	int len = 0;
+
+	pstrWFIDrv = (tstrWILC_WFIDrv*)WILC_MALLOC(sizeof(tstrWILC_WFIDrv));
+	pau8Walked = WILC_MALLOC(MAX_NUM_FOUND_NETWORKS * 6);
+	if(pstrWFIDrv == WILC_NULL || pau8Walked == WILC_NULL)
+	{
+		WILC_FREE_IF_TRUE(pstrWFIDrv);
+		WILC_FREE_IF_TRUE(pau8Walked);
+		return scnprintf(buf, size, "out of memory\n");
+	}
+	WILC_memset(pstrWFIDrv, 0, sizeof(tstrWILC_WFIDrv));
+	pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult = host_int_bench_scan_result;
+	pstrWFIDrv->strWILC_UsrScanReq.u32UserScanPvoid = &u32Reported;
+
+	len += scnprintf(buf + len, size - len, "%-9s %7s %9s %10s %10s %10s\n",
+			"networks", "frames", "reported", "handle_ns", "table_ns", "walk_ns");
+	for(i = 0; i < ARRAY_SIZE(au32Networks); i++)
+	{
+		host_int_found_ntwrk_reset(&pstrWFIDrv->strWILC_UsrScanReq);
+		u32Frames = au32Networks[i] * HOST_IF_BENCH_SCAN_REPEATS;
+		u32Reported = 0;
+
+		/* a few sweeps of the channels, the rssi changing as they go */
+		u64HandleNs = 0;
+		for(r = 0; r < HOST_IF_BENCH_SCAN_REPEATS; r++)
+		{
+			for(n = 0; n < au32Networks[i]; n++)
+			{
+				host_int_bench_scan_bssid(n, au8bssid);
+				u32Len = BuildNetworkInfoMsg(au8Msg, au8bssid, -50 - (WILC_Sint8)((n + r * 3) & 15),
+						(WILC_Uint32)pstrWFIDrv);
+
+				tStart = ktime_get();
+				strRcvdNetworkInfo.u32Length = u32Len;
+				strRcvdNetworkInfo.pu8Buffer = (WILC_Uint8*)WILC_MALLOC(u32Len);
+				if(strRcvdNetworkInfo.pu8Buffer != WILC_NULL)
+				{
+					WILC_memcpy(strRcvdNetworkInfo.pu8Buffer, au8Msg, u32Len);
+					Handle_RcvdNtwrkInfo(pstrWFIDrv, &strRcvdNetworkInfo);
+				}
+				u64HandleNs += ktime_to_ns(ktime_sub(ktime_get(), tStart));
+			}
+		}
+
+		/* the lookups alone, in the table filled above */
+		u32Hits = 0;
+		tStart = ktime_get();
+		for(r = 0; (r < HOST_IF_BENCH_SCAN_REPEATS) && (pstrWFIDrv->strWILC_UsrScanReq.pastrFoundNetworkInfo != WILC_NULL); r++)
+		{
+			for(n = 0; n < au32Networks[i]; n++)
+			{
+				host_int_bench_scan_bssid(n, au8bssid);
+				if(host_int_found_ntwrk_slot(&pstrWFIDrv->strWILC_UsrScanReq, au8bssid)->u8Used)
+				{
+					u32Hits++;
+				}
+			}
+		}
+		u64TableNs = ktime_to_ns(ktime_sub(ktime_get(), tStart));
+
+		/* and walking a list, adding what isn't found */
+		u32Walked = 0;
+		tStart = ktime_get();
+		for(r = 0; r < HOST_IF_BENCH_SCAN_REPEATS; r++)
+		{
+			for(n = 0; n < au32Networks[i]; n++)
+			{
+				WILC_Uint32 j;
+
+				host_int_bench_scan_bssid(n, au8bssid);
+				for(j = 0; j < u32Walked; j++)
+				{
+					if(WILC_memcmp(pau8Walked[j], au8bssid, 6) == 0)
+					{
+						break;
+					}
+				}
+				if(j == u32Walked)
+				{
+					WILC_memcpy(pau8Walked[u32Walked++], au8bssid, 6);
+				}
+				else
+				{
+					u32Hits++;
+				}
+			}
+		}
+		u64WalkNs = ktime_to_ns(ktime_sub(ktime_get(), tStart));
+
+		PRINT_D(HOSTINF_DBG, "Bench scan hits %u\n", u32Hits);
+		len += scnprintf(buf + len, size - len, "%-9u %7u %9u %10u %10u %10u\n",
+				au32Networks[i], u32Frames, u32Reported,
+				(WILC_Uint32)div_u64(u64HandleNs, u32Frames),
+				(WILC_Uint32)div_u64(u64TableNs, u32Frames),
+				(WILC_Uint32)div_u64(u64WalkNs, u32Frames));
+	}
+
+	WILC_FREE_IF_TRUE(pstrWFIDrv->strWILC_UsrScanReq.pastrFoundNetworkInfo);
+	WILC_FREE(pstrWFIDrv);
+	WILC_FREE(pau8Walked);
+
+	return len;
+}
+#endif
+
 /**
 *  @brief Handle_RcvdGnrlAsyncInfo
 *  @details 	   Handling received asynchrous general network information 
@@ -2776,6 +4539,7 @@ static WILC_Sint32 Handle_RcvdGnrlAsyncInfo(void * drvHandler,tstrRcvdGnrlAsyncI
 
 			
 			WILC_TimerStop(&(pstrWFIDrv->hConnectTimer), WILC_NULL);					
+			host_int_conn_trace(pstrWFIDrv, CONN_TRACE_RESULT, u8MacStatus);
 			pstrWFIDrv->strWILC_UsrConnReq.pfUserConnectResult(CONN_DISCONN_EVENT_CONN_RESP, 
 															      &strConnectInfo,
 															      u8MacStatus,
@@ -2795,7 +4559,14 @@ static WILC_Sint32 Handle_RcvdGnrlAsyncInfo(void * drvHandler,tstrRcvdGnrlAsyncI
 				#endif
 				
 				PRINT_D(HOSTINF_DBG,"MAC status : CONNECTED and Connect Status : Successful\n");
-				pstrWFIDrv->enuHostIFstate = HOST_IF_CONNECTED;
+				host_int_set_state(pstrWFIDrv, HOST_IF_CONNECTED);
+				host_int_wid_cache_invalidate(pstrWFIDrv);
+				pstrWFIDrv->strFastReconnect.bValid = pstrWFIDrv->strFastReconnect.bStaged;
+				/* no keys will follow on an open network */
+				if(pstrWFIDrv->strWILC_UsrConnReq.u8security == 0)
+				{
+					host_int_link_ready(pstrWFIDrv);
+				}
 
 				#ifdef DISABLE_PWRSAVE_AND_SCAN_DURING_IP
 				PRINT_D(GENERIC_DBG,"Obtaining an IP, Disable Scan\n");
@@ -2815,7 +4586,8 @@ static WILC_Sint32 Handle_RcvdGnrlAsyncInfo(void * drvHandler,tstrRcvdGnrlAsyncI
 			else
 			{
 				PRINT_D(HOSTINF_DBG,"MAC status : %d and Connect Status : %d\n",u8MacStatus,strConnectInfo.u16ConnectStatus);
-				pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;
+				host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);
+				host_int_wid_cache_invalidate(pstrWFIDrv);
 				gbScanWhileConnected = WILC_FALSE;
 			}
 
@@ -2872,6 +4644,9 @@ static WILC_Sint32 Handle_RcvdGnrlAsyncInfo(void * drvHandler,tstrRcvdGnrlAsyncI
 			strDisconnectNotifInfo.u16reason = 0;
 			strDisconnectNotifInfo.ie = NULL;
 			strDisconnectNotifInfo.ie_len = 0;
+
+			/* before the upper layer hears of it and starts reconnecting */
+			host_int_fast_reconnect_link_lost(pstrWFIDrv);
 			
 			if(pstrWFIDrv->strWILC_UsrConnReq.pfUserConnectResult != NULL)
 			{
@@ -2943,7 +4718,8 @@ static WILC_Sint32 Handle_RcvdGnrlAsyncInfo(void * drvHandler,tstrRcvdGnrlAsyncI
 				gu8FlushedInfoElemAsoc = NULL;
 			}
 
-			pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;
+			host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);
+			host_int_wid_cache_invalidate(pstrWFIDrv);
 			gbScanWhileConnected = WILC_FALSE;
 			
 		}else if((u8MacStatus == MAC_DISCONNECTED) &&
@@ -3390,6 +5166,10 @@ static void Handle_Disconnect(void* drvHandler)
 	#endif
 
 	WILC_memset(u8ConnectedSSID,0,ETH_ALEN);
+
+	/* the upper layer is leaving the BSS, nothing to reconnect to */
+	pstrWFIDrv->strFastReconnect.bValid = WILC_FALSE;
+	pstrWFIDrv->strFastReconnect.bLinkLost = WILC_FALSE;
 	
 	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
 	
@@ -3438,7 +5218,8 @@ static void Handle_Disconnect(void* drvHandler)
 
 		gbScanWhileConnected = WILC_FALSE;
 		
-		pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;
+		host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);
+		host_int_wid_cache_invalidate(pstrWFIDrv);
 
 		WILC_memset(pstrWFIDrv->au8AssociatedBSSID, 0, ETH_ALEN);
 
@@ -3559,7 +5340,7 @@ static WILC_Sint32 Handle_GetChnl(void* drvHandler)
 	tstrWILC_WFIDrv * pstrWFIDrv = (tstrWILC_WFIDrv *)drvHandler;
 	strWID.u16WIDid = (WILC_Uint16)WID_CURRENT_CHANNEL;
 	strWID.enuWIDtype = WID_CHAR;
-	strWID.ps8WidVal = (WILC_Sint8 *)&gu8Chnl;
+	strWID.ps8WidVal = (WILC_Sint8 *)&pstrWFIDrv->u8Chnl;
 	strWID.s32ValueSize = sizeof(WILC_Char);
 
 	PRINT_D(HOSTINF_DBG,"Getting channel value\n");
@@ -3586,6 +5367,179 @@ static WILC_Sint32 Handle_GetChnl(void* drvHandler)
 }
 
 
+/**
+*  @brief WID cache
+*  @details 	Per driver handle cache of RSSI, link speed and statistics.
+		Entries are refreshed by the Handle_Get* functions whenever a
+		query succeeds, including the periodic statistics query, and
+		dropped whenever the connection state changes.
+*/
+static const WILC_Uint32 gau32WidCacheTTL[WID_CACHE_ENTRIES] = {
+	WID_CACHE_RSSI_TTL,
+	WID_CACHE_LINKSPEED_TTL,
+	WID_CACHE_STATISTICS_TTL,
+};
+
+static void* host_int_wid_cache_val(tstrWidCache* pstrCache, tenuWidCacheEntry enuEntry, WILC_Uint32* pu32Size)
+{
+	switch(enuEntry)
+	{
+	case WID_CACHE_RSSI:
+		*pu32Size = sizeof(pstrCache->s8Rssi);
+		return &pstrCache->s8Rssi;
+	case WID_CACHE_LINKSPEED:
+		*pu32Size = sizeof(pstrCache->s8LinkSpeed);
+		return &pstrCache->s8LinkSpeed;
+	default:
+		*pu32Size = sizeof(pstrCache->strStatistics);
+		return &pstrCache->strStatistics;
+	}
+}
+
+static void host_int_wid_cache_init(tstrWILC_WFIDrv* pstrWFIDrv)
+{
+	tstrWILC_SemaphoreAttrs strSemaphoreAttrs;
+	tstrWidCache* pstrCache = &pstrWFIDrv->strWidCache;
+	int i;
+
+	WILC_SemaphoreFillDefault(&strSemaphoreAttrs);
+	strSemaphoreAttrs.u32InitCount = 1;
+	spin_lock_init(&pstrCache->lock);
+	for(i = 0; i < WID_CACHE_ENTRIES; i++)
+	{
+		pstrCache->astrEntry[i].bValid = WILC_FALSE;
+		WILC_SemaphoreCreate(&pstrCache->astrEntry[i].hSemFetch, &strSemaphoreAttrs);
+	}
+}
+
+static void host_int_wid_cache_deinit(tstrWILC_WFIDrv* pstrWFIDrv)
+{
+	int i;
+
+	for(i = 0; i < WID_CACHE_ENTRIES; i++)
+		WILC_SemaphoreDestroy(&pstrWFIDrv->strWidCache.astrEntry[i].hSemFetch, NULL);
+}
+
+/* The link changed, nothing cached describes it anymore */
+static void host_int_wid_cache_invalidate(tstrWILC_WFIDrv* pstrWFIDrv)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&pstrWFIDrv->strWidCache.lock, flags);
+	for(i = 0; i < WID_CACHE_ENTRIES; i++)
+		pstrWFIDrv->strWidCache.astrEntry[i].bValid = WILC_FALSE;
+	spin_unlock_irqrestore(&pstrWFIDrv->strWidCache.lock, flags);
+}
+
+static void host_int_wid_cache_update(tstrWILC_WFIDrv* pstrWFIDrv, tenuWidCacheEntry enuEntry, void* pvVal)
+{
+	tstrWidCache* pstrCache = &pstrWFIDrv->strWidCache;
+	unsigned long flags;
+	WILC_Uint32 u32Size;
+	void* pvCached;
+
+	spin_lock_irqsave(&pstrCache->lock, flags);
+	pvCached = host_int_wid_cache_val(pstrCache, enuEntry, &u32Size);
+	WILC_memcpy(pvCached, pvVal, u32Size);
+	pstrCache->astrEntry[enuEntry].bValid = WILC_TRUE;
+	pstrCache->astrEntry[enuEntry].ulStamp = jiffies;
+
+	/* statistics carry the RSSI and link speed too */
+	if(enuEntry == WID_CACHE_STATISTICS)
+	{
+		pstrCache->s8Rssi = pstrCache->strStatistics.s8RSSI;
+		pstrCache->s8LinkSpeed = (WILC_Sint8)pstrCache->strStatistics.u8LinkSpeed;
+		pstrCache->astrEntry[WID_CACHE_RSSI].bValid = WILC_TRUE;
+		pstrCache->astrEntry[WID_CACHE_RSSI].ulStamp = jiffies;
+		pstrCache->astrEntry[WID_CACHE_LINKSPEED].bValid = WILC_TRUE;
+		pstrCache->astrEntry[WID_CACHE_LINKSPEED].ulStamp = jiffies;
+	}
+	spin_unlock_irqrestore(&pstrCache->lock, flags);
+}
+
+/* Copy out a fresh value, returns WILC_FALSE if the entry has to be queried */
+static WILC_Bool host_int_wid_cache_lookup(tstrWILC_WFIDrv* pstrWFIDrv, tenuWidCacheEntry enuEntry, void* pvVal)
+{
+	tstrWidCache* pstrCache = &pstrWFIDrv->strWidCache;
+	tstrWidCacheEntry* pstrEntry = &pstrCache->astrEntry[enuEntry];
+	WILC_Bool bFresh;
+	unsigned long flags;
+	WILC_Uint32 u32Size;
+	void* pvCached;
+
+	spin_lock_irqsave(&pstrCache->lock, flags);
+	bFresh = pstrEntry->bValid &&
+		 time_before(jiffies, pstrEntry->ulStamp + msecs_to_jiffies(gau32WidCacheTTL[enuEntry]));
+	if(bFresh)
+	{
+		pvCached = host_int_wid_cache_val(pstrCache, enuEntry, &u32Size);
+		WILC_memcpy(pvVal, pvCached, u32Size);
+	}
+	spin_unlock_irqrestore(&pstrCache->lock, flags);
+
+	return bFresh;
+}
+
+/*
+ * Answer from the cache if possible, otherwise become the one caller that
+ * queries the chip for this entry. Returns WILC_TRUE with the entry's fetch
+ * semaphore held when the caller has to send the query, and must then call
+ * host_int_wid_cache_fetch_done().
+ */
+static WILC_Bool host_int_wid_cache_fetch_begin(tstrWILC_WFIDrv* pstrWFIDrv, tenuWidCacheEntry enuEntry, void* pvVal)
+{
+	tstrWidCacheEntry* pstrEntry = &pstrWFIDrv->strWidCache.astrEntry[enuEntry];
+
+	if(host_int_wid_cache_lookup(pstrWFIDrv, enuEntry, pvVal))
+	{
+		atomic_inc(&gastrWidCacheStats[enuEntry].Hits);
+		return WILC_FALSE;
+	}
+
+	WILC_SemaphoreAcquire(&pstrEntry->hSemFetch, NULL);
+	/* somebody else's query may have completed while we waited */
+	if(host_int_wid_cache_lookup(pstrWFIDrv, enuEntry, pvVal))
+	{
+		WILC_SemaphoreRelease(&pstrEntry->hSemFetch, NULL);
+		atomic_inc(&gastrWidCacheStats[enuEntry].Coalesced);
+		return WILC_FALSE;
+	}
+
+	atomic_inc(&gastrWidCacheStats[enuEntry].Misses);
+	return WILC_TRUE;
+}
+
+static void host_int_wid_cache_fetch_done(tstrWILC_WFIDrv* pstrWFIDrv, tenuWidCacheEntry enuEntry)
+{
+	WILC_SemaphoreRelease(&pstrWFIDrv->strWidCache.astrEntry[enuEntry].hSemFetch, NULL);
+}
+
+#if defined (WILC_DEBUGFS)
+int host_int_dump_wid_cache_stats(char *buf, int size)
+{
+	static const char* apcNames[WID_CACHE_ENTRIES] = {"rssi", "linkspeed", "statistics"};
+	WILC_Uint32 u32Hits, u32Coalesced, u32Misses, u32Total, u32Answered;
+	int i, len = 0;
+
+	len += scnprintf(buf + len, size - len, "%-12s %10s %10s %10s %6s\n",
+			"wid", "hits", "coalesced", "misses", "hit%");
+	for(i = 0; i < WID_CACHE_ENTRIES; i++)
+	{
+		u32Hits = atomic_read(&gastrWidCacheStats[i].Hits);
+		u32Coalesced = atomic_read(&gastrWidCacheStats[i].Coalesced);
+		u32Misses = atomic_read(&gastrWidCacheStats[i].Misses);
+		u32Answered = u32Hits + u32Coalesced;
+		u32Total = u32Answered + u32Misses;
+		len += scnprintf(buf + len, size - len, "%-12s %10u %10u %10u %6u\n",
+				apcNames[i], u32Hits, u32Coalesced, u32Misses,
+				u32Total ? (u32Answered * 100) / u32Total : 0);
+	}
+
+	return len;
+}
+#endif
+
 /**
 *  @brief Handle_GetRssi
 *  @details 	   Sending config packet to get RSSI
@@ -3603,7 +5557,7 @@ static void Handle_GetRssi(void* drvHandler)
 		
 	strWID.u16WIDid = (WILC_Uint16)WID_RSSI;
 	strWID.enuWIDtype = WID_CHAR;
-	strWID.ps8WidVal = &gs8Rssi;
+	strWID.ps8WidVal = &pstrWFIDrv->s8Rssi;
 	strWID.s32ValueSize = sizeof(WILC_Char);
 
 	/*Sending Cfg*/
@@ -3615,6 +5569,7 @@ static void Handle_GetRssi(void* drvHandler)
 		PRINT_ER("Failed to get RSSI value\n");
 		WILC_ERRORREPORT(s32Error, WILC_FAIL);
 	}	
+	host_int_wid_cache_update(pstrWFIDrv, WID_CACHE_RSSI, &pstrWFIDrv->s8Rssi);
 	
 	WILC_CATCH(s32Error)
 	{
@@ -3632,11 +5587,11 @@ static void Handle_GetLinkspeed(void* drvHandler)
 	tstrWID strWID;
 	tstrWILC_WFIDrv* pstrWFIDrv=(tstrWILC_WFIDrv*)drvHandler;
 
-	gs8lnkspd = 0;
+	pstrWFIDrv->s8LinkSpeed = 0;
 	
 	strWID.u16WIDid = (WILC_Uint16)WID_LINKSPEED;
 	strWID.enuWIDtype = WID_CHAR;
-	strWID.ps8WidVal = &gs8lnkspd;
+	strWID.ps8WidVal = &pstrWFIDrv->s8LinkSpeed;
 	strWID.s32ValueSize = sizeof(WILC_Char);
 	/*Sending Cfg*/
 	PRINT_D(HOSTINF_DBG,"Getting LINKSPEED value\n");
@@ -3647,6 +5602,7 @@ static void Handle_GetLinkspeed(void* drvHandler)
 		PRINT_ER("Failed to get LINKSPEED value\n");
 		WILC_ERRORREPORT(s32Error, WILC_FAIL);
 	}	
+	host_int_wid_cache_update(pstrWFIDrv, WID_CACHE_LINKSPEED, &pstrWFIDrv->s8LinkSpeed);
 	
 	WILC_CATCH(s32Error)
 	{
@@ -3706,6 +5662,10 @@ WILC_Sint32 Handle_GetStatistics(void * drvHandler,tstrStatistics* pstrStatistic
 		PRINT_ER("Failed to send scan paramters config packet\n");
 		//WILC_ERRORREPORT(s32Error, s32Error);
 	}
+	else
+	{
+		host_int_wid_cache_update((tstrWILC_WFIDrv*)drvHandler, WID_CACHE_STATISTICS, pstrStatistics);
+	}
 	#ifdef TCP_ENHANCEMENTS
 	if((pstrStatistics->u8LinkSpeed > TCP_ACK_FILTER_LINK_SPEED_THRESH) && (pstrStatistics->u8LinkSpeed != DEFAULT_LINK_SPEED))
 	{
@@ -3719,7 +5679,7 @@ WILC_Sint32 Handle_GetStatistics(void * drvHandler,tstrStatistics* pstrStatistic
 	}
 	#endif
 	if(pstrStatistics != &gDummyStatistics)
-		WILC_SemaphoreRelease(&hWaitResponse, NULL);
+		WILC_SemaphoreRelease(host_int_response_sem(drvHandler), NULL);
 	return 0;
 	
 }
@@ -3772,7 +5732,7 @@ static WILC_Sint32 Handle_Get_InActiveTime(void* drvHandler,tstrHostIfStaInactiv
 	
 	strWID.u16WIDid = (WILC_Uint16)WID_GET_INACTIVE_TIME;
 	strWID.enuWIDtype = WID_INT;
-	strWID.ps8WidVal = (WILC_Sint8*)&gu32InactiveTime;
+	strWID.ps8WidVal = (WILC_Sint8*)&pstrWFIDrv->u32InactiveTime;
 	strWID.s32ValueSize = sizeof(WILC_Uint32);
 
 	
@@ -3785,7 +5745,7 @@ static WILC_Sint32 Handle_Get_InActiveTime(void* drvHandler,tstrHostIfStaInactiv
 	}
 
 
-	PRINT_D(CFG80211_DBG,"Getting inactive time : %d\n",gu32InactiveTime);
+	PRINT_D(CFG80211_DBG,"Getting inactive time : %d\n",pstrWFIDrv->u32InactiveTime);
 	
 	WILC_SemaphoreRelease(&(pstrWFIDrv->hSemInactiveTime), WILC_NULL);
 	WILC_CATCH(s32Error)
@@ -3859,7 +5819,7 @@ static void Handle_AddBeacon(void* drvHandler,tstrHostIFSetBeacon* pstrSetBeacon
 
 	
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = SendConfigPktAsync(&strWID, 1, (WILC_Uint32)pstrWFIDrv);
 	if(s32Error)
 	{
 		PRINT_ER("Failed to send add beacon config packet\n");
@@ -3906,7 +5866,7 @@ static void Handle_DelBeacon(void* drvHandler,tstrHostIFDelBeacon* pstrDelBeacon
 	/* TODO: build del beacon message*/
 
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = SendConfigPktAsync(&strWID, 1, (WILC_Uint32)pstrWFIDrv);
 	if(s32Error)
 	{
 	
@@ -4006,7 +5966,7 @@ static void Handle_AddStation(void* drvHandler,tstrWILC_AddStaParam* pstrStation
 	pu8CurrByte += WILC_HostIf_PackStaParam(pu8CurrByte, pstrStationParam);
 
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = SendConfigPktAsync(&strWID, 1, (WILC_Uint32)pstrWFIDrv);
 	if(s32Error != WILC_SUCCESS)
 	{
 	
@@ -4078,7 +6038,7 @@ static void Handle_DelAllSta(void * drvHandler,tstrHostIFDelAllSta* pstrDelAllSt
 	}
 	WILC_FREE_IF_TRUE(strWID.ps8WidVal);
 
-	WILC_SemaphoreRelease(&hWaitResponse, NULL);	
+	WILC_SemaphoreRelease(host_int_response_sem(drvHandler), NULL);	
 }
 
 
@@ -4115,7 +6075,7 @@ static void Handle_DelStation(void * drvHandler,tstrHostIFDelSta* pstrDelStaPara
 	WILC_memcpy(pu8CurrByte, pstrDelStaParam->au8MacAddr, ETH_ALEN);
 
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = SendConfigPktAsync(&strWID, 1, (WILC_Uint32)pstrWFIDrv);
 	if(s32Error)
 	{
 	
@@ -4161,7 +6121,7 @@ static void Handle_EditStation(void* drvHandler,tstrWILC_AddStaParam* pstrStatio
 	pu8CurrByte += WILC_HostIf_PackStaParam(pu8CurrByte, pstrStationParam);
 
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = SendConfigPktAsync(&strWID, 1, (WILC_Uint32)pstrWFIDrv);
 	if(s32Error)
 	{
 	
@@ -4411,7 +6371,7 @@ static void ListenTimerCB(void* pvArg)
 	strHostIFmsg.uniHostIFmsgBody.strHostIfRemainOnChan.u32ListenSessionID = pstrWFIDrv->strHostIfRemainOnChan.u32ListenSessionID;
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -4456,7 +6416,7 @@ static void Handle_PowerManagement(void* drvHandler,tstrHostIfPowerMgmtParam* st
 	PRINT_D(HOSTINF_DBG,"Handling Power Management\n");
 	
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_TRUE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = host_int_set_cfg_shadowed(pstrWFIDrv, &strWID, 1, WILC_TRUE);
 	if(s32Error)
 	{
 		PRINT_ER("Failed to send power management config packet\n");
@@ -4510,7 +6470,7 @@ static void Handle_SetMulticastFilter(void * drvHandler,tstrHostIFSetMulti*		str
 		memcpy(pu8CurrByte, gau8MulticastMacAddrList, ((strHostIfSetMulti->u32count) * ETH_ALEN));
 	
 	/*Sending Cfg*/
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_FALSE,(WILC_Uint32)drvHandler);
+	s32Error = host_int_set_cfg_shadowed((tstrWILC_WFIDrv*)drvHandler, &strWID, 1, WILC_FALSE);
 	if(s32Error)
 	{
 		PRINT_ER("Failed to send setup multicast config packet\n");
@@ -4679,7 +6639,7 @@ static WILC_Sint32 Handle_DelBASession(void * drvHandler, tstrHostIfBASessionInf
 		WILC_FREE(strWID.ps8WidVal);
 
 	/*BugID_5222*/
-	WILC_SemaphoreRelease(&hWaitResponse, NULL);
+	WILC_SemaphoreRelease(host_int_response_sem(drvHandler), NULL);
 	
 	return s32Error;
 
@@ -4733,7 +6693,7 @@ static WILC_Sint32 Handle_DelAllRxBASessions(void * drvHandler, tstrHostIfBASess
 		WILC_FREE(strWID.ps8WidVal);
 
 	/*BugID_5222*/
-	WILC_SemaphoreRelease(&hWaitResponse, NULL);
+	WILC_SemaphoreRelease(host_int_response_sem(drvHandler), NULL);
 	
 	return s32Error;
 
@@ -4750,7 +6710,7 @@ static WILC_Sint32 Handle_SetTxPwr(void * drvHandler, WILC_Uint8 u8TxPwr)
 	strWID.ps8WidVal = (WILC_Sint8*)&u8TxPwr;
 	strWID.s32ValueSize = sizeof(WILC_Char);	
 
-	s32Error = SendConfigPkt(SET_CFG, &strWID, 1, WILC_TRUE,(WILC_Uint32)pstrWFIDrv);
+	s32Error = host_int_set_cfg_shadowed(pstrWFIDrv, &strWID, 1, WILC_TRUE);
 
 	if(s32Error)
 	{
@@ -4784,7 +6744,7 @@ static WILC_Sint32 Handle_GetTxPwr(void * drvHandler, WILC_Uint8* pu8TxPwr)
 		PRINT_ER("Failed to send scan paramters config packet\n");
 		//WILC_ERRORREPORT(s32Error, s32Error);
 	}
-	WILC_SemaphoreRelease(&hWaitResponse, NULL);
+	WILC_SemaphoreRelease(host_int_response_sem(drvHandler), NULL);
 	return s32Error; 
 }
 
@@ -4819,15 +6779,20 @@ static WILC_Sint32 Handle_SetAntennaMode(void * drvHandler, WILC_Uint8 u8Antenna
 */
 static void hostIFthread(void* pvArg)
 {
-	WILC_Uint32 u32Ret;
+	tstrHostIFWorker* pstrWorker = (tstrHostIFWorker*)pvArg;
 	tstrHostIFmsg strHostIFmsg;
 	tstrWILC_WFIDrv * pstrWFIDrv ;
+	ktime_t tStart;
 
 	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
 	
 	while(1)
 	{
-		WILC_MsgQueueRecv(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), &u32Ret, WILC_NULL);				
+		if(host_int_recv_msg(pstrWorker, &strHostIFmsg) != WILC_SUCCESS)
+		{
+			continue;
+		}
+		tStart = ktime_get();
 		pstrWFIDrv = (tstrWILC_WFIDrv *)strHostIFmsg.drvHandler;
 		if(strHostIFmsg.u16MsgId == HOST_IF_MSG_EXIT)
 		{
@@ -4835,20 +6800,22 @@ static void hostIFthread(void* pvArg)
 			break;
 		}
 
+		host_int_arbiter_acquire();
 
-		/*Re-Queue HIF message*/
-		if((!g_wilc_initialized))
+		/*Park HIF message till the driver is initialized, the idle barrier
+		  has to get through*/
+		if((!g_wilc_initialized) && (strHostIFmsg.u16MsgId != HOST_IF_MSG_Q_IDLE)
+			&& host_int_defer_msg(&strHostIFmsg, HOST_IF_WAIT_INIT))
 		{
 			PRINT_D(GENERIC_DBG, "--WAIT--");
-			WILC_Sleep(200);
-			WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);	
+			host_int_arbiter_release();
 			continue;
 		}
 	
-		if(strHostIFmsg.u16MsgId == HOST_IF_MSG_CONNECT && pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult != NULL){
-			PRINT_D(HOSTINF_DBG,"Requeue connect request till scan done received\n");
-			WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
-			WILC_Sleep(2);
+		if(strHostIFmsg.u16MsgId == HOST_IF_MSG_CONNECT && pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult != NULL
+			&& host_int_defer_msg(&strHostIFmsg, HOST_IF_WAIT_SCAN_DONE)){
+			PRINT_D(HOSTINF_DBG,"Defer connect request till scan done received\n");
+			host_int_arbiter_release();
 			continue;
 		}
 		
@@ -4861,11 +6828,13 @@ static void hostIFthread(void* pvArg)
 			}
 			case HOST_IF_MSG_SCAN:
 			{
+				pstrWFIDrv->strFastReconnect.bScanned = WILC_TRUE;
 				Handle_Scan(strHostIFmsg.drvHandler,&strHostIFmsg.uniHostIFmsgBody.strHostIFscanAttr);
 				break;
 			}			
 			case HOST_IF_MSG_CONNECT:
 			{
+				host_int_conn_trace(pstrWFIDrv, CONN_TRACE_CONNECT, 0);
 				Handle_Connect(strHostIFmsg.drvHandler,&strHostIFmsg.uniHostIFmsgBody.strHostIFconnectAttr);
 				break;
 			}
@@ -4884,12 +6853,22 @@ static void hostIFthread(void* pvArg)
 			}
 			case HOST_IF_MSG_RCVD_GNRL_ASYNC_INFO:
 			{
+				host_int_conn_trace(pstrWFIDrv, CONN_TRACE_ASYNC_HANDLED, 0);
 				Handle_RcvdGnrlAsyncInfo(strHostIFmsg.drvHandler,&strHostIFmsg.uniHostIFmsgBody.strRcvdGnrlAsyncInfo);
 				break;
 			}
 			case HOST_IF_MSG_KEY:
 			{
+				host_int_conn_trace(pstrWFIDrv, CONN_TRACE_KEY, strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr.enuKeyType);
 				Handle_Key(strHostIFmsg.drvHandler,&strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr);
+				host_int_conn_trace(pstrWFIDrv, CONN_TRACE_KEY_DONE, strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr.enuKeyType);
+				/* the pairwise key completes the connection */
+				if((pstrWFIDrv != WILC_NULL)
+					&& (strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr.enuKeyType == WPAPtk)
+					&& (strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr.u8KeyAction & ADDKEY))
+				{
+					host_int_link_ready(pstrWFIDrv);
+				}
 				break;
 			}
 			case HOST_IF_MSG_CFG_PARAMS:
@@ -5120,10 +7099,20 @@ static void hostIFthread(void* pvArg)
 				break;
 			}
 		}
+
+		host_int_msg_stats_update(&strHostIFmsg, tStart);
+
+		/* scans only end in a handler: on scan done, abort or failure */
+		if(gastrHostIFWaitList[HOST_IF_WAIT_SCAN_DONE].pstrHead != WILC_NULL)
+		{
+			host_int_release_deferred(HOST_IF_WAIT_SCAN_DONE);
+		}
+
+		host_int_arbiter_release();
 	}
 
 	PRINT_D(HOSTINF_DBG,"Releasing thread exit semaphore\n");
-	WILC_SemaphoreRelease(&hSemHostIFthrdEnd, WILC_NULL);
+	WILC_SemaphoreRelease(&pstrWorker->hSemThreadEnd, WILC_NULL);
 	return;
 	//do_exit(error);
 	//PRINT_D(HOSTINF_DBG,"do_exit error code %d\n",error);
@@ -5140,7 +7129,7 @@ static void TimerCB_Scan(void* pvArg)
 	strHostIFmsg.u16MsgId = HOST_IF_MSG_SCAN_TIMER_FIRED;
 
 	// send the message 
-	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	host_int_post_msg(&strHostIFmsg);
 }
 
 static void TimerCB_Connect(void* pvArg)
@@ -5153,7 +7142,7 @@ static void TimerCB_Connect(void* pvArg)
 	strHostIFmsg.u16MsgId = HOST_IF_MSG_CONNECT_TIMER_FIRED;
 
 	/* send the message */
-	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	host_int_post_msg(&strHostIFmsg);
 }
 
 
@@ -5226,7 +7215,7 @@ WILC_Sint32 host_int_remove_wep_key(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8 u8keyId
 				uniHostIFkeyAttr.strHostIFwepAttr.u8Wepidx = u8keyIdx;
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Error in sending message queue : Request to remove WEP key \n");
 	else
@@ -5277,7 +7266,7 @@ WILC_Sint32 host_int_set_WEPDefaultKeyID(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8 u8
 		uniHostIFkeyAttr.strHostIFwepAttr.u8Wepidx = u8Index;
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Error in sending message queue : Default key index\n");
 	else
@@ -5347,7 +7336,7 @@ WILC_Sint32 host_int_add_wep_key_bss_sta(WILC_WFIDrvHandle hWFIDrv, const WILC_U
 				uniHostIFkeyAttr.strHostIFwepAttr.u8Wepidx = u8Keyidx;
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Error in sending message queue :WEP Key\n");
 	else		
@@ -5426,7 +7415,7 @@ WILC_Sint32 host_int_add_wep_key_bss_ap(WILC_WFIDrvHandle hWFIDrv, const WILC_Ui
 	strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr.
 				uniHostIFkeyAttr.strHostIFwepAttr.tenuAuth_type = tenuAuth_type;
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 
 	if(s32Error)
 		PRINT_ER("Error in sending message queue :WEP Key\n");
@@ -5536,7 +7525,7 @@ WILC_Sint32 host_int_add_ptk(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8* pu8Ptk,WILC_U
 	strHostIFmsg.drvHandler= hWFIDrv;
 	
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 
 	if(s32Error)
 		PRINT_ER("Error in sending message queue:  PTK Key\n");
@@ -5646,7 +7635,7 @@ WILC_Sint32 host_int_add_rx_gtk(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* pu8RxGtk,
 	
 	
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Error in sending message queue:  RX GTK\n");
 	else
@@ -5705,7 +7694,7 @@ WILC_Sint32 host_int_add_tx_gtk(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8 u8KeyLen,WI
 	strHostIFmsg.uniHostIFmsgBody.strHostIFkeyAttr.uniHostIFkeyAttr.strHostIFwpaAttr.u8Keylen = u8KeyLen;
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error) {
 		PRINT_ER("Error in sending message queue: TX GTK\n");
 	} else {
@@ -5772,7 +7761,7 @@ WILC_Sint32 host_int_set_pmkid_info(WILC_WFIDrvHandle hWFIDrv, tstrHostIFpmkidAt
 	}
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER(" Error in sending messagequeue: PMKID Info\n");
 
@@ -5877,13 +7866,13 @@ WILC_Sint32 host_int_get_MacAddress(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8* pu8Mac
 	strHostIFmsg.uniHostIFmsgBody.strHostIfGetMacAddress.u8MacAddress = pu8MacAddress;
 	strHostIFmsg.drvHandler=hWFIDrv;
 	/* send the message */
-	s32Error = 	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = 	host_int_post_msg(&strHostIFmsg);
 	if(s32Error){
 		PRINT_ER("Failed to send get mac address\n");
 		return WILC_FAIL;
 	}
 
-	WILC_SemaphoreAcquire(&hWaitResponse, NULL);	
+	WILC_SemaphoreAcquire(host_int_response_sem(hWFIDrv), NULL);	
 	return s32Error;
 }
 
@@ -5911,7 +7900,7 @@ WILC_Sint32 host_int_set_MacAddress(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8* pu8Mac
 	WILC_memcpy(strHostIFmsg.uniHostIFmsgBody.strHostIfSetMacAddress.u8MacAddress, pu8MacAddress, ETH_ALEN);
 	strHostIFmsg.drvHandler=hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		PRINT_ER("Failed to send message queue: Set mac address\n");
@@ -6173,13 +8162,13 @@ WILC_Sint32 host_int_set_join_req(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* pu8bssi
 	}
 	if(pstrWFIDrv->enuHostIFstate<HOST_IF_CONNECTING)
 	{
-		pstrWFIDrv->enuHostIFstate = HOST_IF_CONNECTING;
+		host_int_set_state(pstrWFIDrv, HOST_IF_CONNECTING);
 	}
 	else
 		PRINT_D(GENERIC_DBG,"Don't set state to 'connecting' as state is %d\n",pstrWFIDrv->enuHostIFstate);
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		PRINT_ER("Failed to send message queue: Set join request\n");
@@ -6231,7 +8220,7 @@ WILC_Sint32 host_int_flush_join_req(WILC_WFIDrvHandle hWFIDrv)
 	strHostIFmsg.drvHandler= hWFIDrv;
 	
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		PRINT_ER("Failed to send message queue: Flush join request\n");
@@ -6281,7 +8270,7 @@ WILC_Sint32 host_int_disconnect(WILC_WFIDrvHandle hWFIDrv, WILC_Uint16 u16Reason
 	strHostIFmsg.drvHandler=hWFIDrv;
 	
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Failed to send message queue: disconnect\n");
 	else	
@@ -6475,7 +8464,7 @@ WILC_Sint32 host_int_set_mac_chnl_num(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8 u8ChN
 	strHostIFmsg.uniHostIFmsgBody.strHostIFSetChan.u8SetChan= u8ChNum;
 	strHostIFmsg.drvHandler=hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -6492,32 +8481,59 @@ WILC_Sint32 host_int_set_mac_chnl_num(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8 u8ChN
 WILC_Sint32 host_int_wait_msg_queue_idle(void)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;
-
+	tstrHostIFWorker* pstrWorker;
 	tstrHostIFmsg strHostIFmsg;
+	WILC_Uint32 u32Queued = 0;
+	unsigned long flags;
+	int w;
 
-	/* prepare the set driver handler message */
-	
+	/* one Q_IDLE per worker: the barrier is passed once all of them had
+	   handled what was queued before it */
 	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
 	strHostIFmsg.u16MsgId = HOST_IF_MSG_Q_IDLE;
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
-	if(s32Error)
+	strHostIFmsg.tQueued = ktime_get();
+
+	spin_lock_irqsave(&gHostIFWorkerLock, flags);
+	for(w = -1; w < HOST_IF_MAX_WORKERS; w++)
 	{
-		WILC_ERRORREPORT(s32Error, s32Error);
+		pstrWorker = (w < 0) ? &gstrHostIFWorker : gapstrHostIFWorkers[w];
+		if(pstrWorker == WILC_NULL)
+		{
+			continue;
+		}
+		if(host_int_worker_queue_msg(pstrWorker, &strHostIFmsg, host_int_msg_lane(HOST_IF_MSG_Q_IDLE)) != WILC_SUCCESS)
+		{
+			s32Error = WILC_FAIL;
+			continue;
+		}
+		u32Queued++;
 	}
-	
-	// wait untill MSG Q is empty
-	WILC_SemaphoreAcquire(&hWaitResponse, NULL);
+	spin_unlock_irqrestore(&gHostIFWorkerLock, flags);
 
-	WILC_CATCH(s32Error)
+	/* a worker stopped meanwhile handles its Q_IDLE before exiting */
+	while(u32Queued--)
 	{
-	
+		WILC_SemaphoreAcquire(&hSemQueueIdle, NULL);
 	}
-	
+
+	/* nothing queued from now on is handled until the next init */
+	host_int_set_initialized(0);
+
+	if(s32Error)
+	{
+		PRINT_ER("Failed to queue the idle barrier\n");
+	}
+
 	return s32Error;
-	
 }
 
-WILC_Sint32 host_int_set_wfi_drv_handler(WILC_Uint32 u32address,WILC_Uint8 u8MacIndex)
+void host_int_resume_msg_queue(void)
+{
+	host_int_set_initialized(1);
+}
+
+/* The message goes to the worker of drvHandler, behind what is queued for it */
+static WILC_Sint32 host_int_post_wfi_drv_handler(void* drvHandler, WILC_Uint32 u32address, WILC_Uint8 u8MacIndex)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;
 
@@ -6530,9 +8546,9 @@ WILC_Sint32 host_int_set_wfi_drv_handler(WILC_Uint32 u32address,WILC_Uint8 u8Mac
 	strHostIFmsg.u16MsgId = HOST_IF_MSG_SET_WFIDRV_HANDLER;
 	strHostIFmsg.uniHostIFmsgBody.strHostIfSetDrvHandler.u32Address=u32address;
 	strHostIFmsg.uniHostIFmsgBody.strHostIfSetDrvHandler.u8MacIndex = u8MacIndex;
-	//strHostIFmsg.drvHandler=hWFIDrv;
+	strHostIFmsg.drvHandler=drvHandler;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -6545,6 +8561,15 @@ WILC_Sint32 host_int_set_wfi_drv_handler(WILC_Uint32 u32address,WILC_Uint8 u8Mac
 	return s32Error;
 }
 
+/*
+ * Handled by the worker of the handle being set, so that the messages
+ * posted for that handle afterwards don't run ahead of it.
+ */
+WILC_Sint32 host_int_set_wfi_drv_handler(WILC_Uint32 u32address,WILC_Uint8 u8MacIndex)
+{
+	return host_int_post_wfi_drv_handler((void*)u32address, u32address, u8MacIndex);
+}
+
 
 
 WILC_Sint32 host_int_set_operation_mode(WILC_WFIDrvHandle hWFIDrv, WILC_Uint32 u32mode)
@@ -6561,7 +8586,7 @@ WILC_Sint32 host_int_set_operation_mode(WILC_WFIDrvHandle hWFIDrv, WILC_Uint32 u
 	strHostIFmsg.uniHostIFmsgBody.strHostIfSetOperationMode.u32Mode=u32mode;
 	strHostIFmsg.drvHandler=hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -6608,14 +8633,14 @@ WILC_Sint32 host_int_get_host_chnl_num(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* pu
 	strHostIFmsg.drvHandler=hWFIDrv;
 
 	/* send the message */
-	s32Error = 	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = 	host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Failed to send get host channel param's message queue ");
 	else
 		WILC_SemaphoreAcquire(&(pstrWFIDrv->hSemGetCHNL), NULL);
 	//gu8Chnl = 11;
 
-	*pu8ChNo = gu8Chnl;
+	*pu8ChNo = pstrWFIDrv->u8Chnl;
 
 	WILC_CATCH(s32Error)
 	{}
@@ -6709,13 +8734,13 @@ WILC_Sint32 host_int_get_inactive_time(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 * m
 	strHostIFmsg.drvHandler=hWFIDrv;
        
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER("Failed to send get host channel param's message queue ");
 	else
 		WILC_SemaphoreAcquire(&(pstrWFIDrv->hSemInactiveTime), NULL);
 	
-	*pu32InactiveTime = gu32InactiveTime;
+	*pu32InactiveTime = pstrWFIDrv->u32InactiveTime;
 
 	WILC_CATCH(s32Error)
 	{}
@@ -6792,6 +8817,14 @@ WILC_Sint32 host_int_get_rssi(WILC_WFIDrvHandle hWFIDrv, WILC_Sint8* ps8Rssi)
 	tstrHostIFmsg strHostIFmsg;
 	tstrWILC_WFIDrv* pstrWFIDrv=(tstrWILC_WFIDrv*)hWFIDrv;
 
+	if(ps8Rssi == NULL)
+	{
+		PRINT_ER("RSS pointer value is null");
+		return WILC_FAIL;
+	}
+
+	if(!host_int_wid_cache_fetch_begin(pstrWFIDrv, WID_CACHE_RSSI, ps8Rssi))
+		return WILC_SUCCESS;
 	
 	/* prepare the Get RSSI Message */
 	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
@@ -6800,24 +8833,17 @@ WILC_Sint32 host_int_get_rssi(WILC_WFIDrvHandle hWFIDrv, WILC_Sint8* ps8Rssi)
 	strHostIFmsg.drvHandler=hWFIDrv;
 
 	/* send the message */
-	s32Error = 	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = 	host_int_post_msg(&strHostIFmsg);
 	if(s32Error){
 		PRINT_ER("Failed to send get host channel param's message queue ");
+		host_int_wid_cache_fetch_done(pstrWFIDrv, WID_CACHE_RSSI);
 		return WILC_FAIL;
 		}
 
 	WILC_SemaphoreAcquire(&(pstrWFIDrv->hSemGetRSSI), NULL);
 	
-	
-	if(ps8Rssi == NULL)
-	{
-		PRINT_ER("RSS pointer value is null");
-		return WILC_FAIL;
-	}
-
-
-	*ps8Rssi = gs8Rssi;
-
+	*ps8Rssi = pstrWFIDrv->s8Rssi;
+	host_int_wid_cache_fetch_done(pstrWFIDrv, WID_CACHE_RSSI);
 	
 	return s32Error;
 }
@@ -6829,7 +8855,14 @@ WILC_Sint32 host_int_get_link_speed(WILC_WFIDrvHandle hWFIDrv, WILC_Sint8* ps8ln
 
 	tstrWILC_WFIDrv* pstrWFIDrv=(tstrWILC_WFIDrv*)hWFIDrv;
 	
+	if(ps8lnkspd == NULL)
+	{
+		PRINT_ER("LINKSPEED pointer value is null");
+		return WILC_FAIL;
+	}
 
+	if(!host_int_wid_cache_fetch_begin(pstrWFIDrv, WID_CACHE_LINKSPEED, ps8lnkspd))
+		return WILC_SUCCESS;
 	
 	/* prepare the Get LINKSPEED Message */
 	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
@@ -6838,24 +8871,17 @@ WILC_Sint32 host_int_get_link_speed(WILC_WFIDrvHandle hWFIDrv, WILC_Sint8* ps8ln
 	strHostIFmsg.drvHandler=hWFIDrv;
 
 	/* send the message */
-	s32Error = 	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = 	host_int_post_msg(&strHostIFmsg);
 	if(s32Error){
 		PRINT_ER("Failed to send GET_LINKSPEED to message queue ");
+		host_int_wid_cache_fetch_done(pstrWFIDrv, WID_CACHE_LINKSPEED);
 		return WILC_FAIL;
 		}
 
 	WILC_SemaphoreAcquire(&(pstrWFIDrv->hSemGetLINKSPEED), NULL);
 	
-	
-	if(ps8lnkspd == NULL)
-	{
-		PRINT_ER("LINKSPEED pointer value is null");
-		return WILC_FAIL;
-	}
-
-
-	*ps8lnkspd = gs8lnkspd;
-
+	*ps8lnkspd = pstrWFIDrv->s8LinkSpeed;
+	host_int_wid_cache_fetch_done(pstrWFIDrv, WID_CACHE_LINKSPEED);
 	
 	return s32Error;
 }
@@ -6864,7 +8890,16 @@ WILC_Sint32 host_int_get_statistics(WILC_WFIDrvHandle hWFIDrv, tstrStatistics* p
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;	
 	tstrHostIFmsg strHostIFmsg;
+	tstrWILC_WFIDrv* pstrWFIDrv=(tstrWILC_WFIDrv*)hWFIDrv;
+	WILC_Bool bFetch = WILC_FALSE;
 
+	/* the periodic query runs from a timer: it only refreshes the cache */
+	if(pstrStatistics != &gDummyStatistics)
+	{
+		if(!host_int_wid_cache_fetch_begin(pstrWFIDrv, WID_CACHE_STATISTICS, pstrStatistics))
+			return WILC_SUCCESS;
+		bFetch = WILC_TRUE;
+	}
 	
 	/* prepare the Get RSSI Message */
 	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
@@ -6873,14 +8908,19 @@ WILC_Sint32 host_int_get_statistics(WILC_WFIDrvHandle hWFIDrv, tstrStatistics* p
 	strHostIFmsg.uniHostIFmsgBody.pUserData =(WILC_Char*)pstrStatistics;
 	strHostIFmsg.drvHandler=hWFIDrv;
 	/* send the message */
-	s32Error = 	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = 	host_int_post_msg(&strHostIFmsg);
 	if(s32Error){
 		PRINT_ER("Failed to send get host channel param's message queue ");
+		if(bFetch)
+			host_int_wid_cache_fetch_done(pstrWFIDrv, WID_CACHE_STATISTICS);
 		return WILC_FAIL;
 		}
 	/*if the dummy sta. don't wait fore the result */
-	if(pstrStatistics != &gDummyStatistics)
-		WILC_SemaphoreAcquire(&hWaitResponse, NULL);	
+	if(bFetch)
+	{
+		WILC_SemaphoreAcquire(host_int_response_sem(hWFIDrv), NULL);	
+		host_int_wid_cache_fetch_done(pstrWFIDrv, WID_CACHE_STATISTICS);
+	}
 	return s32Error;
 }
 
@@ -6953,7 +8993,7 @@ WILC_Sint32 host_int_scan(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 u8ScanSource,
 					  pu8IEs, IEsLen);	
 
 		/* send the message */
-		s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+		s32Error = host_int_post_msg(&strHostIFmsg);
 		if(s32Error)
 		{
 			PRINT_ER("Error in sending message queue scanning parameters: Error(%d)\n",s32Error);
@@ -7002,7 +9042,7 @@ WILC_Sint32 hif_set_cfg(WILC_WFIDrvHandle hWFIDrv, tstrCfgParamVal * pstrCfgPara
 	strHostIFmsg.uniHostIFmsgBody.strHostIFCfgParamAttr.pstrCfgParamVal = *pstrCfgParamVal;
 	strHostIFmsg.drvHandler=hWFIDrv;
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 
 	WILC_CATCH(s32Error)
 	{
@@ -7263,6 +9303,7 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 		goto _fail_timer_2;
 	}
 	WILC_memset(pstrWFIDrv,0,sizeof(tstrWILC_WFIDrv));
+	spin_lock_init(&pstrWFIDrv->strWidShadow.lock);
 	/*return driver handle to user*/
 	*phWFIDrv = (WILC_WFIDrvHandle)pstrWFIDrv;
 	/*save into globl handle*/
@@ -7276,9 +9317,6 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 	/////////////////////////////////////////
 	if(clients_count==0)
 	{	
-		strSemaphoreAttrs.u32InitCount = 0;
-		WILC_SemaphoreCreate(&hSemHostIFthrdEnd, &strSemaphoreAttrs);
-	
     	strSemaphoreAttrs.u32InitCount = 0;
 		WILC_SemaphoreCreate(&hSemDeinitDrvHandle, &strSemaphoreAttrs);
 
@@ -7297,8 +9335,11 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 	WILC_SemaphoreCreate(&(pstrWFIDrv->hSemGetLINKSPEED), &strSemaphoreAttrs);
 	strSemaphoreAttrs.u32InitCount = 0;
 	WILC_SemaphoreCreate(&(pstrWFIDrv->hSemGetCHNL), &strSemaphoreAttrs);
+	host_int_wid_cache_init(pstrWFIDrv);
 	strSemaphoreAttrs.u32InitCount = 0;
 	WILC_SemaphoreCreate(&(pstrWFIDrv->hSemInactiveTime), &strSemaphoreAttrs);	
+	strSemaphoreAttrs.u32InitCount = 0;
+	WILC_SemaphoreCreate(&(pstrWFIDrv->hSemWaitResponse), &strSemaphoreAttrs);
 
 	/////////////////////////////////////////
 
@@ -7309,7 +9350,7 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 	if(clients_count==0)
 	{
 
-		s32Error = WILC_MsgQueueCreate(&gMsgQHostIF, WILC_NULL);
+		s32Error = host_int_create_msg_queues();
 	
 
 		if(s32Error < 0)
@@ -7317,13 +9358,8 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 			PRINT_ER("Failed to creat MQ\n");
 			goto _fail_;
 		}
+		host_int_set_initialized(1);
 		msgQ_created=1;
-		s32Error = WILC_ThreadCreate(&HostIFthreadHandler,hostIFthread, WILC_NULL, WILC_NULL);
-		if(s32Error < 0)
-		{
-			PRINT_ER("Failed to creat Thread\n");
-			goto _fail_mq_;
-		}
 		s32Error = WILC_TimerCreate(&(g_hPeriodicRSSI),GetPeriodicRSSI, WILC_NULL);
 		if(s32Error < 0)
 		{
@@ -7366,7 +9402,7 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 	TransportInit();
 #endif
 	
-	pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;
+	host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);
 	//gWFiDrvHandle->bPendingConnRequest = WILC_FALSE;
 
 	/*Initialize CFG WIDS Defualt Values*/
@@ -7406,6 +9442,8 @@ WILC_Sint32 host_int_init(WILC_WFIDrvHandle* phWFIDrv)
 	CoreConfigSimulatorInit();
 #endif
 
+	host_int_worker_start(pstrWFIDrv);
+
 	u32Intialized = 1;
 	clients_count++;//increase number of created entities
 
@@ -7425,9 +9463,8 @@ _fail_timer_2:
 _fail_timer_1:
 	WILC_TimerDestroy(&(pstrWFIDrv->hScanTimer),WILC_NULL);
 _fail_thread_:
-	WILC_ThreadDestroy(&HostIFthreadHandler, WILC_NULL);
 _fail_mq_:
-	WILC_MsgQueueDestroy(&gMsgQHostIF, WILC_NULL);
+	host_int_destroy_msg_queues();
 _fail_:
 	return s32Error;
 	
@@ -7446,7 +9483,6 @@ _fail_:
 WILC_Sint32 host_int_deinit(WILC_WFIDrvHandle hWFIDrv)
 {
 	WILC_Sint32 s32Error = WILC_SUCCESS;
-	tstrHostIFmsg strHostIFmsg;
 	
 
 	/*obtain driver handle*/
@@ -7494,9 +9530,13 @@ WILC_Sint32 host_int_deinit(WILC_WFIDrvHandle hWFIDrv)
 	WILC_TimerDestroy(&(pstrWFIDrv->hRemainOnChannel), WILC_NULL);
 	#endif
 	
-	host_int_set_wfi_drv_handler((WILC_Uint32)WILC_NULL,0);
+	/* after what is still queued for the handle going away */
+	host_int_post_wfi_drv_handler(pstrWFIDrv, (WILC_Uint32)WILC_NULL, 0);
 	WILC_SemaphoreAcquire(&hSemDeinitDrvHandle, NULL);
 
+	/* handles what is left for this handle, anything later goes to the default worker */
+	host_int_worker_stop(pstrWFIDrv);
+
 	
 	/*Calling the CFG80211 scan done function with the abort flag set to true*/
 	if(pstrWFIDrv->strWILC_UsrScanReq.pfUserScanResult)
@@ -7515,12 +9555,10 @@ WILC_Sint32 host_int_deinit(WILC_WFIDrvHandle hWFIDrv)
 	TransportDeInit();
 #endif
 	
-	pstrWFIDrv->enuHostIFstate = HOST_IF_IDLE;	
+	host_int_set_state(pstrWFIDrv, HOST_IF_IDLE);	
 
 	gbScanWhileConnected = WILC_FALSE;	
 
-	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
-	
 	if(clients_count==1)
 	{
 		if(WILC_TimerDestroy(&g_hPeriodicRSSI, WILC_NULL))
@@ -7528,23 +9566,11 @@ WILC_Sint32 host_int_deinit(WILC_WFIDrvHandle hWFIDrv)
 			PRINT_D(HOSTINF_DBG,">> Connect timer is active \n");
 			//msleep(HOST_IF_CONNECT_TIMEOUT+1000);
 		}
-		strHostIFmsg.u16MsgId = HOST_IF_MSG_EXIT;
-		strHostIFmsg.drvHandler=hWFIDrv;
-	
-	
-		s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
-		if(s32Error != WILC_SUCCESS) {
-			PRINT_ER("Error in sending deinit's message queue message function: Error(%d)\n",s32Error);
-		} else {
-			WILC_SemaphoreAcquire(&hSemHostIFthrdEnd, NULL);
-		}
-	
-	
-		WILC_MsgQueueDestroy(&gMsgQHostIF, WILC_NULL);
+		/* stops the default worker */
+		host_int_destroy_msg_queues();
 		msgQ_created=0;
 	
 	
-		WILC_SemaphoreDestroy(&hSemHostIFthrdEnd,NULL);
 		WILC_SemaphoreDestroy(&hSemDeinitDrvHandle,NULL);
 		
 	}
@@ -7555,6 +9581,18 @@ WILC_Sint32 host_int_deinit(WILC_WFIDrvHandle hWFIDrv)
 	WILC_SemaphoreDestroy(&(pstrWFIDrv->hSemGetLINKSPEED),NULL);	
 	WILC_SemaphoreDestroy(&(pstrWFIDrv->hSemGetCHNL),NULL);	
 	WILC_SemaphoreDestroy(&(pstrWFIDrv->hSemInactiveTime),NULL);	
+	WILC_SemaphoreDestroy(&(pstrWFIDrv->hSemWaitResponse),NULL);
+	host_int_wid_cache_deinit(pstrWFIDrv);
+	if(pstrWFIDrv->strFastReconnect.pJoinParams != NULL)
+	{
+		WILC_FREE(pstrWFIDrv->strFastReconnect.pJoinParams);
+		pstrWFIDrv->strFastReconnect.pJoinParams = NULL;
+	}
+	if(pstrWFIDrv->strWILC_UsrScanReq.pastrFoundNetworkInfo != WILC_NULL)
+	{
+		WILC_FREE(pstrWFIDrv->strWILC_UsrScanReq.pastrFoundNetworkInfo);
+		pstrWFIDrv->strWILC_UsrScanReq.pastrFoundNetworkInfo = WILC_NULL;
+	}
 	WILC_SemaphoreDestroy(&hWaitResponse,NULL);
 	
 	WILC_SemaphoreAcquire(&(pstrWFIDrv->gtOsCfgValuesSem),NULL);
@@ -7621,7 +9659,7 @@ void NetworkInfoReceived(WILC_Uint8* pu8Buffer, WILC_Uint32 u32Length)
 			  	  pu8Buffer, u32Length); 
 	
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);	
+	s32Error = host_int_post_msg(&strHostIFmsg);	
 	if(s32Error)
 	{
 		PRINT_ER("Error in sending network info message queue message parameters: Error(%d)\n",s32Error);
@@ -7674,6 +9712,8 @@ void GnrlAsyncInfoReceived(WILC_Uint8* pu8Buffer, WILC_Uint32 u32Length)
 		return;
 	}
 
+	host_int_conn_trace(pstrWFIDrv, CONN_TRACE_ASYNC_RCVD, (u32Length > 7) ? pu8Buffer[7] : 0);
+
 	/* prepare the General Asynchronous Info message */
 	WILC_memset(&strHostIFmsg, 0, sizeof(tstrHostIFmsg));
 
@@ -7690,7 +9730,7 @@ void GnrlAsyncInfoReceived(WILC_Uint8* pu8Buffer, WILC_Uint32 u32Length)
 			  	  pu8Buffer, u32Length); 
 	
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		PRINT_ER("Error in sending message queue asynchronous message info: Error(%d)\n",s32Error);
@@ -7745,7 +9785,7 @@ void host_int_ScanCompleteReceived(WILC_Uint8* pu8Buffer, WILC_Uint32 u32Length)
 				  	  pu8Buffer, u32Length); */
 
 		/* send the message */
-		s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+		s32Error = host_int_post_msg(&strHostIFmsg);
 		if(s32Error)
 		{
 			PRINT_ER("Error in sending message queue scan complete parameters: Error(%d)\n",s32Error);
@@ -7796,7 +9836,7 @@ WILC_Sint32 host_int_remain_on_channel(WILC_WFIDrvHandle hWFIDrv, WILC_Uint32 u3
 	strHostIFmsg.uniHostIFmsgBody.strHostIfRemainOnChan.u32ListenSessionID=u32SessionID;
 	strHostIFmsg.drvHandler=hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -7843,7 +9883,7 @@ WILC_Sint32 host_int_ListenStateExpired(WILC_WFIDrvHandle hWFIDrv, WILC_Uint32 u
 	strHostIFmsg.drvHandler=hWFIDrv;
 	strHostIFmsg.uniHostIFmsgBody.strHostIfRemainOnChan.u32ListenSessionID = u32SessionID;
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -7896,7 +9936,7 @@ WILC_Sint32 host_int_frame_register(WILC_WFIDrvHandle hWFIDrv, WILC_Uint16 u16Fr
 	strHostIFmsg.uniHostIFmsgBody.strHostIfRegisterFrame.bReg= bReg;
 	strHostIFmsg.drvHandler=hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -7973,7 +10013,7 @@ WILC_Sint32 host_int_add_beacon(WILC_WFIDrvHandle hWFIDrv, WILC_Uint32 u32Interv
 		pstrSetBeaconParam->pu8Tail=NULL;
 	}
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8022,7 +10062,7 @@ WILC_Sint32 host_int_del_beacon(WILC_WFIDrvHandle hWFIDrv)
 	strHostIFmsg.drvHandler=hWFIDrv;
 	PRINT_D(HOSTINF_DBG,"Setting deleting beacon message queue params\n");
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	WILC_ERRORCHECK(s32Error);
 
 	WILC_CATCH(s32Error)
@@ -8073,7 +10113,7 @@ WILC_Sint32 host_int_add_station(WILC_WFIDrvHandle hWFIDrv, tstrWILC_AddStaParam
 	}
 	
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8122,7 +10162,7 @@ WILC_Sint32 host_int_del_station(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* pu8MacAd
 	else
 		WILC_memcpy(pstrDelStationMsg->au8MacAddr, pu8MacAddr, ETH_ALEN);
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8184,7 +10224,7 @@ WILC_Sint32 host_int_del_allstation(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 pu8Mac
 	}
 	
 	pstrDelAllStationMsg->u8Num_AssocSta=u8AssocNumb;
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	
 	if(s32Error)
 	{
@@ -8192,7 +10232,7 @@ WILC_Sint32 host_int_del_allstation(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 pu8Mac
 
 	}
 	
-	WILC_SemaphoreAcquire(&hWaitResponse, NULL);	
+	WILC_SemaphoreAcquire(host_int_response_sem(hWFIDrv), NULL);	
 
 	WILC_CATCH(s32Error)	
 	{
@@ -8241,7 +10281,7 @@ WILC_Sint32 host_int_edit_station(WILC_WFIDrvHandle hWFIDrv, tstrWILC_AddStaPara
 		WILC_NULLCHECK(s32Error, pstrAddStationMsg->pu8Rates);
 	}
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8287,7 +10327,7 @@ WILC_Sint32 host_int_set_power_mgmt(WILC_WFIDrvHandle hWFIDrv, WILC_Bool bIsEnab
 	pstrPowerMgmtParam->u32Timeout = u32Timeout;
 	
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8324,7 +10364,7 @@ WILC_Sint32 host_int_setup_multicast_filter(WILC_WFIDrvHandle hWFIDrv, WILC_Bool
 	pstrMulticastFilterParam->bIsEnabled = bIsEnabled;
 	pstrMulticastFilterParam->u32count = u32count;
 	
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8616,7 +10656,7 @@ static int host_int_addBASession(WILC_WFIDrvHandle hWFIDrv, char* pBSSID,char TI
 	pBASessionInfo->u16SessionTimeout = SessionTimeout;
 	strHostIFmsg.drvHandler = hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8651,14 +10691,14 @@ WILC_Sint32 host_int_delBASession(WILC_WFIDrvHandle hWFIDrv, char* pBSSID,char T
 	pBASessionInfo->u8Ted = TID;
 	strHostIFmsg.drvHandler = hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
 	}	
 
 	/*BugID_5222*/
-	WILC_SemaphoreAcquire(&hWaitResponse, NULL);
+	WILC_SemaphoreAcquire(host_int_response_sem(hWFIDrv), NULL);
 
 	WILC_CATCH(s32Error)
 	{
@@ -8689,14 +10729,14 @@ WILC_Sint32 host_int_del_All_Rx_BASession(WILC_WFIDrvHandle hWFIDrv, char* pBSSI
 	pBASessionInfo->u8Ted = TID;
 	strHostIFmsg.drvHandler = hWFIDrv;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
 	}
 
 	/*BugID_5222*/
-	WILC_SemaphoreAcquire(&hWaitResponse, NULL);
+	WILC_SemaphoreAcquire(host_int_response_sem(hWFIDrv), NULL);
 
 	WILC_CATCH(s32Error)
 	{
@@ -8737,7 +10777,7 @@ WILC_Sint32 host_int_setup_ipaddress(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* u16i
 	strHostIFmsg.drvHandler=hWFIDrv;
 	strHostIFmsg.uniHostIFmsgBody.strHostIfSetIP.idx = idx;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8780,7 +10820,7 @@ WILC_Sint32 host_int_get_ipaddress(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* u16ipa
 	strHostIFmsg.drvHandler=hWFIDrv;
 	strHostIFmsg.uniHostIFmsgBody.strHostIfSetIP.idx= idx;
 
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 	{
 		WILC_ERRORREPORT(s32Error, s32Error);
@@ -8814,7 +10854,7 @@ WILC_Sint32 host_int_set_tx_power(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 tx_power
 	strHostIFmsg.drvHandler=hWFIDrv;
 
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error)
 		PRINT_ER(" Error in sending messagequeue: PMKID Info\n");
 
@@ -8838,13 +10878,13 @@ WILC_Sint32 host_int_get_tx_power(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 *tx_powe
 	strHostIFmsg.drvHandler=hWFIDrv;
 	strHostIFmsg.uniHostIFmsgBody.strHostIFGetTxPwr.u8TxPwr=tx_power;
 	/* send the message */
-	s32Error = WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = host_int_post_msg(&strHostIFmsg);
 	if(s32Error){
 		PRINT_ER("Failed to send get host channel param's message queue ");
 		return WILC_FAIL;
 	}
 
-	WILC_SemaphoreAcquire(&hWaitResponse, NULL);	
+	WILC_SemaphoreAcquire(host_int_response_sem(hWFIDrv), NULL);	
 
 	return s32Error;
 }
@@ -8862,7 +10902,7 @@ WILC_Sint32 host_int_set_antenna(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 antenna_m
 	strHostIFmsg.uniHostIFmsgBody.pUserData = (WILC_Char*)antenna_mode;
 	strHostIFmsg.drvHandler	= hWFIDrv;
 	/* send the message */
-	s32Error = 	WILC_MsgQueueSend(&gMsgQHostIF, &strHostIFmsg, sizeof(tstrHostIFmsg), WILC_NULL);
+	s32Error = 	host_int_post_msg(&strHostIFmsg);
 	if(s32Error){
 		PRINT_ER("Failed to send get host channel param's message queue ");
 		return WILC_FAIL;
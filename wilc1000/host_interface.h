@@ -87,7 +87,11 @@
 #define DEFAULTKEY					0x4
 #define ADDKEY_AP					0x8
 #define MAX_NUM_SCANNED_NETWORKS	100 //30		// rachel
-#define MAX_NUM_SCANNED_NETWORKS_SHADOW	130
+/* Networks told apart in one scan, see tstrWILC_UsrScanReq */
+#define MAX_NUM_FOUND_NETWORKS		512
+/* every network a scan reports has to fit in the cfg80211 shadow */
+#define MAX_NUM_SCANNED_NETWORKS_SHADOW	MAX_NUM_FOUND_NETWORKS
+#define FOUND_NETWORKS_MIN_SLOT_BITS	6
 #define MAX_NUM_PROBED_SSID            10  /*One more than the number of scanned ssids*/
 #define CHANNEL_SCAN_TIME 			250//250
 
@@ -143,6 +147,97 @@ typedef struct _tstrStatistics
 	
 }tstrStatistics;
 
+/*
+ * Host side cache of the read-mostly WIDs polled through host_int_get_rssi(),
+ * host_int_get_link_speed() and host_int_get_statistics(). A value younger
+ * than its TTL is answered without a round trip to the chip, and callers
+ * asking for the same entry at once share a single query.
+ */
+typedef enum
+{
+	WID_CACHE_RSSI = 0,
+	WID_CACHE_LINKSPEED,
+	WID_CACHE_STATISTICS,
+	WID_CACHE_ENTRIES
+}tenuWidCacheEntry;
+
+/* TTLs in ms */
+#define WID_CACHE_RSSI_TTL		1000
+#define WID_CACHE_LINKSPEED_TTL		1000
+#define WID_CACHE_STATISTICS_TTL	1000
+
+typedef struct
+{
+	WILC_Bool bValid;
+	unsigned long ulStamp;			/* jiffies of the last refresh */
+	WILC_SemaphoreHandle hSemFetch;		/* held by the caller querying the chip */
+}tstrWidCacheEntry;
+
+typedef struct
+{
+	spinlock_t lock;
+	tstrWidCacheEntry astrEntry[WID_CACHE_ENTRIES];
+	WILC_Sint8 s8Rssi;
+	WILC_Sint8 s8LinkSpeed;
+	tstrStatistics strStatistics;
+}tstrWidCache;
+
+/* bumped by concurrent callers without the cache lock */
+typedef struct
+{
+	atomic_t Hits;
+	atomic_t Coalesced;			/* answered by a query another caller made */
+	atomic_t Misses;
+}tstrWidCacheStats;
+
+/*
+ * Shadow of the last value successfully written for each config WID, kept
+ * per driver handle so that re-applying an unchanged configuration costs no
+ * bus round trip. Values larger than WID_SHADOW_VAL_MAX are always sent.
+ */
+#define WID_SHADOW_ENTRIES	48
+#define WID_SHADOW_VAL_MAX	64
+
+typedef struct
+{
+	WILC_Uint16 u16WIDid;
+	WILC_Uint16 u16Size;
+	WILC_Uint8 au8Val[WID_SHADOW_VAL_MAX];
+}tstrWidShadowEntry;
+
+typedef struct
+{
+	spinlock_t lock;
+	WILC_Uint32 u32Gen;			/* firmware generation the values were written to */
+	WILC_Uint8 u8Entries;
+	tstrWidShadowEntry astrEntry[WID_SHADOW_ENTRIES];
+}tstrWidShadow;
+
+/*
+ * Join of the current station connection, kept once the link is lost so
+ * that a reconnect within FAST_RECONNECT_WINDOW can go straight back to
+ * the same BSS without scanning for it first.
+ */
+#define FAST_RECONNECT_WINDOW	(10 * HZ)
+
+typedef struct
+{
+	WILC_Bool bStaged;			/* a join to au8bssid was sent */
+	WILC_Bool bValid;			/* ... and it succeeded */
+	WILC_Bool bLinkLost;
+	WILC_Bool bScanSkipped;			/* a scan was answered from the cache */
+	WILC_Bool bScanned;			/* the firmware scanned since the link loss */
+	WILC_Uint8 au8bssid[ETH_ALEN];
+	WILC_Uint8 au8ssid[MAX_SSID_LEN];
+	WILC_Uint8 u8SsidLen;
+	WILC_Uint8 u8channel;
+	WILC_Uint8 u8security;
+	AUTHTYPE_T tenuAuth_type;
+	void* pJoinParams;			/* private copy */
+	unsigned long ulLinkLost;		/* jiffies */
+	ktime_t tLinkLost;
+}tstrFastReconnect;
+
 
 typedef enum
 {
@@ -248,6 +343,7 @@ typedef struct
 {
 	WILC_Uint8 au8bssid[6];
 	WILC_Sint8 s8rssi;
+	WILC_Uint8 u8Used;
 }tstrFoundNetworkInfo;
 
 typedef enum {SCAN_EVENT_NETWORK_FOUND  = 0,
@@ -336,7 +432,10 @@ typedef struct
 	void* u32UserScanPvoid;
 
 	WILC_Uint32 u32RcvdChCount;
-	tstrFoundNetworkInfo astrFoundNetworkInfo[MAX_NUM_SCANNED_NETWORKS];	
+	/* Networks found so far, open addressed on the BSSID. The table has
+	   (1 << u8FoundSlotBits) slots and doubles when 3/4 full. */
+	WILC_Uint8 u8FoundSlotBits;
+	tstrFoundNetworkInfo* pastrFoundNetworkInfo;
 }tstrWILC_UsrScanReq;
 
 typedef struct
@@ -460,6 +559,16 @@ typedef struct
 	WILC_SemaphoreHandle hSemGetLINKSPEED;
 	WILC_SemaphoreHandle hSemGetCHNL;
 	WILC_SemaphoreHandle hSemInactiveTime;
+	WILC_SemaphoreHandle hSemWaitResponse;
+//answers of the GET handlers
+	WILC_Sint8 s8Rssi;
+	WILC_Sint8 s8LinkSpeed;
+	WILC_Uint8 u8Chnl;
+	WILC_Uint32 u32InactiveTime;
+	tstrWidCache strWidCache;
+	tstrWidShadow strWidShadow;
+	WILC_Uint32 u32ConnTraceId;			/* connection being traced, 0 if none */
+	tstrFastReconnect strFastReconnect;
 //timer handlers
 	WILC_TimerHandle hScanTimer;
 	WILC_TimerHandle hConnectTimer;
@@ -786,6 +895,17 @@ WILC_Sint32 host_int_set_MacAddress(WILC_WFIDrvHandle hWFIDrv,WILC_Uint8* pu8Mac
 */
 WILC_Sint32 host_int_wait_msg_queue_idle(void);
 
+/**
+*  @brief 		lets the workers handle messages again after
+				host_int_wait_msg_queue_idle()
+*  @details 	Messages queued meanwhile were parked and are released
+				in order.
+*  @return 		None
+*  @note
+*  @version		1.0
+*/
+void host_int_resume_msg_queue(void);
+
 /**
 *  @brief 		gets the site survey results
 *  @details 	  	
@@ -1366,6 +1486,15 @@ static int host_int_addBASession(WILC_WFIDrvHandle hWFIDrv, char* pBSSID,char TI
 
 void host_int_freeJoinParams(void* pJoinParams);
 
+void host_int_wid_shadow_resync(void);
+void host_int_wid_shadow_sent(WILC_Uint32 drvHandler, tstrWID* pstrWIDs, WILC_Uint32 u32WIDsCount);
+
+void host_int_conn_trace_start(WILC_WFIDrvHandle hWFIDrv);
+
+WILC_Bool host_int_fast_reconnect_scan(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8* pu8bssid, WILC_Uint8* pu8channel);
+WILC_Bool host_int_fast_reconnect_bss(WILC_WFIDrvHandle hWFIDrv, const WILC_Uint8* pu8ssid, WILC_Uint8 u8SsidLen,
+	const WILC_Uint8* pu8bssid, tstrNetworkInfo* pstrNetworkInfo);
+
 WILC_Sint32 host_int_get_statistics(WILC_WFIDrvHandle hWFIDrv, tstrStatistics* pstrStatistics);
 extern int linux_wlan_get_num_conn_ifcs(void);
 WILC_Sint32 host_int_set_tx_power(WILC_WFIDrvHandle hWFIDrv, WILC_Uint8 tx_power);
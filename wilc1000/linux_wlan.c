@@ -19,6 +19,7 @@
 
 #include <linux/kthread.h>
 #include <linux/firmware.h>
+#include <linux/crc32.h>
 #include <linux/delay.h>
 
 #include <linux/init.h>
@@ -126,6 +127,8 @@ static struct notifier_block g_dev_notifier = {
 #ifndef STA_FIRMWARE
 #define STA_FIRMWARE_1003	"WILC1003_firmware.bin"
 #endif
+/* compressed image, preferred when present (see WILC_FW_LZ4_MAGIC) */
+#define STA_FIRMWARE_1003_LZ4	STA_FIRMWARE_1003 ".lz4"
 
 
 
@@ -161,6 +164,7 @@ extern void WILC_WFI_p2p_rx(struct net_device *dev,uint8_t *buff, uint32_t size)
 static void* internal_alloc(uint32_t size, uint32_t flag);
 static void linux_wlan_tx_complete(void* priv, int status);
 void frmw_to_linux(uint8_t *buff, uint32_t size,uint32_t pkt_offset);
+static void frmw_to_linux_batch(wilc_rx_pkt_t *pkts, uint32_t count);
 static int  mac_init_fn(struct net_device *ndev);
 int  mac_xmit(struct sk_buff *skb, struct net_device *dev);
 int  mac_open(struct net_device *ndev);
@@ -173,6 +177,14 @@ linux_wlan_t* g_linux_wlan = NULL;
 wilc_wlan_oup_t* gpstrWlanOps;
 WILC_Bool bEnablePS = WILC_TRUE;
 
+static unsigned int fw_chunk_size = WILC_FW_CHUNK_DEFAULT;
+module_param(fw_chunk_size, uint, 0644);
+MODULE_PARM_DESC(fw_chunk_size, "Firmware download transfer size in bytes");
+
+static int fw_cache = 1;
+module_param(fw_cache, int, 0644);
+MODULE_PARM_DESC(fw_cache, "Keep the firmware image and the running firmware across interface restarts");
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,0)
 static const struct net_device_ops wilc_netdev_ops = {
 	.ndo_init = mac_init_fn,
@@ -827,64 +839,126 @@ static void linux_wlan_mac_indicate(int flag){
 
 }
 
-struct net_device * GetIfHandler(uint8_t* pMacHeader)
+static inline uint8_t linux_wlan_bssid_hash(uint8_t* pBSSID)
+{
+	/* the NIC specific bytes vary the most */
+	return (pBSSID[3] ^ pBSSID[4] ^ pBSSID[5]) & (WILC_BSSID_MAP_SIZE - 1);
+}
+
+/* Must be called with bssid_map_lock held */
+static void linux_wlan_bssid_map_rebuild(void)
 {
-	uint8_t *Bssid,*Bssid1,offset = 10;
-	int i =0;
+	uint8_t null_bssid[ETH_ALEN] = {0};
+	tstrBssidMapEntry* pstrEntry;
+	uint8_t u8Idx;
+	int i, j;
 
-	Bssid  = pMacHeader+10;
-	Bssid1 = pMacHeader+4;
+	memset(g_linux_wlan->strBssidMap, 0, sizeof(g_linux_wlan->strBssidMap));
+	g_linux_wlan->u8BssidMapEntries = 0;
+	g_linux_wlan->pstrBssidLastHit = NULL;
 
-	offset = 10;
 	for(i=0;i<g_linux_wlan->u8NoIfcs;i++)
 	{
-		if(g_linux_wlan->strInterfaceInfo[i].u8IfcType == STATION_MODE)
+		tstrInterfaceInfo* pstrIfc = &g_linux_wlan->strInterfaceInfo[i];
+
+		if(pstrIfc->u8IfcType != STATION_MODE && pstrIfc->u8IfcType != AP_MODE)
+			continue;
+		if(!memcmp(pstrIfc->aBSSID, null_bssid, ETH_ALEN))
+			continue;
+
+		u8Idx = linux_wlan_bssid_hash(pstrIfc->aBSSID);
+		for(j=0;j<WILC_BSSID_MAP_SIZE;j++)
 		{
-			if(!memcmp(pMacHeader+offset,g_linux_wlan->strInterfaceInfo[i].aBSSID,ETH_ALEN))			
-			{			
-				return g_linux_wlan->strInterfaceInfo[i].wilc_netdev;
+			pstrEntry = &g_linux_wlan->strBssidMap[(u8Idx + j) & (WILC_BSSID_MAP_SIZE - 1)];
+			if(!pstrEntry->bValid)
+			{
+				memcpy(pstrEntry->aBSSID, pstrIfc->aBSSID, ETH_ALEN);
+				pstrEntry->u8IfcType = pstrIfc->u8IfcType;
+				pstrEntry->wilc_netdev = pstrIfc->wilc_netdev;
+				pstrEntry->bValid = 1;
+				g_linux_wlan->u8BssidMapEntries++;
+				break;
 			}
 		}
 	}
-	offset = 4;
-	for(i=0;i<g_linux_wlan->u8NoIfcs;i++)
+}
+
+/* Must be called with bssid_map_lock held */
+static tstrBssidMapEntry* linux_wlan_bssid_map_find(uint8_t* pBSSID, uint8_t u8IfcType)
+{
+	tstrBssidMapEntry* pstrEntry;
+	uint8_t u8Idx;
+	int j;
+
+	u8Idx = linux_wlan_bssid_hash(pBSSID);
+	for(j=0;j<WILC_BSSID_MAP_SIZE;j++)
 	{
-		if(g_linux_wlan->strInterfaceInfo[i].u8IfcType == AP_MODE)
+		pstrEntry = &g_linux_wlan->strBssidMap[(u8Idx + j) & (WILC_BSSID_MAP_SIZE - 1)];
+		if(!pstrEntry->bValid)
+			break;
+		if(pstrEntry->u8IfcType == u8IfcType && !memcmp(pstrEntry->aBSSID, pBSSID, ETH_ALEN))
+			return pstrEntry;
+	}
+	return NULL;
+}
+
+struct net_device * GetIfHandler(uint8_t* pMacHeader)
+{
+	tstrBssidMapEntry* pstrEntry;
+	struct net_device* wilc_netdev = NULL;
+	unsigned long flags;
+	uint8_t offset;
+
+	spin_lock_irqsave(&g_linux_wlan->bssid_map_lock, flags);
+
+	/* most bursts belong to the interface of the previous frame */
+	pstrEntry = g_linux_wlan->pstrBssidLastHit;
+	if(pstrEntry != NULL)
+	{
+		offset = (pstrEntry->u8IfcType == AP_MODE) ? WILC_RX_AP_BSSID_OFFSET : WILC_RX_STA_BSSID_OFFSET;
+		if(!memcmp(pMacHeader+offset, pstrEntry->aBSSID, ETH_ALEN))
 		{
-			if(!memcmp(pMacHeader+offset,g_linux_wlan->strInterfaceInfo[i].aBSSID,ETH_ALEN))			
-			{			
-				return g_linux_wlan->strInterfaceInfo[i].wilc_netdev;
-			}
+			g_linux_wlan->strRxDemuxStats.u32CacheHits++;
+			g_linux_wlan->strRxDemuxStats.u32Hits++;
+			wilc_netdev = pstrEntry->wilc_netdev;
+			goto _unlock_;
 		}
 	}
-	#if 0
-	PRINT_INFO(INIT_DBG,"Invalide handle\n");
-	for(i=0;i<25;i++)
+
+	if(g_linux_wlan->u8BssidMapEntries == 0)
 	{
-		PRINT_D(INIT_DBG,"%02x ",pMacHeader[i]);
+		g_linux_wlan->strRxDemuxStats.au32Drops[RX_DEMUX_DROP_NO_BINDING]++;
+		goto _unlock_;
 	}
-	Bssid  = pMacHeader+18;
-	Bssid1 = pMacHeader+12;
-	for(i=0;i<g_linux_wlan->u8NoIfcs;i++)
+
+	/* station interfaces take precedence over AP ones */
+	pstrEntry = linux_wlan_bssid_map_find(pMacHeader+WILC_RX_STA_BSSID_OFFSET, STATION_MODE);
+	if(pstrEntry == NULL)
+		pstrEntry = linux_wlan_bssid_map_find(pMacHeader+WILC_RX_AP_BSSID_OFFSET, AP_MODE);
+
+	if(pstrEntry == NULL)
 	{
-		if(!memcmp(Bssid1,g_linux_wlan->strInterfaceInfo[i].aBSSID,ETH_ALEN) || 
-			!memcmp(Bssid,g_linux_wlan->strInterfaceInfo[i].aBSSID,ETH_ALEN))
-		{
-			PRINT_D(INIT_DBG,"Ctx [%p]\n",g_linux_wlan->strInterfaceInfo[i].wilc_netdev);
-			return g_linux_wlan->strInterfaceInfo[i].wilc_netdev;
-		}		
+		g_linux_wlan->strRxDemuxStats.au32Drops[RX_DEMUX_DROP_UNKNOWN_BSSID]++;
+		goto _unlock_;
 	}
-	PRINT_INFO(INIT_DBG,"\n");
-	#endif
-	return NULL;
+
+	g_linux_wlan->pstrBssidLastHit = pstrEntry;
+	g_linux_wlan->strRxDemuxStats.u32Hits++;
+	wilc_netdev = pstrEntry->wilc_netdev;
+
+_unlock_:
+	spin_unlock_irqrestore(&g_linux_wlan->bssid_map_lock, flags);
+	return wilc_netdev;
 }
 
 int linux_wlan_set_bssid(struct net_device * wilc_netdev,uint8_t * pBSSID,uint8_t mode)
 {
 	int i = 0;
 	int ret = -1;
+	unsigned long flags;
 	
 	PRINT_D(INIT_DBG,"set bssid on[%p]\n",wilc_netdev);
+	spin_lock_irqsave(&g_linux_wlan->bssid_map_lock, flags);
 	for(i=0;i<g_linux_wlan->u8NoIfcs;i++)
 	{
 		if(g_linux_wlan->strInterfaceInfo[i].wilc_netdev == wilc_netdev)
@@ -892,13 +966,35 @@ int linux_wlan_set_bssid(struct net_device * wilc_netdev,uint8_t * pBSSID,uint8_
 			PRINT_D(INIT_DBG,"set bssid [%x][%x][%x]\n",pBSSID[0],pBSSID[1],pBSSID[2]);
 			memcpy(g_linux_wlan->strInterfaceInfo[i].aBSSID,pBSSID,6);
 			g_linux_wlan->strInterfaceInfo[i].u8IfcType = mode;
+			linux_wlan_bssid_map_rebuild();
 			ret = 0;
 			break;
 		}		
 	}
+	spin_unlock_irqrestore(&g_linux_wlan->bssid_map_lock, flags);
 	return ret;
 }
 
+#if defined(WILC_DEBUGFS)
+int linux_wlan_dump_rx_demux_stats(char* buf, int size)
+{
+	tstrRxDemuxStats strStats;
+	unsigned long flags;
+
+	if(g_linux_wlan == NULL)
+		return 0;
+
+	spin_lock_irqsave(&g_linux_wlan->bssid_map_lock, flags);
+	memcpy(&strStats, &g_linux_wlan->strRxDemuxStats, sizeof(strStats));
+	spin_unlock_irqrestore(&g_linux_wlan->bssid_map_lock, flags);
+
+	return scnprintf(buf, size, "hits: %u\ncache_hits: %u\ndrop_no_binding: %u\ndrop_unknown_bssid: %u\n",
+			strStats.u32Hits, strStats.u32CacheHits,
+			strStats.au32Drops[RX_DEMUX_DROP_NO_BINDING],
+			strStats.au32Drops[RX_DEMUX_DROP_UNKNOWN_BSSID]);
+}
+#endif
+
 /*BugID_5213*/
 /*Function to get number of connected interfaces*/
 int linux_wlan_get_num_conn_ifcs(void)
@@ -942,6 +1038,28 @@ static int linux_wlan_rxq_task(void* vp){
 	return 0;
 }
 
+/*
+ * Drains config indications, scan results and management frames queued by
+ * the RX path. Runs at a lower priority than the data path on purpose.
+ */
+static int linux_wlan_cfg_rxq_task(void* vp){
+
+	while(1) {
+		linux_wlan_lock(&g_linux_wlan->cfg_rxq_event);
+
+		if (g_linux_wlan->close){
+			while(!kthread_should_stop())
+				schedule();
+
+			PRINT_D(RX_DBG," Cfg RX thread stopped\n");
+			break;
+		}
+
+		g_linux_wlan->oup.wlan_handle_cfg_rx_que();
+	}
+	return 0;
+}
+
 #define USE_TX_BACKOFF_DELAY_IF_NO_BUFFERS
 
 static int linux_wlan_txq_task(void* vp)
@@ -1036,17 +1154,24 @@ int linux_wlan_get_firmware(perInterface_wlan_t* p_nic){
 	int ret = 0;	
 	const struct firmware* wilc_firmware;
 	char *firmware;	
+	char *firmware_lz4;
+	struct device *dev;
 	unsigned int chipId;
 
-	
+	if(g_linux_wlan->wilc_firmware != NULL){
+		PRINT_D(INIT_DBG,"Using cached firmware image\n");
+		return 0;
+	}
 
 	chipId = wilc_get_chipid(0);
 	if(chipId < 0x1003a0){
 		PRINT_ER("WILC1002 isn't suported\n!");
 		goto _fail_;
 	}
-	else
+	else {
 		firmware = STA_FIRMWARE_1003;
+		firmware_lz4 = STA_FIRMWARE_1003_LZ4;
+	}
 
 	printk("loading firmware %s\n",firmware);
 	
@@ -1067,19 +1192,23 @@ int linux_wlan_get_firmware(perInterface_wlan_t* p_nic){
 		root file system with the name specified above */
 
 #ifdef WILC_SDIO
-	if( request_firmware(&wilc_firmware,firmware, &g_linux_wlan->wilc_sdio_func->dev) != 0){
-		PRINT_ER("%s - firmare not available\n",firmware);
-		ret = -1;
-		goto _fail_;
-	}
+	dev = &g_linux_wlan->wilc_sdio_func->dev;
 #else
-	if( request_firmware(&wilc_firmware,firmware, &g_linux_wlan->wilc_spidev->dev) != 0){
+	dev = &g_linux_wlan->wilc_spidev->dev;
+#endif
+	/* The compressed image is optional, don't wait on the usermode helper for it */
+#if defined(WILC_FW_LZ4) && (LINUX_VERSION_CODE >= KERNEL_VERSION(3,14,0))
+	if(request_firmware_direct(&wilc_firmware, firmware_lz4, dev) == 0){
+		PRINT_D(INIT_DBG,"Using compressed firmware %s\n",firmware_lz4);
+	}else
+#endif
+	if( request_firmware(&wilc_firmware,firmware, dev) != 0){
 		PRINT_ER("%s - firmare not available\n",firmware);
 		ret = -1;
 		goto _fail_;
 	}
-#endif
 	g_linux_wlan->wilc_firmware = wilc_firmware; /* Bug 4703 */
+	g_linux_wlan->fw_image_crc = crc32_le(~0, wilc_firmware->data, wilc_firmware->size);
 
 _fail_:
 	
@@ -1154,11 +1283,13 @@ static int linux_wlan_firmware_download(linux_wlan_t* p_nic){
 		goto _FAIL_;
 	}
 
-	/* Freeing FW buffer */
-	PRINT_D(INIT_DBG,"Freeing FW buffer ...\n");
-	PRINT_D(INIT_DBG,"Releasing firmware\n");
-	release_firmware(g_linux_wlan->wilc_firmware);
-	g_linux_wlan->wilc_firmware = NULL;
+	/* Freeing FW buffer, unless it is cached for the next bring up */
+	if(!fw_cache){
+		PRINT_D(INIT_DBG,"Freeing FW buffer ...\n");
+		PRINT_D(INIT_DBG,"Releasing firmware\n");
+		release_firmware(g_linux_wlan->wilc_firmware);
+		g_linux_wlan->wilc_firmware = NULL;
+	}
 
 	PRINT_D(INIT_DBG,"Download Succeeded \n");	
 	
@@ -1172,6 +1303,7 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
 
 	unsigned char c_val[64];
 	unsigned int chipid = 0;
+	int frames;
 
 	/*BugID_5077*/
 	struct WILC_WFI_priv *priv;
@@ -1188,69 +1320,72 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
 	chipid = wilc_get_chipid(0);
 
 	
-	if(g_linux_wlan->oup.wlan_cfg_set == NULL)
+	if(g_linux_wlan->oup.wlan_cfg_txn_start == NULL)
 	{
 		PRINT_D(INIT_DBG,"Null pointer\n");
 		goto _fail_;
 	}
 
+	/* Everything below goes out as one transaction, normally a single frame */
+	g_linux_wlan->oup.wlan_cfg_txn_start((WILC_Uint32)pstrWFIDrv);
+
 	*(int*)c_val = (WILC_Uint32)pstrWFIDrv;
 
-	if (!g_linux_wlan->oup.wlan_cfg_set(1, WID_SET_DRV_HANDLER, c_val, 4, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_SET_DRV_HANDLER, c_val, 4))
+		goto _fail_txn_;
 	
 	/*to tell fw that we are going to use PC test - WILC specific*/
 	c_val[0] = 0;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_PC_TEST_MODE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_PC_TEST_MODE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = INFRASTRUCTURE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_BSS_TYPE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_BSS_TYPE, c_val, 1))
+		goto _fail_txn_;
 
 	
 	//c_val[0] = RATE_AUTO; /* bug 4275: Enable autorate and limit it to 24Mbps */
 	c_val[0] = RATE_AUTO;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_CURRENT_TX_RATE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_CURRENT_TX_RATE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = G_MIXED_11B_2_MODE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11G_OPERATING_MODE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11G_OPERATING_MODE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 1;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_CURRENT_CHANNEL, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_CURRENT_CHANNEL, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = G_SHORT_PREAMBLE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_PREAMBLE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_PREAMBLE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = AUTO_PROT;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_PROT_MECH, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_PROT_MECH, c_val, 1))
+		goto _fail_txn_;
 
 #ifdef SWITCH_LOG_TERMINAL
 	c_val[0] = AUTO_PROT;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_LOGTerminal_Switch, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_LOGTerminal_Switch, c_val, 1))
+		goto _fail_txn_;
 #endif
 	
 	c_val[0] = ACTIVE_SCAN;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_SCAN_TYPE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_SCAN_TYPE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = SITE_SURVEY_OFF;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_SITE_SURVEY, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_SITE_SURVEY, c_val, 1))
+		goto _fail_txn_;
 
 	*((int *)c_val) = 0xffff; /* Never use RTS-CTS */
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_RTS_THRESHOLD, c_val, 2, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_RTS_THRESHOLD, c_val, 2))
+		goto _fail_txn_;
 
 	*((int *)c_val) = 2346;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_FRAG_THRESHOLD, c_val, 2, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_FRAG_THRESHOLD, c_val, 2))
+		goto _fail_txn_;
 
     /*  SSID                                                                 */
     /*  --------------------------------------------------------------       */
@@ -1261,29 +1396,29 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*  --------------------------------------------------------------       */
 #ifndef USE_WIRELESS
 	strcpy(c_val, "nwifi");
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_SSID, c_val, (strlen(c_val)+1), 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_SSID, c_val, (strlen(c_val)+1)))
+		goto _fail_txn_;
 #endif
 
 	c_val[0] = 0;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_BCAST_SSID, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_BCAST_SSID, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 1;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_QOS_ENABLE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_QOS_ENABLE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = NO_POWERSAVE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_POWER_MANAGEMENT, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_POWER_MANAGEMENT, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = NO_ENCRYPT; //NO_ENCRYPT, 0x79
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11I_MODE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11I_MODE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = OPEN_SYSTEM;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_AUTH_TYPE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_AUTH_TYPE, c_val, 1))
+		goto _fail_txn_;
 
     /*  WEP/802 11I Configuration                                            */
     /*  ------------------------------------------------------------------   */
@@ -1294,8 +1429,8 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*  ------------------------------------------------------------------   */
 
 	strcpy(c_val, "123456790abcdef1234567890");
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_WEP_KEY_VALUE, c_val, (strlen(c_val)+1), 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_WEP_KEY_VALUE, c_val, (strlen(c_val)+1)))
+		goto _fail_txn_;
 
     /*  WEP/802 11I Configuration                                            */
     /*  ------------------------------------------------------------------   */
@@ -1304,8 +1439,8 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*                  and less than 64 bytes                               */
     /*  ------------------------------------------------------------------   */
 	strcpy(c_val, "12345678");
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11I_PSK, c_val, (strlen(c_val)), 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11I_PSK, c_val, (strlen(c_val))))
+		goto _fail_txn_;
 
     /*  IEEE802.1X Key Configuration                                         */
     /*  ------------------------------------------------------------------   */
@@ -1314,8 +1449,8 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*                  and less than 65 bytes                               */
     /*  ------------------------------------------------------------------   */
 	strcpy(c_val, "password");
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_1X_KEY, c_val, (strlen(c_val)+1), 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_1X_KEY, c_val, (strlen(c_val)+1)))
+		goto _fail_txn_;
 
     /*   IEEE802.1X Server Address Configuration                             */
     /*  ------------------------------------------------------------------   */
@@ -1326,32 +1461,32 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
 	c_val[1] = 168;
 	c_val[2] = 1;
 	c_val[3] = 112;
- 	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_1X_SERV_ADDR, c_val, 4, 0,0))
-		goto _fail_;
+ 	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_1X_SERV_ADDR, c_val, 4))
+		goto _fail_txn_;
 
 	c_val[0] = 3;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_LISTEN_INTERVAL, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_LISTEN_INTERVAL, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 3;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_DTIM_PERIOD, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_DTIM_PERIOD, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = NORMAL_ACK;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_ACK_POLICY, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_ACK_POLICY, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 0;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_USER_CONTROL_ON_TX_POWER, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_USER_CONTROL_ON_TX_POWER, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 48;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_TX_POWER_LEVEL_11A, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_TX_POWER_LEVEL_11A, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 28;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_TX_POWER_LEVEL_11B, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_TX_POWER_LEVEL_11B, c_val, 1))
+		goto _fail_txn_;
 
     /*  Beacon Interval                                                      */
     /*  -------------------------------------------------------------------- */
@@ -1360,12 +1495,12 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*  -------------------------------------------------------------------- */
 
 	*((int *)c_val) = 100;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_BEACON_INTERVAL, c_val, 2, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_BEACON_INTERVAL, c_val, 2))
+		goto _fail_txn_;
 
 	c_val[0] = REKEY_DISABLE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_REKEY_POLICY, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_REKEY_POLICY, c_val, 1))
+		goto _fail_txn_;
 
     /*  Rekey Time (s) (Used only when the Rekey policy is 2 or 4)           */
     /*  -------------------------------------------------------------------- */
@@ -1373,8 +1508,8 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*  Values to set : 32-bit value                                         */
     /*  -------------------------------------------------------------------- */
 	*((int *)c_val) = 84600;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_REKEY_PERIOD, c_val, 4, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_REKEY_PERIOD, c_val, 4))
+		goto _fail_txn_;
 
     /*  Rekey Packet Count (in 1000s; used when Rekey Policy is 3)           */
     /*  -------------------------------------------------------------------- */
@@ -1382,58 +1517,65 @@ static int linux_wlan_init_test_config(struct net_device *dev, linux_wlan_t* p_n
     /*  Values to set : 32-bit Value                                         */
     /*  -------------------------------------------------------------------- */
 	*((int *)c_val) = 500;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_REKEY_PACKET_COUNT, c_val, 4, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_REKEY_PACKET_COUNT, c_val, 4))
+		goto _fail_txn_;
 
 	c_val[0] = 1;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_SHORT_SLOT_ALLOWED, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_SHORT_SLOT_ALLOWED, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = G_SELF_CTS_PROT;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_ERP_PROT_TYPE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_ERP_PROT_TYPE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 1;  /* Enable N */	
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_ENABLE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_ENABLE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = HT_MIXED_MODE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_OPERATING_MODE, c_val, 1, 0,0))
-		goto _fail_;	
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_OPERATING_MODE, c_val, 1))
+		goto _fail_txn_;	
 
 	c_val[0] = 1; 	/* TXOP Prot disable in N mode: No RTS-CTS on TX A-MPDUs to save air-time. */
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_TXOP_PROT_DISABLE, c_val, 1, 0,0))
-		goto _fail_;	
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_TXOP_PROT_DISABLE, c_val, 1))
+		goto _fail_txn_;	
 
 	/**
 		AP only
 	**/
 	c_val[0] = DETECT_PROTECT_REPORT;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_OBSS_NONHT_DETECTION, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_OBSS_NONHT_DETECTION, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = RTS_CTS_NONHT_PROT;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_HT_PROT_TYPE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_HT_PROT_TYPE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 0;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_RIFS_PROT_ENABLE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_RIFS_PROT_ENABLE, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = MIMO_MODE;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_SMPS_MODE, c_val, 1, 0,0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_SMPS_MODE, c_val, 1))
+		goto _fail_txn_;
 	
 	c_val[0] = 7;
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_CURRENT_TX_MCS, c_val, 1, 0, 0))
-		goto _fail_;
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_CURRENT_TX_MCS, c_val, 1))
+		goto _fail_txn_;
 
 	c_val[0] = 1; /* Enable N with immediate block ack. */
-	if (!g_linux_wlan->oup.wlan_cfg_set(0, WID_11N_IMMEDIATE_BA_ENABLED, c_val, 1, 1,(WILC_Uint32)pstrWFIDrv))
+	if (!g_linux_wlan->oup.wlan_cfg_txn_set(WID_11N_IMMEDIATE_BA_ENABLED, c_val, 1))
+		goto _fail_txn_;
+
+	frames = g_linux_wlan->oup.wlan_cfg_txn_commit();
+	if (frames < 0)
 		goto _fail_;
+	PRINT_D(INIT_DBG,"Default configuration sent in %d frame(s)\n",frames);
 
 	return 0;
 
+_fail_txn_:
+	g_linux_wlan->oup.wlan_cfg_txn_commit();
 _fail_:
 	return -1;
 }
@@ -1452,6 +1594,10 @@ void wilc1000_wlan_deinit(linux_wlan_t *nic) {
 			return;
 		}
 
+#if defined(WILC_SDIO) && defined(HAS_SUSPEND_RESUME) && defined(WILC_OPTIMIZE_SLEEP_INT)
+		cancel_work_sync(&g_linux_wlan->fw_reload_work);
+#endif
+
 #if defined(PLAT_ALLWINNER_A20) || defined(PLAT_ALLWINNER_A23) || defined(PLAT_ALLWINNER_A31)
 		// johnny : remove
 		PRINT_D(INIT_DBG,"skip wilc_bus_set_default_speed\n");
@@ -1500,9 +1646,15 @@ void wilc1000_wlan_deinit(linux_wlan_t *nic) {
 	deinit_irq(g_linux_wlan);
 
 
-	if(&g_linux_wlan->oup != NULL){
+	/* leave the firmware running if it can be picked up again on the next open */
+	g_linux_wlan->fw_kept_running = fw_cache && g_linux_wlan->wilc_firmware != NULL &&
+					g_linux_wlan->fw_running_crc != 0;
+	if(g_linux_wlan->fw_kept_running){
+		g_linux_wlan->oup.wlan_keep_fw(1);
+	}else if(&g_linux_wlan->oup != NULL){
 		if(g_linux_wlan->oup.wlan_stop != NULL)
 			g_linux_wlan->oup.wlan_stop();		
+		g_linux_wlan->fw_running_crc = 0;
 	}
 
 	PRINT_D(INIT_DBG,"Deinitializing WILC Wlan\n");
@@ -1539,6 +1691,8 @@ int wlan_init_locks(linux_wlan_t* p_nic){
 	/*initialize mutexes*/
 	linux_wlan_init_mutex("hif_lock/hif_cs",&g_linux_wlan->hif_cs,1);
 	linux_wlan_init_mutex("rxq_lock/rxq_cs",&g_linux_wlan->rxq_cs,1);
+	linux_wlan_init_mutex("cfg_rxq_lock/cfg_rxq_cs",&g_linux_wlan->cfg_rxq_cs,1);
+	linux_wlan_init_mutex("cfg_txn_lock/cfg_txn_cs",&g_linux_wlan->cfg_txn_cs,1);
 	linux_wlan_init_mutex("txq_lock/txq_cs",&g_linux_wlan->txq_cs,1);
 
 	/*Added by Amr - BugID_4720*/
@@ -1549,6 +1703,7 @@ int wlan_init_locks(linux_wlan_t* p_nic){
 	
 	linux_wlan_init_lock("txq_wait/txq_event",&g_linux_wlan->txq_event,0);
 	linux_wlan_init_lock("rxq_wait/rxq_event",&g_linux_wlan->rxq_event,0);	
+	linux_wlan_init_lock("cfg_rxq_wait/cfg_rxq_event",&g_linux_wlan->cfg_rxq_event,0);
 
 	linux_wlan_init_lock("cfg_wait/cfg_event",&g_linux_wlan->cfg_event,0);
 	linux_wlan_init_lock("sync_event",&g_linux_wlan->sync_event,0);
@@ -1572,6 +1727,12 @@ static int wlan_deinit_locks(linux_wlan_t* nic){
 	if(&g_linux_wlan->rxq_cs != NULL)
 		linux_wlan_deinit_mutex(&g_linux_wlan->rxq_cs);
 
+	if(&g_linux_wlan->cfg_rxq_cs != NULL)
+		linux_wlan_deinit_mutex(&g_linux_wlan->cfg_rxq_cs);
+
+	if(&g_linux_wlan->cfg_txn_cs != NULL)
+		linux_wlan_deinit_mutex(&g_linux_wlan->cfg_txn_cs);
+
 	if(&g_linux_wlan->txq_cs != NULL)
 		linux_wlan_deinit_mutex(&g_linux_wlan->txq_cs);
 
@@ -1582,6 +1743,9 @@ static int wlan_deinit_locks(linux_wlan_t* nic){
 	if(&g_linux_wlan->rxq_event != NULL)
 		linux_wlan_deinit_lock(&g_linux_wlan->rxq_event);	
 
+	if(&g_linux_wlan->cfg_rxq_event != NULL)
+		linux_wlan_deinit_lock(&g_linux_wlan->cfg_rxq_event);
+
 	if(&g_linux_wlan->txq_event != NULL)
 		linux_wlan_deinit_lock(&g_linux_wlan->txq_event);
 
@@ -1610,6 +1774,7 @@ void linux_to_wlan(wilc_wlan_inp_t* nwi,linux_wlan_t* nic){
 	nwi->os_context.hif_critical_section = (void *)&g_linux_wlan->hif_cs;
 	nwi->os_context.os_private = (void *)nic;
 	nwi->os_context.tx_buffer_size = LINUX_TX_SIZE;
+	nwi->os_context.fw_chunk_size = fw_chunk_size;
 	nwi->os_context.txq_critical_section = (void *)&g_linux_wlan->txq_cs;
 
 	/*Added by Amr - BugID_4720*/
@@ -1625,6 +1790,9 @@ void linux_to_wlan(wilc_wlan_inp_t* nwi,linux_wlan_t* nic){
 #endif
 	nwi->os_context.rxq_critical_section = (void *)&g_linux_wlan->rxq_cs;
 	nwi->os_context.rxq_wait_event = (void *)&g_linux_wlan->rxq_event;
+	nwi->os_context.cfg_rxq_critical_section = (void *)&g_linux_wlan->cfg_rxq_cs;
+	nwi->os_context.cfg_txn_critical_section = (void *)&g_linux_wlan->cfg_txn_cs;
+	nwi->os_context.cfg_rxq_wait_event = (void *)&g_linux_wlan->cfg_rxq_event;
 	nwi->os_context.cfg_wait_event = (void *)&g_linux_wlan->cfg_event;
 
 	nwi->os_func.os_sleep = linux_wlan_msleep;
@@ -1666,8 +1834,10 @@ void linux_to_wlan(wilc_wlan_inp_t* nwi,linux_wlan_t* nic){
 	#ifdef WILC_FULLY_HOSTING_AP
 	/* incase of Fully hosted AP, all non cfg pkts are processed here*/
 	nwi->net_func.rx_indicate = WILC_Process_rx_frame;
+	nwi->net_func.rx_indicate_batch = NULL;
 	#else
 	nwi->net_func.rx_indicate = frmw_to_linux;
+	nwi->net_func.rx_indicate_batch = frmw_to_linux_batch;
 	#endif
 	nwi->net_func.rx_complete = linux_wlan_rx_complete;
 	nwi->indicate_func.mac_indicate = linux_wlan_mac_indicate;
@@ -1725,14 +1895,33 @@ int wlan_initialize_threads(perInterface_wlan_t* nic){
 #endif	
 	/* wait for TXQ task to start. */
 	linux_wlan_lock(&g_linux_wlan->txq_thread_started);
+
+	/* create cfg/mgmt rx task, niced so it yields to the data path */
+	PRINT_D(INIT_DBG,"Creating kthread for config reception\n");
+	g_linux_wlan->cfg_rxq_thread = kthread_run(linux_wlan_cfg_rxq_task,(void*)g_linux_wlan,"K_CFG_RXQ");
+	if(g_linux_wlan->cfg_rxq_thread == 0){
+		PRINT_ER("couldn't create Cfg RXQ thread\n");
+		ret = -ENOBUFS;
+		goto _fail_3;
+	}
+	set_user_nice(g_linux_wlan->cfg_rxq_thread, 5);
 	
 	return 0;
+
+	_fail_3:
+		g_linux_wlan->close = 1;
+		linux_wlan_unlock(&g_linux_wlan->txq_event);
+		kthread_stop(g_linux_wlan->txq_thread);
+		g_linux_wlan->txq_thread = NULL;
 	
 	_fail_2:
 		/*De-Initialize 2nd thread*/
 		g_linux_wlan->close = 1;
 		linux_wlan_unlock(&g_linux_wlan->rxq_event);
-		kthread_stop(g_linux_wlan->rxq_thread);
+		if(g_linux_wlan->rxq_thread != NULL){
+			kthread_stop(g_linux_wlan->rxq_thread);
+			g_linux_wlan->rxq_thread = NULL;
+		}
 
 	_fail_1:
 	#if(RX_BH_TYPE == RX_BH_KTHREAD)
@@ -1768,6 +1957,14 @@ static void wlan_deinitialize_threads(linux_wlan_t* nic){
 		kthread_stop(g_linux_wlan->txq_thread);
 		g_linux_wlan->txq_thread = NULL;
 		}
+
+	if(&g_linux_wlan->cfg_rxq_event != NULL)
+		linux_wlan_unlock(&g_linux_wlan->cfg_rxq_event);
+
+	if(g_linux_wlan->cfg_rxq_thread != NULL){
+		kthread_stop(g_linux_wlan->cfg_rxq_thread);
+		g_linux_wlan->cfg_rxq_thread = NULL;
+		}
 	
 	#if(RX_BH_TYPE == RX_BH_KTHREAD)
 		if(&g_linux_wlan->rx_sem != NULL)
@@ -1878,6 +2075,223 @@ int repeat_power_cycle(perInterface_wlan_t* nic)
 }
 #endif
 
+/*
+ * Bring-up timing. Each stage records when it started and finished so the
+ * overlap of the host interface init with the chip bring-up is visible.
+ */
+static void linux_wlan_bringup_begin(void)
+{
+	tstrBringupStats* pstrStats = &g_linux_wlan->strBringupStats;
+
+	memset(pstrStats, 0, sizeof(tstrBringupStats));
+	pstrStats->tStart = ktime_get();
+	pstrStats->bActive = 1;
+}
+
+static void linux_wlan_stage_begin(tenuBringupStage enuStage)
+{
+	if(g_linux_wlan->strBringupStats.bActive)
+		g_linux_wlan->strBringupStats.astrStage[enuStage].start = ktime_get();
+}
+
+static void linux_wlan_stage_end(tenuBringupStage enuStage)
+{
+	if(g_linux_wlan->strBringupStats.bActive)
+		g_linux_wlan->strBringupStats.astrStage[enuStage].end = ktime_get();
+}
+
+static void linux_wlan_bringup_end(int ready)
+{
+	tstrBringupStats* pstrStats = &g_linux_wlan->strBringupStats;
+
+	if(!pstrStats->bActive)
+		return;
+	if(ready)
+		pstrStats->tReady = ktime_get();
+	pstrStats->bActive = 0;
+}
+
+#ifdef USE_WIRELESS
+/*
+ * Host interface init only sets up host side state (host_int_init(),
+ * CoreConfiguratorInit(), timers and the hostIF thread) and doesn't touch
+ * the chip, so mac_open() runs it from here while wilc1000_wlan_init()
+ * powers, boots and loads the chip.
+ */
+static void linux_wlan_host_int_work(struct work_struct *work)
+{
+	linux_wlan_stage_begin(BRINGUP_HOST_INT);
+	g_linux_wlan->host_int_ret = WILC_WFI_InitHostInt(g_linux_wlan->host_int_ndev);
+	linux_wlan_stage_end(BRINGUP_HOST_INT);
+}
+
+static void linux_wlan_host_int_start(struct net_device *ndev)
+{
+	g_linux_wlan->host_int_ndev = ndev;
+	g_linux_wlan->host_int_ret = -1;
+	INIT_WORK(&g_linux_wlan->host_int_work, linux_wlan_host_int_work);
+	schedule_work(&g_linux_wlan->host_int_work);
+}
+
+/* Join the host interface init. Can be called more than once. */
+static int linux_wlan_host_int_wait(void)
+{
+	flush_work(&g_linux_wlan->host_int_work);
+	return g_linux_wlan->host_int_ret;
+}
+#endif
+
+#if defined (WILC_DEBUGFS)
+static const char* const bringup_stage_name[BRINGUP_STAGES] = {
+	"locks", "wlan_init", "threads", "irq", "fw_get", "fw_download",
+	"fw_start", "fw_version", "host_int", "host_int_wait", "init_config",
+};
+
+int linux_wlan_dump_bringup_stats(char *buf, int size)
+{
+	tstrBringupStats strStats;
+	int res = 0;
+	int i;
+
+	if(g_linux_wlan == NULL)
+		return scnprintf(buf, size, "not initialized\n");
+
+	memcpy(&strStats, &g_linux_wlan->strBringupStats, sizeof(tstrBringupStats));
+
+	res += scnprintf(buf + res, size - res, "%-14s %10s %10s %10s\n", "stage", "start_us", "end_us", "span_us");
+	for(i = 0; i < BRINGUP_STAGES; i++)
+	{
+		tstrBringupStage* pstrStage = &strStats.astrStage[i];
+
+		if(ktime_to_ns(pstrStage->start) == 0)
+			continue;
+		res += scnprintf(buf + res, size - res, "%-14s %10lld %10lld %10lld\n",
+			bringup_stage_name[i],
+			ktime_us_delta(pstrStage->start, strStats.tStart),
+			ktime_us_delta(pstrStage->end, strStats.tStart),
+			ktime_us_delta(pstrStage->end, pstrStage->start));
+	}
+	if(strStats.bActive)
+		res += scnprintf(buf + res, size - res, "time to ready: in progress\n");
+	else if(ktime_to_ns(strStats.tReady) != 0)
+		res += scnprintf(buf + res, size - res, "time to ready: %lld us\n",
+			ktime_us_delta(strStats.tReady, strStats.tStart));
+	else
+		res += scnprintf(buf + res, size - res, "time to ready: failed\n");
+
+	return res;
+}
+
+int wilc_wlan_fw_download_check(const uint8_t *image, uint32_t image_size, char *buf, int size);
+
+/* Check the compressed download path against the plain one on the cached image */
+int linux_wlan_fw_check(char *buf, int size)
+{
+	if(g_linux_wlan == NULL || g_linux_wlan->wilc_firmware == NULL)
+		return scnprintf(buf, size, "no cached firmware image\n");
+
+	return wilc_wlan_fw_download_check(g_linux_wlan->wilc_firmware->data,
+		g_linux_wlan->wilc_firmware->size, buf, size);
+}
+#endif
+
+/*
+ * Decide whether the firmware left running by the last deinit can be
+ * reused as is. It has to be the image we have cached, the chip must still
+ * run it with our host configuration, and it must answer a config query.
+ * Otherwise any firmware still running is stopped so it can be reloaded.
+ */
+static int linux_wlan_reuse_firmware(void)
+{
+	int kept = g_linux_wlan->fw_kept_running;
+
+	g_linux_wlan->fw_kept_running = 0;
+
+	if(kept && fw_cache && g_linux_wlan->wilc_firmware != NULL &&
+	   g_linux_wlan->fw_running_crc == g_linux_wlan->fw_image_crc &&
+	   g_linux_wlan->oup.wlan_fw_running(1))
+	{
+		if(g_linux_wlan->oup.wlan_cfg_get(1, WID_FIRMWARE_VERSION, 1, 0))
+			return 1;
+		PRINT_ER("Running firmware doesn't respond, reloading it\n");
+	}
+
+	g_linux_wlan->fw_running_crc = 0;
+	/* stop a firmware we left running even if it didn't answer. Any other
+	   one may never have been loaded, don't try to wake the chip for it */
+	if(kept || g_linux_wlan->oup.wlan_fw_running(0))
+		g_linux_wlan->oup.wlan_stop();
+	return 0;
+}
+
+#if defined(WILC_SDIO) && defined(HAS_SUSPEND_RESUME) && defined(WILC_OPTIMIZE_SLEEP_INT)
+/*
+ * The chip was to stay powered over suspend but came back reset. Load and
+ * start the firmware again and write the default configuration, as
+ * wilc1000_wlan_init() does. Any association went with the old firmware,
+ * so the connected handles are disconnected to tell the upper layers.
+ */
+static void linux_wlan_fw_reload_work(struct work_struct *work)
+{
+	struct net_device* ndev = g_linux_wlan->strInterfaceInfo[0].wilc_netdev;
+	perInterface_wlan_t* nic = netdev_priv(ndev);
+	struct WILC_WFI_priv* priv;
+	tstrWILC_WFIDrv* pstrWFIDrv;
+	int i;
+
+	if(!g_linux_wlan->wilc1000_initialized)
+		return;
+
+	PRINT_D(INIT_DBG,"Reloading firmware after resume\n");
+	for(i = 0; i < g_linux_wlan->u8NoIfcs; i++)
+		netif_stop_queue(g_linux_wlan->strInterfaceInfo[i].wilc_netdev);
+
+	/* the reset chip answers none of the cfg frames in flight, fail them so
+	   the host interface workers don't sit out the timeouts while draining.
+	   Messages queued from here on are parked until the reload is done. */
+	g_linux_wlan->oup.wlan_cfg_abort_all();
+	host_int_wait_msg_queue_idle();
+	g_linux_wlan->oup.wlan_cfg_abort_all();
+
+	g_linux_wlan->fw_running_crc = 0;
+	if(g_linux_wlan->oup.wlan_fw_running(0))
+		g_linux_wlan->oup.wlan_stop();
+	g_linux_wlan->mac_status = WILC_MAC_STATUS_INIT;
+
+	if(linux_wlan_get_firmware(nic) ||
+	   linux_wlan_firmware_download(g_linux_wlan) < 0 ||
+	   linux_wlan_start_firmware(nic) < 0)
+	{
+		PRINT_ER("Failed to reload firmware after resume, reopen the interface\n");
+		host_int_resume_msg_queue();
+		return;
+	}
+	g_linux_wlan->fw_running_crc = g_linux_wlan->fw_image_crc;
+	host_int_wid_shadow_resync();
+
+	if(linux_wlan_init_test_config(ndev, g_linux_wlan) < 0)
+		PRINT_ER("Failed to configure firmware after resume\n");
+
+	host_int_resume_msg_queue();
+
+	for(i = 0; i < g_linux_wlan->u8NoIfcs; i++)
+	{
+		ndev = g_linux_wlan->strInterfaceInfo[i].wilc_netdev;
+		priv = wiphy_priv(ndev->ieee80211_ptr->wiphy);
+		pstrWFIDrv = (tstrWILC_WFIDrv *)priv->hWILCWFIDrv;
+		if(pstrWFIDrv != NULL && pstrWFIDrv->enuHostIFstate != HOST_IF_IDLE)
+			host_int_disconnect((WILC_WFIDrvHandle)pstrWFIDrv, 1);
+		netif_wake_queue(ndev);
+	}
+}
+
+/* Called from the SDIO resume callback, which can't wait for the firmware to start */
+void linux_wlan_resume_reload(void)
+{
+	schedule_work(&g_linux_wlan->fw_reload_work);
+}
+#endif
+
 int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 {
 	wilc_wlan_inp_t nwi;
@@ -1890,11 +2304,18 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 		g_linux_wlan->close = 0;
 		g_linux_wlan->wilc1000_initialized = 0;
 
+		if(!g_linux_wlan->strBringupStats.bActive)
+			linux_wlan_bringup_begin();
+
+		linux_wlan_stage_begin(BRINGUP_LOCKS);
 		wlan_init_locks(g_linux_wlan);
+		linux_wlan_stage_end(BRINGUP_LOCKS);
 		
 		linux_to_wlan(&nwi,g_linux_wlan);
 
+		linux_wlan_stage_begin(BRINGUP_WLAN_INIT);
 		ret = wilc_wlan_init(&nwi, &nwo);
+		linux_wlan_stage_end(BRINGUP_WLAN_INIT);
 		if (ret < 0) {
 			PRINT_ER("Initializing WILC_Wlan FAILED\n");
 			ret = -EIO;
@@ -1906,13 +2327,16 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 		gpstrWlanOps = &g_linux_wlan->oup;
 
 
+		linux_wlan_stage_begin(BRINGUP_THREADS);
 		ret = wlan_initialize_threads(nic);
+		linux_wlan_stage_end(BRINGUP_THREADS);
 		if (ret < 0) {
 			PRINT_ER("Initializing Threads FAILED\n");
 			ret = -EIO;
 			goto _fail_wilc_wlan_;
 		}
 	
+		linux_wlan_stage_begin(BRINGUP_IRQ);
 #if (defined WILC_SDIO) && (defined COMPLEMENT_BOOT)
 		if(wilc1000_prepare_11b_core(&nwi,&nwo,g_linux_wlan)){
 			PRINT_ER("11b Core is not ready\n");
@@ -1936,16 +2360,25 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 			goto _fail_irq_init_;
 		}		
 #endif
+		linux_wlan_stage_end(BRINGUP_IRQ);
 
+		if(linux_wlan_reuse_firmware()){
+			PRINT_INFO(INIT_DBG,"Firmware still running, skipping download\n");
+			g_linux_wlan->mac_status = WILC_MAC_STATUS_READY;
+		}else{
+		linux_wlan_stage_begin(BRINGUP_FW_GET);
 		if(linux_wlan_get_firmware(nic)){
 			PRINT_ER("Can't get firmware \n");
 			ret = -EIO;
 			goto _fail_irq_enable_;
 		}
+		linux_wlan_stage_end(BRINGUP_FW_GET);
 
 		
 		/*Download firmware*/
+		linux_wlan_stage_begin(BRINGUP_FW_DOWNLOAD);
 		ret = linux_wlan_firmware_download(g_linux_wlan);
+		linux_wlan_stage_end(BRINGUP_FW_DOWNLOAD);
 		if(ret < 0){
 			PRINT_ER("Failed to download firmware\n");
 			ret = -EIO;
@@ -1953,15 +2386,22 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 		}
 
 		/* Start firmware*/
+		linux_wlan_stage_begin(BRINGUP_FW_START);
 		ret = linux_wlan_start_firmware(nic);
+		linux_wlan_stage_end(BRINGUP_FW_START);
 		if(ret < 0){
 			PRINT_ER("Failed to start firmware\n");
 			ret = -EIO;
 			goto _fail_irq_enable_;
 		}
+		g_linux_wlan->fw_running_crc = g_linux_wlan->fw_image_crc;
+		/* a fresh firmware holds none of the config written so far */
+		host_int_wid_shadow_resync();
+		}
 
 		wilc_bus_set_max_speed();
 
+		linux_wlan_stage_begin(BRINGUP_FW_VERSION);
 		if (g_linux_wlan->oup.wlan_cfg_get(1, WID_FIRMWARE_VERSION, 1,0))
 		{
 			int size; 
@@ -1972,8 +2412,24 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 			Firmware_ver[size] = '\0';
 			PRINT_D(INIT_DBG,"***** Firmware Ver = %s  *******\n",Firmware_ver);
 		}
+		linux_wlan_stage_end(BRINGUP_FW_VERSION);
+
+#ifdef USE_WIRELESS
+		/* The default configuration carries the driver handle from host_int_init() */
+		linux_wlan_stage_begin(BRINGUP_HOST_INT_WAIT);
+		ret = linux_wlan_host_int_wait();
+		linux_wlan_stage_end(BRINGUP_HOST_INT_WAIT);
+		if(ret < 0){
+			PRINT_ER("Failed to initialize host interface\n");
+			ret = -EIO;
+			goto _fail_fw_start_;
+		}
+#endif
+
 		/* Initialize firmware with default configuration */
+		linux_wlan_stage_begin(BRINGUP_INIT_CONFIG);
 		ret = linux_wlan_init_test_config(dev, g_linux_wlan);
+		linux_wlan_stage_end(BRINGUP_INIT_CONFIG);
 
 		if(ret < 0){
 			PRINT_ER("Failed to configure firmware\n");
@@ -1982,6 +2438,7 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 		}
 
 		g_linux_wlan->wilc1000_initialized = 1;
+		linux_wlan_bringup_end(1);
 		return 0; /*success*/
 
 
@@ -1990,6 +2447,7 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 		if(g_linux_wlan->oup.wlan_stop != NULL)
 			g_linux_wlan->oup.wlan_stop();		
 	}
+	g_linux_wlan->fw_running_crc = 0;
 
 	_fail_irq_enable_:
 #if (defined WILC_SDIO) && (!defined WILC_SDIO_IRQ_GPIO)
@@ -2006,6 +2464,7 @@ int wilc1000_wlan_init(struct net_device *dev,perInterface_wlan_t* p_nic)
 		wilc_wlan_deinit(g_linux_wlan);
 	_fail_locks_:
 		wlan_deinit_locks(g_linux_wlan);
+		linux_wlan_bringup_end(0);
 		PRINT_ER("WLAN Iinitialization FAILED\n");
 	}else{
 		PRINT_D(INIT_DBG,"wilc1000 already initialized\n");
@@ -2066,22 +2525,31 @@ int mac_open(struct net_device *ndev){
 	PRINT_D(INIT_DBG,"MAC OPEN[%p]\n",ndev);
 
 	#ifdef USE_WIRELESS
-	ret = WILC_WFI_InitHostInt(ndev);
-	if(ret < 0)
-	{
-		PRINT_ER("Failed to initialize host interface\n");
-
-		return  ret;
-	}
+	if(!g_linux_wlan->wilc1000_initialized)
+		linux_wlan_bringup_begin();
+	/* Runs alongside the chip bring-up, joined before the first config write */
+	linux_wlan_host_int_start(ndev);
 	#endif
 	
 	/*initialize platform*/
 	PRINT_D(INIT_DBG,"*** re-init ***\n");
 	ret = wilc1000_wlan_init(ndev, nic);
+	#ifdef USE_WIRELESS
+	status = linux_wlan_host_int_wait();
+	if(status < 0)
+	{
+		PRINT_ER("Failed to initialize host interface\n");
+		if(ret == 0)
+			ret = status;
+	}
+	#endif
 	if(ret < 0)
 	{
 		PRINT_ER("Failed to initialize wilc1000\n");
-		WILC_WFI_DeInitHostInt(ndev);
+		#ifdef USE_WIRELESS
+		if(status == 0)
+			WILC_WFI_DeInitHostInt(ndev);
+		#endif
 		return  ret;
 	}
 
@@ -2603,95 +3071,129 @@ done:
 	return s32Error;
 }
 
-void frmw_to_linux(uint8_t *buff, uint32_t size,uint32_t pkt_offset){
+/*
+ * Builds the skb for a received data frame and resolves its interface.
+ * Returns NULL if the frame has to be dropped.
+ */
+static struct sk_buff* linux_wlan_rx_skb(uint8_t *buff, uint32_t size,uint32_t pkt_offset,perInterface_wlan_t** pnic){
 
-    unsigned int frame_len = 0;	
-	int stats;
+	unsigned int frame_len = 0;	
 	unsigned char* buff_to_send = NULL;	    
 	struct sk_buff *skb;
-	char*pu8UdpBuffer;
-	struct iphdr *ih;
 	struct net_device* wilc_netdev;
-	perInterface_wlan_t *nic;
 
 	wilc_netdev = GetIfHandler(buff);
 	if(wilc_netdev == NULL)
-		return;
+		return NULL;
 	
 	buff += pkt_offset;
-   	nic = netdev_priv(wilc_netdev);
 
-		if(size > 0){
+	if(size == 0){
+		#ifndef TCP_ENHANCEMENTS
+		PRINT_ER("Discard sending packet with len = %d\n",size);
+		#endif
+		return NULL;
+	}
 
-			frame_len = size;
-			buff_to_send = buff;
-			
-			
-			/* Need to send the packet up to the host, allocate a skb buffer */
-		    	skb = dev_alloc_skb(frame_len);
-		    	if(skb == NULL){
-		       	 	PRINT_ER("Low memory - packet droped\n");
-		        	return;
-			    }
+	frame_len = size;
+	buff_to_send = buff;
 
-			skb_reserve(skb, (unsigned int)skb->data & 0x3);
+	/* Need to send the packet up to the host, allocate a skb buffer */
+	skb = dev_alloc_skb(frame_len);
+	if(skb == NULL){
+		PRINT_ER("Low memory - packet droped\n");
+		return NULL;
+	}
 
-			if(g_linux_wlan == NULL || wilc_netdev == NULL){
-			    PRINT_ER("wilc_netdev in g_linux_wlan is NULL");
-			}
-			skb->dev = wilc_netdev;
-	
-			if(skb->dev == NULL){
-				PRINT_ER("skb->dev is NULL\n");
-			}
-			
-			/*
-			for(i=0;i<40;i++)
-			{
-				if(i<frame_len)
-					WILC_PRINTF("buff_to_send[%d]=%2x\n",i,buff_to_send[i]);
+	skb_reserve(skb, (unsigned int)skb->data & 0x3);
+	skb->dev = wilc_netdev;
+
+	memcpy(skb_put(skb, frame_len),buff_to_send, frame_len);
 
-			}*/
+	skb->protocol = eth_type_trans(skb, wilc_netdev);
+	#ifndef TCP_ENHANCEMENTS
+	if(buff_to_send[35] == 67 && buff_to_send[37] == 68)
+	{
+		PRINT_D(RX_DBG,"DHCP Message received %x ,%x ,%x\n",buff_to_send[282],buff_to_send[283],buff_to_send[284]);
+	}
+	if(buff_to_send[12]==0x88&&buff_to_send[13]==0x8e)
+		PRINT_D(GENERIC_DBG,"eapol received\n");
+	#endif
+	skb->ip_summed = CHECKSUM_UNNECESSARY;
 
-			//skb_put(skb, frame_len);
-			memcpy(skb_put(skb, frame_len),buff_to_send, frame_len);
+	*pnic = netdev_priv(wilc_netdev);
+	return skb;
+}
 
-			//WILC_PRINTF("After MEM_CPY\n");
+void frmw_to_linux(uint8_t *buff, uint32_t size,uint32_t pkt_offset){
 
-			//nic = netdev_priv(wilc_netdev);
-			
-#ifdef USE_WIRELESS
-		/*	if(nic->monitor_flag)
-			{
-				WILC_WFI_monitor_rx(nic->wilc_netdev,skb);
-				return;
-			}*/
+	int stats;
+	struct sk_buff *skb;
+	perInterface_wlan_t *nic;
+
+	skb = linux_wlan_rx_skb(buff, size, pkt_offset, &nic);
+	if(skb == NULL)
+		return;
+
+	/* Send the packet to the stack by giving it to the bridge */
+	nic->netstats.rx_packets++;
+	nic->netstats.rx_bytes+=size;
+	stats = netif_rx(skb);
+	PRINT_D(RX_DBG,"netif_rx ret value is: %d\n",stats);
+}
+
+/*
+ * Delivers all data packets of one RX buffer. Interface stats are updated
+ * once per run of packets for the same interface, and on kernels that have
+ * it the whole lot goes up in a single netif_receive_skb_list() call.
+ */
+static void frmw_to_linux_batch(wilc_rx_pkt_t *pkts, uint32_t count){
+
+	struct sk_buff *skb;
+	perInterface_wlan_t *nic, *run_nic = NULL;
+	unsigned long run_packets = 0, run_bytes = 0;
+	uint32_t i;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,19,0)
+	LIST_HEAD(rx_list);
 #endif
-		    skb->protocol = eth_type_trans(skb, wilc_netdev);
-			#ifndef TCP_ENHANCEMENTS
-		    /*get source and dest ip addresses*/
-			ih = (struct iphdr *)(skb->data+sizeof(struct ethhdr));
 
-			pu8UdpBuffer = (char*)ih + sizeof(struct iphdr);
-			if(buff_to_send[35] == 67 && buff_to_send[37] == 68)
-			{
-				PRINT_D(RX_DBG,"DHCP Message received %x ,%x ,%x\n",buff_to_send[282],buff_to_send[283],buff_to_send[284]);
+	for(i = 0; i < count; i++){
+		skb = linux_wlan_rx_skb(pkts[i].buff, pkts[i].size, pkts[i].pkt_offset, &nic);
+		if(skb == NULL)
+			continue;
+
+		if(nic != run_nic){
+			if(run_nic != NULL){
+				run_nic->netstats.rx_packets += run_packets;
+				run_nic->netstats.rx_bytes += run_bytes;
 			}
-			if(buff_to_send[12]==0x88&&buff_to_send[13]==0x8e)
-				PRINT_D(GENERIC_DBG,"eapol received\n");
-			#endif
-		    /* Send the packet to the stack by giving it to the bridge */
-			nic->netstats.rx_packets++;
-			nic->netstats.rx_bytes+=frame_len;
-			skb->ip_summed = CHECKSUM_UNNECESSARY;
-			stats = netif_rx(skb);
-		    PRINT_D(RX_DBG,"netif_rx ret value is: %d\n",stats);
+			run_nic = nic;
+			run_packets = 0;
+			run_bytes = 0;
 		}
-		#ifndef TCP_ENHANCEMENTS
-		else{
-				PRINT_ER("Discard sending packet with len = %d\n",size);
-			}
-		#endif
+		run_packets++;
+		run_bytes += pkts[i].size;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,19,0)
+		list_add_tail(&skb->list, &rx_list);
+#else
+		netif_rx(skb);
+#endif
+	}
+
+	if(run_nic != NULL){
+		run_nic->netstats.rx_packets += run_packets;
+		run_nic->netstats.rx_bytes += run_bytes;
+	}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,19,0)
+	/* not in NAPI context, the receive path expects BHs off */
+	if(!list_empty(&rx_list)){
+		local_bh_disable();
+		netif_receive_skb_list(&rx_list);
+		local_bh_enable();
+	}
+#endif
 }
 
 void WILC_WFI_mgmt_rx(uint8_t *buff, uint32_t size)
@@ -2733,6 +3235,10 @@ int wilc_netdev_init(void){
 	/*create the common structure*/
 	g_linux_wlan=(linux_wlan_t*)WILC_MALLOC(sizeof(linux_wlan_t));
 	memset(g_linux_wlan,0,sizeof(linux_wlan_t));
+	spin_lock_init(&g_linux_wlan->bssid_map_lock);
+#if defined(WILC_SDIO) && defined(HAS_SUSPEND_RESUME) && defined(WILC_OPTIMIZE_SLEEP_INT)
+	INIT_WORK(&g_linux_wlan->fw_reload_work, linux_wlan_fw_reload_work);
+#endif
 	
 	/*Reset interrupt count debug*/
 	int_rcvdU= 0;
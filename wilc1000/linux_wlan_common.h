@@ -53,6 +53,28 @@ typedef enum { ANTENNA1  = 0,
 extern int wilc_debugfs_init(void);
 extern void wilc_debugfs_remove(void);
 
+extern int linux_wlan_dump_rx_demux_stats(char *buf, int size);
+extern int linux_wlan_dump_bringup_stats(char *buf, int size);
+extern int linux_wlan_fw_check(char *buf, int size);
+extern int wilc_wlan_dump_rx_burst_stats(char *buf, int size);
+extern int wilc_wlan_dump_wake_latency(char *buf, int size);
+extern int wilc_wlan_dump_fw_stats(char *buf, int size);
+extern int wilc_wlan_dump_cfg_stats(char *buf, int size);
+extern int wilc_wlan_cfg_bench_parse(char *buf, int size);
+extern int host_int_dump_wid_cache_stats(char *buf, int size);
+extern int host_int_dump_wid_shadow_stats(char *buf, int size);
+extern int host_int_dump_msg_stats(char *buf, int size);
+extern int host_int_dump_conn_trace(char *buf, int size);
+extern int host_int_bench_msg_queue(char *buf, int size);
+extern int host_int_bench_scan(char *buf, int size);
+extern int ParseNetworkInfoBench(char *buf, int size);
+#ifdef HAS_SUSPEND_RESUME
+extern int wilc_wlan_dump_resume_stats(char *buf, int size);
+#endif
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+extern int wilc_wlan_dump_sleep_stats(char *buf, int size);
+#endif
+
 extern atomic_t REGION;
 extern atomic_t DEBUG_LEVEL;
 
@@ -154,8 +154,16 @@ void chip_wakeup(void);
 void host_wakeup_notify(void);
 void host_sleep_notify(void);
 void chip_allow_sleep(void);
+void wilc_wlan_suspend_snapshot(void);
+int wilc_wlan_resume_state_retained(void);
+void wilc_wlan_resume_done(ktime_t start, int warm);
+void host_int_wid_shadow_resync(void);
+void linux_wlan_resume_reload(void);
 
 extern uint8_t u8SuspendOnEvent;
+/* the host agreed to keep the card powered over this suspend */
+static int bWarmSuspend = 0;
+
 static int wilc_sdio_suspend(struct device *dev)
 {
 	printk("\n\n << SUSPEND >>\n\n");
@@ -165,12 +173,19 @@ static int wilc_sdio_suspend(struct device *dev)
 		chip_sleep_manually(0xffffffff);
 	else
 	{
+		wilc_wlan_suspend_snapshot();
+		/*keep the chip powered so firmware and association survive the host sleep*/
+		if((sdio_get_host_pm_caps(local_sdio_func) & MMC_PM_KEEP_POWER) &&
+		   sdio_set_host_pm_flags(local_sdio_func, MMC_PM_KEEP_POWER) == 0)
+			bWarmSuspend = 1;
 	/*notify the chip that host will sleep*/
 		host_sleep_notify();
 		chip_allow_sleep();
 	}
 	/*reset SDIO to allow kerenl reintilaization at wake up*/
-	wilc_sdio_reset(NULL);
+	/*not needed if the card keeps power, the core will not re-enumerate it*/
+	if(!bWarmSuspend)
+		wilc_sdio_reset(NULL);
 	/*claim the host to prevent driver SDIO access before resume is called*/
 	sdio_claim_host(local_sdio_func);
 	return 0 ;
@@ -178,6 +193,10 @@ static int wilc_sdio_suspend(struct device *dev)
 
 static int wilc_sdio_resume(struct device *dev)
 {
+	ktime_t start = ktime_get();
+	int warm = 0;
+	int reload = 0;
+
 	sdio_release_host(local_sdio_func);
 	/*wake the chip to compelete the re-intialization*/
 	chip_wakeup();
@@ -188,7 +207,27 @@ static int wilc_sdio_resume(struct device *dev)
 	if(u8SuspendOnEvent == 1)
 		host_wakeup_notify();
 
+	if(bWarmSuspend)
+	{
+		warm = wilc_wlan_resume_state_retained();
+		if(!warm)
+		{
+			/*the firmware is gone, reset the function and load it again*/
+			PRINT_ER("Chip lost its state over suspend, reloading firmware\n");
+			wilc_sdio_reset(NULL);
+			sdio_init(NULL,NULL);
+			reload = 1;
+		}
+		bWarmSuspend = 0;
+	}
+
 	chip_allow_sleep();
+	/*the firmware was restarted, config has to be written again*/
+	if(!warm)
+		host_int_wid_shadow_resync();
+	wilc_wlan_resume_done(start, warm);
+	if(reload)
+		linux_wlan_resume_reload();
     return 0;
 
 }
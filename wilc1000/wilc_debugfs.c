@@ -14,6 +14,7 @@
 #include <linux/debugfs.h>
 #include <linux/poll.h>
 #include <linux/sched.h>
+#include <linux/slab.h>
 
 #include "wilc_wlan_if.h"
 
@@ -116,6 +117,121 @@ static ssize_t wilc_debug_region_write(struct file *filp, const char *buf, size_
 	return count;
 }
 
+/*
+ * Statistics files: each one formats its counters through a dump callback
+ * exported by the module that owns them.
+ */
+static ssize_t wilc_debugfs_dump(char __user *userbuf, size_t count, loff_t *ppos, int (*dump)(char *, int))
+{
+	char *buf;
+	int res = 0;
+	ssize_t ret;
+
+	/* only allow read from start */
+	if (*ppos > 0)
+		return 0;
+
+	buf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	res = dump(buf, PAGE_SIZE);
+	ret = simple_read_from_buffer(userbuf, count, ppos, buf, res);
+	kfree(buf);
+
+	return ret;
+}
+
+static ssize_t wilc_rx_demux_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, linux_wlan_dump_rx_demux_stats);
+}
+
+static ssize_t wilc_cfg_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_dump_cfg_stats);
+}
+
+static ssize_t wilc_bringup_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, linux_wlan_dump_bringup_stats);
+}
+
+static ssize_t wilc_wid_cache_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, host_int_dump_wid_cache_stats);
+}
+
+static ssize_t wilc_wid_shadow_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, host_int_dump_wid_shadow_stats);
+}
+
+static ssize_t wilc_hif_msgs_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, host_int_dump_msg_stats);
+}
+
+static ssize_t wilc_conn_trace_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, host_int_dump_conn_trace);
+}
+
+/* benchmarks, they run each time the file is read */
+static ssize_t wilc_bench_msgq_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, host_int_bench_msg_queue);
+}
+
+static ssize_t wilc_bench_scan_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, host_int_bench_scan);
+}
+
+static ssize_t wilc_bench_parse_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, ParseNetworkInfoBench);
+}
+
+static ssize_t wilc_bench_cfg_parse_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_cfg_bench_parse);
+}
+
+static ssize_t wilc_rx_bursts_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_dump_rx_burst_stats);
+}
+
+static ssize_t wilc_wake_latency_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_dump_wake_latency);
+}
+
+static ssize_t wilc_fw_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_dump_fw_stats);
+}
+
+static ssize_t wilc_fw_check_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, linux_wlan_fw_check);
+}
+
+#ifdef HAS_SUSPEND_RESUME
+static ssize_t wilc_resume_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_dump_resume_stats);
+}
+#endif
+
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+static ssize_t wilc_sleep_read(struct file *file, char __user *userbuf, size_t count, loff_t *ppos)
+{
+	return wilc_debugfs_dump(userbuf, count, ppos, wilc_wlan_dump_sleep_stats);
+}
+#endif
+
 /*
 --------------------------------------------------------------------------------
 */
@@ -138,6 +254,27 @@ struct wilc_debugfs_info_t {
 static struct wilc_debugfs_info_t debugfs_info[] = {
 	{ "wilc_debug_level",	0666,	(DEBUG | ERR), FOPS(NULL, wilc_debug_level_read, wilc_debug_level_write,NULL), },
 	{ "wilc_debug_region",	0666,	(INIT_DBG | GENERIC_DBG | CFG80211_DBG), FOPS(NULL, wilc_debug_region_read, wilc_debug_region_write, NULL), },
+	{ "wilc_rx_demux",	0444,	0, FOPS(NULL, wilc_rx_demux_read, NULL, NULL), },
+	{ "wilc_rx_bursts",	0444,	0, FOPS(NULL, wilc_rx_bursts_read, NULL, NULL), },
+	{ "wilc_wake_latency",	0444,	0, FOPS(NULL, wilc_wake_latency_read, NULL, NULL), },
+	{ "wilc_fw",		0444,	0, FOPS(NULL, wilc_fw_read, NULL, NULL), },
+	{ "wilc_fw_check",	0400,	0, FOPS(NULL, wilc_fw_check_read, NULL, NULL), },
+	{ "wilc_cfg",		0444,	0, FOPS(NULL, wilc_cfg_read, NULL, NULL), },
+	{ "wilc_bringup",	0444,	0, FOPS(NULL, wilc_bringup_read, NULL, NULL), },
+	{ "wilc_wid_cache",	0444,	0, FOPS(NULL, wilc_wid_cache_read, NULL, NULL), },
+	{ "wilc_wid_shadow",	0444,	0, FOPS(NULL, wilc_wid_shadow_read, NULL, NULL), },
+	{ "wilc_hif_msgs",	0444,	0, FOPS(NULL, wilc_hif_msgs_read, NULL, NULL), },
+	{ "wilc_conn_trace",	0444,	0, FOPS(NULL, wilc_conn_trace_read, NULL, NULL), },
+	{ "wilc_bench_msgq",	0400,	0, FOPS(NULL, wilc_bench_msgq_read, NULL, NULL), },
+	{ "wilc_bench_scan",	0400,	0, FOPS(NULL, wilc_bench_scan_read, NULL, NULL), },
+	{ "wilc_bench_parse",	0400,	0, FOPS(NULL, wilc_bench_parse_read, NULL, NULL), },
+	{ "wilc_bench_cfg_parse",	0400,	0, FOPS(NULL, wilc_bench_cfg_parse_read, NULL, NULL), },
+#ifdef HAS_SUSPEND_RESUME
+	{ "wilc_resume",	0444,	0, FOPS(NULL, wilc_resume_read, NULL, NULL), },
+#endif
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+	{ "wilc_sleep",		0444,	0, FOPS(NULL, wilc_sleep_read, NULL, NULL), },
+#endif
 };
 
 int wilc_debugfs_init(void)
@@ -3,6 +3,9 @@
 
 #ifdef CONFIG_WILC_MEMORY_FEATURE
 
+#if defined (WILC_DEBUGFS)
+atomic_t gWilcMemAllocs = ATOMIC_INIT(0);
+#endif
 
 /*!
 *  @author	syounan
@@ -14,6 +17,9 @@ void* WILC_MemoryAlloc(WILC_Uint32 u32Size, tstrWILC_MemoryAttrs* strAttrs,
 {
 	if(u32Size > 0)
 	{
+		#if defined (WILC_DEBUGFS)
+		atomic_inc(&gWilcMemAllocs);
+		#endif
 		return kmalloc(u32Size, GFP_ATOMIC);
 	}
 	else
@@ -30,6 +36,9 @@ void* WILC_MemoryAlloc(WILC_Uint32 u32Size, tstrWILC_MemoryAttrs* strAttrs,
 void* WILC_MemoryCalloc(WILC_Uint32 u32Size, tstrWILC_MemoryAttrs* strAttrs,
 	WILC_Char* pcFileName, WILC_Uint32 u32LineNo)
 {
+	#if defined (WILC_DEBUGFS)
+	atomic_inc(&gWilcMemAllocs);
+	#endif
 	return kcalloc(u32Size, 1,GFP_KERNEL);
 }
 
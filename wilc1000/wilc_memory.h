@@ -326,5 +326,13 @@ to true
 	WILC_FREE_IF_TRUE_EX(__ptr__, WILC_NULL)
 
 	
+#if defined (WILC_DEBUGFS)
+/*!
+@brief	blocks handed out by WILC_MemoryAlloc() and WILC_MemoryCalloc() since
+the module was loaded, read by the benchmarks
+*/
+extern atomic_t gWilcMemAllocs;
+#endif
+
 #endif
 
@@ -3,6 +3,11 @@
 #include <linux/spinlock.h>
 #ifdef CONFIG_WILC_MSG_QUEUE_FEATURE
 
+/* each ring slot holds the message length followed by the message itself */
+#define MSG_QUEUE_SLOT(pHandle, u32Index)	\
+	((pHandle)->pu8Ring + ((u32Index) * (pHandle)->u32SlotSize))
+#define MSG_QUEUE_SLOT_HDR	sizeof(WILC_Uint32)
+
 
 /*!
 *  @author		syounan
@@ -18,10 +23,35 @@ WILC_ErrNo WILC_MsgQueueCreate(WILC_MsgQueueHandle* pHandle,
 	strSemAttrs.u32InitCount = 0;
 
 	spin_lock_init(&pHandle->strCriticalSection);
+
+	pHandle->pu8Ring = NULL;
+	pHandle->u32SlotSize = 0;
+	pHandle->u32Slots = 0;
+	pHandle->u32Head = 0;
+	pHandle->u32Count = 0;
+	pHandle->u32Overflows = 0;
+
+	/* preallocate the ring, so the steady state send/receive path never
+	   touches the allocator. Falls back to the heap list if it can't */
+	if( (pstrAttrs != WILC_NULL) && (pstrAttrs->u32MaxMsgs > 0) && (pstrAttrs->u32MaxMsgSize > 0) )
+	{
+		pHandle->u32SlotSize = MSG_QUEUE_SLOT_HDR + pstrAttrs->u32MaxMsgSize;
+		pHandle->pu8Ring = (WILC_Uint8*)WILC_MALLOC(pHandle->u32SlotSize * pstrAttrs->u32MaxMsgs);
+		if(pHandle->pu8Ring != NULL)
+		{
+			pHandle->u32Slots = pstrAttrs->u32MaxMsgs;
+		}
+		else
+		{
+			pHandle->u32SlotSize = 0;
+		}
+	}
+
 	if( (WILC_SemaphoreCreate(&pHandle->hSem, &strSemAttrs) == WILC_SUCCESS))
 	{
 	
 		pHandle->pstrMessageList = NULL;
+		pHandle->pstrMessageTail = NULL;
 		pHandle->u32ReceiversCount = 0;
 		pHandle->bExiting = WILC_FALSE;
 
@@ -29,6 +59,11 @@ WILC_ErrNo WILC_MsgQueueCreate(WILC_MsgQueueHandle* pHandle,
 	}
 	else
 	{
+		if(pHandle->pu8Ring != NULL)
+		{
+			WILC_FREE(pHandle->pu8Ring);
+			pHandle->pu8Ring = NULL;
+		}
 		return WILC_FAIL;
 	}
 }
@@ -57,9 +92,19 @@ WILC_ErrNo WILC_MsgQueueDestroy(WILC_MsgQueueHandle* pHandle,
 	while(pHandle->pstrMessageList != NULL)
 	{
 		Message * pstrMessge = pHandle->pstrMessageList->pstrNext;
+		WILC_FREE(pHandle->pstrMessageList->pvBuffer);
 		WILC_FREE(pHandle->pstrMessageList);
 		pHandle->pstrMessageList = pstrMessge;	
 	}
+	pHandle->pstrMessageTail = NULL;
+
+	if(pHandle->pu8Ring != NULL)
+	{
+		WILC_FREE(pHandle->pu8Ring);
+		pHandle->pu8Ring = NULL;
+	}
+	pHandle->u32Slots = 0;
+	pHandle->u32Count = 0;
 
 	return WILC_SUCCESS;
 }
@@ -89,8 +134,27 @@ WILC_ErrNo WILC_MsgQueueSend(WILC_MsgQueueHandle* pHandle,
 	}
 
 	spin_lock_irqsave(&pHandle->strCriticalSection,flags);
-	
-	/* construct a new message */
+
+	/* copy into a free slot, unless older messages are still waiting on
+	   the overflow list, which would break the ordering */
+	if( (pHandle->pstrMessageList == NULL) && (pHandle->u32Count < pHandle->u32Slots)
+		&& (u32SendBufferSize <= pHandle->u32SlotSize - MSG_QUEUE_SLOT_HDR) )
+	{
+		WILC_Uint8* pu8Slot = MSG_QUEUE_SLOT(pHandle, (pHandle->u32Head + pHandle->u32Count) % pHandle->u32Slots);
+
+		*(WILC_Uint32*)pu8Slot = u32SendBufferSize;
+		WILC_memcpy(pu8Slot + MSG_QUEUE_SLOT_HDR, pvSendBuffer, u32SendBufferSize);
+		pHandle->u32Count++;
+
+		spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
+		WILC_SemaphoreRelease(&pHandle->hSem, WILC_NULL);
+
+		return WILC_SUCCESS;
+	}
+
+	spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
+
+	/* ring full or message too big, construct a new message */
 	pstrMessage = WILC_NEW(Message, 1);
 	WILC_NULLCHECK(s32RetStatus, pstrMessage);
 	pstrMessage->u32Length = u32SendBufferSize;
@@ -98,23 +162,21 @@ WILC_ErrNo WILC_MsgQueueSend(WILC_MsgQueueHandle* pHandle,
 	pstrMessage->pvBuffer = WILC_MALLOC(u32SendBufferSize);
 	WILC_NULLCHECK(s32RetStatus, pstrMessage->pvBuffer);
 	WILC_memcpy(pstrMessage->pvBuffer, pvSendBuffer, u32SendBufferSize);
-	
 
-	/* add it to the message queue */
-	if(pHandle->pstrMessageList == NULL)
+	/* append it to the overflow list */
+	spin_lock_irqsave(&pHandle->strCriticalSection,flags);
+
+	if(pHandle->pstrMessageTail == NULL)
 	{
-		pHandle->pstrMessageList  = pstrMessage;
+		pHandle->pstrMessageList = pstrMessage;
 	}
 	else
 	{
-		Message * pstrTailMsg = pHandle->pstrMessageList;
-		while(pstrTailMsg->pstrNext != NULL)
-		{
-			pstrTailMsg = pstrTailMsg->pstrNext;
-		}
-		pstrTailMsg->pstrNext = pstrMessage;
-	}	
-	
+		pHandle->pstrMessageTail->pstrNext = pstrMessage;
+	}
+	pHandle->pstrMessageTail = pstrMessage;
+	pHandle->u32Overflows++;
+
 	spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
 
 	WILC_SemaphoreRelease(&pHandle->hSem, WILC_NULL);
@@ -151,7 +213,6 @@ WILC_ErrNo WILC_MsgQueueRecv(WILC_MsgQueueHandle* pHandle,
 
 	Message * pstrMessage;
 	WILC_ErrNo s32RetStatus = WILC_SUCCESS;
-	tstrWILC_SemaphoreAttrs strSemAttrs;
 	unsigned long flags;
 	if( (pHandle == NULL) || (u32RecvBufferSize == 0) 
 		|| (pvRecvBuffer == NULL) || (pu32ReceivedLength == NULL) )
@@ -168,14 +229,24 @@ WILC_ErrNo WILC_MsgQueueRecv(WILC_MsgQueueHandle* pHandle,
 	pHandle->u32ReceiversCount++;
 	spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
 
-	WILC_SemaphoreFillDefault(&strSemAttrs);
 	#ifdef CONFIG_WILC_MSG_QUEUE_TIMEOUT
-	if(pstrAttrs != WILC_NULL)
+	if( (pstrAttrs != WILC_NULL) && (pstrAttrs->u32Timeout != WILC_OS_INFINITY) )
 	{
-		strSemAttrs.u32TimeOut = pstrAttrs->u32Timeout;
+		if(down_timeout(&pHandle->hSem, msecs_to_jiffies(pstrAttrs->u32Timeout)) == 0)
+		{
+			s32RetStatus = WILC_SUCCESS;
+		}
+		else
+		{
+			s32RetStatus = WILC_TIMEOUT;
+		}
 	}
+	else
 	#endif
-	s32RetStatus = WILC_SemaphoreAcquire(&(pHandle->hSem), &strSemAttrs);
+	{
+		s32RetStatus = WILC_SemaphoreAcquire(&(pHandle->hSem), WILC_NULL);
+	}
+
 	if(s32RetStatus == WILC_TIMEOUT)
 	{
 		/* timed out, just exit without consumeing the message */
@@ -194,7 +265,32 @@ WILC_ErrNo WILC_MsgQueueRecv(WILC_MsgQueueHandle* pHandle,
 		}
 
 		spin_lock_irqsave(&pHandle->strCriticalSection,flags);
-		
+
+		/* the ring always holds the oldest messages */
+		if(pHandle->u32Count > 0)
+		{
+			WILC_Uint8* pu8Slot = MSG_QUEUE_SLOT(pHandle, pHandle->u32Head);
+			WILC_Uint32 u32Length = *(WILC_Uint32*)pu8Slot;
+
+			if(u32RecvBufferSize < u32Length)
+			{
+				spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
+				WILC_SemaphoreRelease(&pHandle->hSem, WILC_NULL);
+				WILC_ERRORREPORT(s32RetStatus, WILC_BUFFER_OVERFLOW);
+			}
+
+			pHandle->u32ReceiversCount--;
+			WILC_memcpy(pvRecvBuffer, pu8Slot + MSG_QUEUE_SLOT_HDR, u32Length);
+			*pu32ReceivedLength = u32Length;
+
+			pHandle->u32Head = (pHandle->u32Head + 1) % pHandle->u32Slots;
+			pHandle->u32Count--;
+
+			spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
+
+			return WILC_SUCCESS;
+		}
+
 		pstrMessage = pHandle->pstrMessageList;
 		if(pstrMessage == NULL)
 		{
@@ -215,12 +311,16 @@ WILC_ErrNo WILC_MsgQueueRecv(WILC_MsgQueueHandle* pHandle,
 		*pu32ReceivedLength = pstrMessage->u32Length;
 
 		pHandle->pstrMessageList = pstrMessage->pstrNext;
-		
-		WILC_FREE(pstrMessage->pvBuffer);
-		WILC_FREE(pstrMessage);	
-		
+		if(pHandle->pstrMessageList == NULL)
+		{
+			pHandle->pstrMessageTail = NULL;
+		}
+
 		spin_unlock_irqrestore(&pHandle->strCriticalSection,flags);
 
+		WILC_FREE(pstrMessage->pvBuffer);
+		WILC_FREE(pstrMessage);
+
 	}
 
 	WILC_CATCH(s32RetStatus)
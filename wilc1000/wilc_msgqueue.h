@@ -30,6 +30,11 @@ typedef struct
 	#ifdef CONFIG_WILC_MSG_QUEUE_TIMEOUT
 	WILC_Uint32 u32Timeout;
 	#endif
+
+	/* ring preallocated by WILC_MsgQueueCreate, 0 slots keeps every
+	   message on the heap */
+	WILC_Uint32 u32MaxMsgSize;
+	WILC_Uint32 u32MaxMsgs;
 	
 	/* a dummy member to avoid compiler errors*/
 	WILC_Uint8 dummy;
@@ -53,6 +58,9 @@ static void WILC_MsgQueueFillDefault(tstrWILC_MsgQueueAttrs* pstrAttrs)
 	#ifdef CONFIG_WILC_MSG_QUEUE_TIMEOUT
 	pstrAttrs->u32Timeout = WILC_OS_INFINITY;
 	#endif
+
+	pstrAttrs->u32MaxMsgSize = 0;
+	pstrAttrs->u32MaxMsgs = 0;
 }
 /*!
 *  @brief		Creates a new Message queue
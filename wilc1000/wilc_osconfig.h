@@ -41,7 +41,7 @@
 #define CONFIG_WILC_STRING_UTILS 1
 #define CONFIG_WILC_MSG_QUEUE_FEATURE
 //#define CONFIG_WILC_MSG_QUEUE_IPC_NAME
-//#define CONFIG_WILC_MSG_QUEUE_TIMEOUT
+#define CONFIG_WILC_MSG_QUEUE_TIMEOUT
 //#define CONFIG_WILC_FILE_OPERATIONS_FEATURE
 //#define CONFIG_WILC_FILE_OPERATIONS_STRING_API
 //#define CONFIG_WILC_FILE_OPERATIONS_PATH_API
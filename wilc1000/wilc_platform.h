@@ -134,7 +134,21 @@
 #include <linux/types.h>
 #include <linux/stat.h> 
 #include <linux/time.h> 
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/completion.h>
+#include <linux/wait.h>
 #include <linux/version.h>
+/* the kernel LZ4 decompressor only exists from 3.11 on */
+#if defined(WILC_FW_LZ4) && (LINUX_VERSION_CODE < KERNEL_VERSION(3,11,0))
+#undef WILC_FW_LZ4
+#endif
+#ifdef WILC_FW_LZ4
+#include <linux/lz4.h>
+#endif
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
+#include <linux/crc32.h>
 #include "linux/string.h"
 /******************************************************************
 	OS specific types
@@ -163,7 +177,16 @@ typedef struct __MessageQueue_struct
 	spinlock_t strCriticalSection;
 	WILC_Bool bExiting;
 	WILC_Uint32 u32ReceiversCount;
+	/* fixed size slots: the message length followed by its body */
+	WILC_Uint8* pu8Ring;
+	WILC_Uint32 u32SlotSize;
+	WILC_Uint32 u32Slots;
+	WILC_Uint32 u32Head;		/* oldest message in the ring */
+	WILC_Uint32 u32Count;
+	/* messages that didn't fit the ring, all newer than the ring's */
 	Message * pstrMessageList;
+	Message * pstrMessageTail;
+	WILC_Uint32 u32Overflows;
 } WILC_MsgQueueHandle;
 
 
@@ -298,9 +298,9 @@ void clear_duringIP(void* pUserVoid)
 }
 #endif
 
-int8_t is_network_in_shadow(tstrNetworkInfo* pstrNetworkInfo,void* pUserVoid){
+int32_t is_network_in_shadow(tstrNetworkInfo* pstrNetworkInfo,void* pUserVoid){
  	struct WILC_WFI_priv* priv;
-	int8_t state = -1;
+	int32_t state = -1;
 	int i;
 
  	priv = (struct WILC_WFI_priv*)pUserVoid;
@@ -323,13 +323,16 @@ int8_t is_network_in_shadow(tstrNetworkInfo* pstrNetworkInfo,void* pUserVoid){
 
 void add_network_to_shadow(tstrNetworkInfo* pstrNetworkInfo,void* pUserVoid, void* pJoinParams){
  	struct WILC_WFI_priv* priv;
-	int8_t ap_found = is_network_in_shadow(pstrNetworkInfo,pUserVoid);
+	int32_t ap_found = is_network_in_shadow(pstrNetworkInfo,pUserVoid);
 	uint32_t ap_index = 0;
 	uint8_t rssi_index = 0;
  	priv = (struct WILC_WFI_priv*)pUserVoid;
 
-	if(u32LastScannedNtwrksCountShadow >= MAX_NUM_SCANNED_NETWORKS_SHADOW){
+	/* a network already in the shadow is still updated when it is full */
+	if(ap_found == -1 && u32LastScannedNtwrksCountShadow >= MAX_NUM_SCANNED_NETWORKS_SHADOW){
 		PRINT_D(CFG80211_DBG,"Shadow network reached its maximum limit\n");
+		if(pJoinParams != NULL)
+			host_int_freeJoinParams(pJoinParams);
 		return;
 	}
 	if(ap_found == -1){
@@ -438,7 +441,7 @@ static void CfgScanResult(tenuScanEvent enuScanEvent, tstrNetworkInfo* pstrNetwo
 
 				if(pstrNetworkInfo->bNewNetwork == WILC_TRUE)
 				{
-					if(priv->u32RcvdChCount < MAX_NUM_SCANNED_NETWORKS) //TODO: mostafa: to be replaced by
+					if(priv->u32RcvdChCount < MAX_NUM_FOUND_NETWORKS) //TODO: mostafa: to be replaced by
 																     //               max_scan_ssids
 					{
 						PRINT_D(CFG80211_DBG,"Network %s found\n",pstrNetworkInfo->au8ssid);
@@ -478,6 +481,8 @@ static void CfgScanResult(tenuScanEvent enuScanEvent, tstrNetworkInfo* pstrNetwo
 						else
 						{
 							PRINT_ER("Discovered networks exceeded the max limit\n");
+							if(pJoinParams != NULL)
+								host_int_freeJoinParams(pJoinParams);
 						}
 				}
 				else
@@ -816,6 +821,47 @@ static int WILC_WFI_CfgSetChannel(struct wiphy *wiphy,
 	return s32Error;
 }
 
+/**
+*  @brief 	WILC_WFI_FastReconnectScan
+*  @details 	Answers the first scan after a link loss from the scan results
+*      		cache, provided the lost BSS is still in it and its channel is
+*      		part of the request. The supplicant then reconnects to it without
+*      		waiting for the firmware to scan.
+*  @param[in]
+*  @return 	WILC_TRUE if the scan was answered
+*/
+static WILC_Bool WILC_WFI_FastReconnectScan(struct WILC_WFI_priv* priv, struct cfg80211_scan_request *request)
+{
+	WILC_Uint8 au8bssid[ETH_ALEN];
+	WILC_Uint8 u8channel;
+	WILC_Uint32 i;
+
+	if(host_int_fast_reconnect_scan(priv->hWILCWFIDrv, au8bssid, &u8channel) == WILC_FALSE)
+		return WILC_FALSE;
+
+	for(i = 0; i < request->n_channels; i++)
+	{
+		if(ieee80211_frequency_to_channel(request->channels[i]->center_freq) == u8channel)
+			break;
+	}
+	if(i == request->n_channels)
+		return WILC_FALSE;
+
+	for(i = 0; i < u32LastScannedNtwrksCountShadow; i++)
+	{
+		if(WILC_memcmp(astrLastScannedNtwrksShadow[i].au8bssid, au8bssid, ETH_ALEN) == 0)
+			break;
+	}
+	if(i == u32LastScannedNtwrksCountShadow)
+		return WILC_FALSE;
+
+	PRINT_D(CFG80211_DBG,"Link lost to %s, scan answered from the cache\n", astrLastScannedNtwrksShadow[i].au8ssid);
+	refresh_scan(priv, 1, WILC_FALSE);
+	cfg80211_scan_done(request, WILC_FALSE);
+
+	return WILC_TRUE;
+}
+
 /**
 *  @brief 	WILC_WFI_CfgScan
 *  @details 	Request to do a scan. If returning zero, the scan request is given
@@ -874,6 +920,9 @@ static int WILC_WFI_CfgScan(struct wiphy *wiphy,struct net_device *dev, struct c
 	}
 #endif
 #endif // end of if 0
+	if(WILC_WFI_FastReconnectScan(priv, request) == WILC_TRUE)
+		return s32Error;
+
 	priv->pstrScanReq = request;
 
 	priv->u32RcvdChCount = 0;
@@ -981,11 +1030,13 @@ static int WILC_WFI_CfgConnect(struct wiphy *wiphy, struct net_device *dev,
 	struct WILC_WFI_priv* priv;
 	tstrWILC_WFIDrv * pstrWFIDrv;
 	tstrNetworkInfo* pstrNetworkInfo = NULL;
+	tstrNetworkInfo strLostNetworkInfo;
 
 
 	connecting = 1;
 	priv = wiphy_priv(wiphy);
     pstrWFIDrv = (tstrWILC_WFIDrv *)(priv->hWILCWFIDrv);
+	host_int_conn_trace_start(priv->hWILCWFIDrv);
 
 
 	//host_int_set_wfi_drv_handler((WILC_Uint32)priv->hWILCWFIDrv);
@@ -1062,13 +1113,25 @@ static int WILC_WFI_CfgConnect(struct wiphy *wiphy, struct net_device *dev,
 	}
 	else
 	{
-		s32Error = -ENOENT;
-		if(u32LastScannedNtwrksCountShadow == 0)
-			PRINT_D(CFG80211_DBG,"No Scan results yet\n");
+		/* The BSS whose link was just lost may have expired from the scan
+		   results: reconnect with what was used to join it */
+		WILC_memset(&strLostNetworkInfo, 0, sizeof(tstrNetworkInfo));
+		if(host_int_fast_reconnect_bss(priv->hWILCWFIDrv, sme->ssid, sme->ssid_len, sme->bssid,
+						&strLostNetworkInfo) == WILC_TRUE)
+		{
+			PRINT_D(CFG80211_DBG, "Required bss is the one just lost\n");
+			pstrNetworkInfo = &strLostNetworkInfo;
+		}
 		else
-			PRINT_D(CFG80211_DBG,"Required bss not in scan results: Error(%d)\n",s32Error);
+		{
+			s32Error = -ENOENT;
+			if(u32LastScannedNtwrksCountShadow == 0)
+				PRINT_D(CFG80211_DBG,"No Scan results yet\n");
+			else
+				PRINT_D(CFG80211_DBG,"Required bss not in scan results: Error(%d)\n",s32Error);
 
-		goto done;
+			goto done;
+		}
 	}
 
 	priv->WILC_WFI_wep_default = 0;
@@ -202,6 +202,68 @@ uint32_t drvHandler;
 uint8_t u8IfcType;
 struct net_device* wilc_netdev;
 }tstrInterfaceInfo;
+
+/*
+ * BSSID -> netdev demux table used by the RX path. Direct mapped with
+ * linear probing, rebuilt by linux_wlan_set_bssid(). Size must be a power
+ * of 2 and comfortably larger than the number of virtual interfaces.
+ */
+#define WILC_BSSID_MAP_SIZE		16
+/* Where the BSSID sits in the received frame, depending on the ifc mode */
+#define WILC_RX_STA_BSSID_OFFSET	10
+#define WILC_RX_AP_BSSID_OFFSET		4
+
+typedef struct{
+uint8_t aBSSID[ETH_ALEN];
+uint8_t u8IfcType;
+uint8_t bValid;
+struct net_device* wilc_netdev;
+}tstrBssidMapEntry;
+
+typedef enum{
+	RX_DEMUX_DROP_NO_BINDING = 0,	/* no interface has a BSSID bound */
+	RX_DEMUX_DROP_UNKNOWN_BSSID,	/* BSSID matches none of the bound interfaces */
+	RX_DEMUX_DROP_REASONS
+}tenuRxDemuxDrop;
+
+typedef struct{
+	uint32_t u32Hits;
+	uint32_t u32CacheHits;
+	uint32_t au32Drops[RX_DEMUX_DROP_REASONS];
+}tstrRxDemuxStats;
+
+/*
+ * Bring-up stages timed by mac_open()/wilc1000_wlan_init(). The host
+ * interface stage runs in a work item while the chip is being brought up,
+ * so its span overlaps the bus and firmware stages.
+ */
+typedef enum{
+	BRINGUP_LOCKS = 0,
+	BRINGUP_WLAN_INIT,
+	BRINGUP_THREADS,
+	BRINGUP_IRQ,
+	BRINGUP_FW_GET,
+	BRINGUP_FW_DOWNLOAD,
+	BRINGUP_FW_START,
+	BRINGUP_FW_VERSION,
+	BRINGUP_HOST_INT,
+	BRINGUP_HOST_INT_WAIT,
+	BRINGUP_INIT_CONFIG,
+	BRINGUP_STAGES
+}tenuBringupStage;
+
+typedef struct{
+	ktime_t start;
+	ktime_t end;
+}tstrBringupStage;
+
+typedef struct{
+	int bActive;			/* a bring-up is being timed */
+	ktime_t tStart;
+	ktime_t tReady;
+	tstrBringupStage astrStage[BRINGUP_STAGES];
+}tstrBringupStats;
+
 typedef struct{
 	int mac_status;
 	int wilc1000_initialized;
@@ -214,6 +276,16 @@ typedef struct{
 	int close;
 	uint8_t u8NoIfcs;
 	tstrInterfaceInfo strInterfaceInfo[NUM_CONCURRENT_IFC];
+	spinlock_t bssid_map_lock;
+	uint8_t u8BssidMapEntries;
+	tstrBssidMapEntry strBssidMap[WILC_BSSID_MAP_SIZE];
+	tstrBssidMapEntry* pstrBssidLastHit;
+	tstrRxDemuxStats strRxDemuxStats;
+	tstrBringupStats strBringupStats;
+	/* host interface init, overlapped with chip bring-up by mac_open() */
+	struct work_struct host_int_work;
+	struct net_device* host_int_ndev;
+	int host_int_ret;
 	uint8_t open_ifcs;
 	struct mutex txq_cs;
 
@@ -222,10 +294,13 @@ typedef struct{
 	spinlock_t txq_spinlock;
 	
 	struct mutex rxq_cs;
+	struct mutex cfg_rxq_cs;
+	struct mutex cfg_txn_cs;
 	struct mutex hif_cs;
 
 	//struct mutex txq_event;
 	struct semaphore rxq_event;
+	struct semaphore cfg_rxq_event;
 	struct semaphore cfg_event;
 	struct semaphore sync_event;
 
@@ -246,11 +321,20 @@ typedef struct{
 
 	struct task_struct* rxq_thread;
 	struct task_struct* txq_thread;
+	struct task_struct* cfg_rxq_thread;
 
 	unsigned char eth_src_address[NUM_CONCURRENT_IFC][6];
 	//unsigned char eth_dst_address[6];
 
 	const struct firmware* wilc_firmware; /* Bug 4703 */
+	/* firmware cache, see the fw_cache module parameter */
+	uint32_t fw_image_crc;		/* crc32 of the cached image */
+	uint32_t fw_running_crc;	/* crc32 of the image booted on the chip, 0 if none */
+	int fw_kept_running;		/* last deinit left the firmware running */
+#if defined(WILC_SDIO) && defined(HAS_SUSPEND_RESUME) && defined(WILC_OPTIMIZE_SLEEP_INT)
+	/* reloads the firmware when a resume finds the chip was reset */
+	struct work_struct fw_reload_work;
+#endif
 
 	struct net_device* real_ndev;
 #ifdef WILC_SDIO
@@ -39,6 +39,26 @@ WILC_Uint16 Set_machw_change_vir_if(WILC_Bool bValue);
 #define PRINTARRAY(X,Y)   /*do {int l;for(l=0;l<NQUEUES;l++) {printk("%s[%d]=%d ",X,l,Y[l]);}printk("\n"); }while(0);*/
 #define PRINTVAR(X,Y)   /* do {printk("%s = %d\n",X,Y); }while(0); */
 
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+typedef struct {
+	int chip_awake;			/* host is holding the chip awake */
+	int busy;			/* hysteresis state, hold the chip while set */
+	uint32_t avg_gap;		/* averaged gap between bus accesses, us */
+	uint32_t hold;			/* how long to stay awake after the last access, us */
+	ktime_t last_activity;
+	ktime_t state_since;
+	struct delayed_work sleep_work;
+
+	uint32_t wakes;
+	uint32_t wakes_avoided;
+	uint32_t sleeps;
+	uint64_t awake_time;		/* us */
+	uint64_t asleep_time;		/* us */
+	uint64_t wake_lat_total;	/* us */
+	uint32_t wake_lat_max;		/* us */
+} wilc_sleep_gov_t;
+#endif
+
 
 typedef struct{
 	struct txq_entry_t *txq_head;
@@ -72,12 +92,40 @@ typedef struct {
 		configuration interface functions
 	**/
 	wilc_cfg_func_t cif_func;
-	int cfg_frame_in_use;
-	wilc_cfg_frame_t cfg_frame;
 	uint32_t cfg_frame_offset;
-	int cfg_seq_no;
+	int cfg_seq_no;			/* next sequence number to hand out */
 	void *cfg_wait;
 
+	/**
+		cfg frames in flight, indexed by seq_no % WILC_CFG_SLOTS
+	**/
+	wilc_cfg_slot_t cfg_slot[WILC_CFG_SLOTS];
+	spinlock_t cfg_slot_lock;
+	wait_queue_head_t cfg_slot_free;
+	int cfg_inflight;
+
+	/**
+		config transaction, see wilc_wlan_cfg_txn_start()
+	**/
+	void *cfg_txn_lock;
+	int cfg_txn_type;
+	uint32_t cfg_txn_drv;
+	int cfg_txn_wids;		/* WIDs in the frame being built */
+	int cfg_txn_total;		/* WIDs added by the open transaction */
+	int cfg_txn_frames;		/* frames sent by the open transaction */
+	int cfg_txn_failed;
+	wilc_cfg_slot_t *cfg_txn_slot;	/* frame being built, NULL until the next WID */
+	int cfg_txn_first_seq;
+	uint32_t cfg_frames_sent;
+	uint32_t cfg_wids_sent;
+	uint32_t cfg_txns;
+	uint32_t cfg_frame_splits;	/* frames flushed early because the next WID didn't fit */
+	uint32_t cfg_last_txn_wids;
+	uint32_t cfg_last_txn_frames;
+	uint32_t cfg_inflight_max;
+	uint32_t cfg_async_done;
+	uint32_t cfg_timeouts;
+
 	/**
 		RX buffer
 	**/
@@ -119,11 +167,58 @@ typedef struct {
 	void *rxq_wait;
 	int rxq_exit;
 
+	/**
+		Config/management RX queue, drained by a lower priority worker
+	**/
+	void *cfg_rxq_lock;
+	struct cfg_rxq_entry_t *cfg_rxq_head;
+	struct cfg_rxq_entry_t *cfg_rxq_tail;
+	int cfg_rxq_entries;
+	void *cfg_rxq_wait;
+
+	/**
+		RX bursts read per DATA interrupt
+	**/
+	uint32_t rx_burst_hist[WILC_RX_BURST_BUDGET + 1];
+
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+	wilc_sleep_gov_t sleep_gov;
+#endif
+	uint32_t wake_lat_hist[WILC_WAKE_LAT_HIST_SIZE];
+
+	/**
+		Firmware download
+	**/
+	uint32_t fw_chunk_size;
+	uint32_t fw_download_time;	/* us */
+	uint32_t fw_download_size;
+	uint32_t fw_download_chunk;
+	uint32_t fw_zero_copy_bytes;
+	uint32_t fw_compressed_size;	/* 0 if the image wasn't compressed */
+	int keep_fw;
+
+#ifdef HAS_SUSPEND_RESUME
+	/**
+		State captured before a host sleep, checked again on resume
+	**/
+	struct {
+		uint32_t gp_reg_1;
+		uint32_t glb_reset;
+	} suspend_state;
+	uint32_t warm_resumes;
+	uint32_t cold_resumes;
+	uint32_t resume_lat;		/* resume callback, us */
+	uint32_t resume_rx_lat;		/* resume to first data frame, us */
+	int resume_rx_pending;
+	ktime_t resume_start;
+#endif
 
 } wilc_wlan_dev_t;
 
 static wilc_wlan_dev_t g_wlan;
 
+static void wilc_wlan_cfg_complete(int seq_no, int status);
+static void wilc_wlan_cfg_abort_all(void);
 void chip_allow_sleep(void);
 #ifdef WILC_OPTIMIZE_SLEEP_INT
 void chip_wakeup(void);
@@ -163,24 +258,117 @@ static CHIP_PS_STATE_T genuChipPSstate = CHIP_WAKEDUP;
 /*acquire_bus() and release_bus() are made INLINE functions*/
 /*as a temporary workaround to fix a problem of receiving*/
 /*unknown interrupt from FW*/
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+/********************************************
+
+	Sleep governor
+
+********************************************/
+
+/* Charge the time since the last transition to the current state. Called with the bus held */
+static void wilc_sleep_gov_account(ktime_t now)
+{
+	wilc_sleep_gov_t *gov = &g_wlan.sleep_gov;
+	int64_t delta = ktime_us_delta(now, gov->state_since);
+
+	if (ktime_to_ns(gov->state_since) != 0 && delta > 0) {
+		if (gov->chip_awake)
+			gov->awake_time += delta;
+		else
+			gov->asleep_time += delta;
+	}
+	gov->state_since = now;
+}
+
+/*
+ * Feed one bus access to the governor and work out how long the chip should
+ * be held awake after it. Called with the bus held.
+ */
+static void wilc_sleep_gov_activity(void)
+{
+	wilc_sleep_gov_t *gov = &g_wlan.sleep_gov;
+	ktime_t now = ktime_get();
+	int64_t gap;
+
+	if (ktime_to_ns(gov->last_activity) != 0) {
+		gap = ktime_us_delta(now, gov->last_activity);
+		if (gap > WILC_SLEEP_GOV_MAX_GAP)
+			gap = WILC_SLEEP_GOV_MAX_GAP;
+		gov->avg_gap = (gov->avg_gap * 7 + (uint32_t)gap) / 8;
+	} else {
+		gov->avg_gap = WILC_SLEEP_GOV_MAX_GAP;
+	}
+	gov->last_activity = now;
+
+	if (!gov->busy && gov->avg_gap < WILC_SLEEP_GOV_ENTER_GAP)
+		gov->busy = 1;
+	else if (gov->busy && gov->avg_gap > WILC_SLEEP_GOV_EXIT_GAP)
+		gov->busy = 0;
+
+	if (gov->busy) {
+		gov->hold = gov->avg_gap * 4;
+		if (gov->hold < WILC_SLEEP_GOV_MIN_HOLD)
+			gov->hold = WILC_SLEEP_GOV_MIN_HOLD;
+		else if (gov->hold > WILC_SLEEP_GOV_MAX_HOLD)
+			gov->hold = WILC_SLEEP_GOV_MAX_HOLD;
+	} else {
+		gov->hold = 0;
+	}
+}
+
+/* Lets the chip sleep once it has been idle for the hold period */
+static void wilc_sleep_gov_work(struct work_struct *work)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	wilc_sleep_gov_t *gov = &p->sleep_gov;
+	int64_t idle;
+
+	p->os_func.os_enter_cs(p->hif_lock);
+	if (!p->quit && gov->chip_awake) {
+		idle = ktime_us_delta(ktime_get(), gov->last_activity);
+		if (gov->hold != 0 && idle < gov->hold)
+			schedule_delayed_work(&gov->sleep_work, usecs_to_jiffies(gov->hold - idle) + 1);
+		else
+			chip_allow_sleep();
+	}
+	p->os_func.os_leave_cs(p->hif_lock);
+}
+#endif
+
 INLINE void acquire_bus(BUS_ACQUIRE_T acquire)
 {
 
 	g_wlan.os_func.os_enter_cs(g_wlan.hif_lock);
 	#ifndef WILC_OPTIMIZE_SLEEP_INT
 		if(genuChipPSstate != CHIP_WAKEDUP)
-	#endif
 		{
 			if(acquire == ACQUIRE_AND_WAKEUP)
 				chip_wakeup();
 		}
+	#else
+		if(acquire == ACQUIRE_AND_WAKEUP)
+		{
+			wilc_sleep_gov_activity();
+			/* still held awake from a previous access, no need to wake it */
+			if(g_wlan.sleep_gov.chip_awake)
+				g_wlan.sleep_gov.wakes_avoided++;
+			else
+				chip_wakeup();
+		}
+	#endif
 
 }
 INLINE void release_bus(BUS_RELEASE_T release)
 {
 	#ifdef WILC_OPTIMIZE_SLEEP_INT
 		if(release == RELEASE_ALLOW_SLEEP)
-			chip_allow_sleep();
+		{
+			if(g_wlan.sleep_gov.hold != 0 && !g_wlan.quit)
+				schedule_delayed_work(&g_wlan.sleep_gov.sleep_work,
+						usecs_to_jiffies(g_wlan.sleep_gov.hold) + 1);
+			else
+				chip_allow_sleep();
+		}
 	#endif
 	g_wlan.os_func.os_leave_cs(g_wlan.hif_lock);
 }
@@ -312,11 +500,24 @@ static int wilc_wlan_txq_add_to_head(uint8_t q_num, struct txq_entry_t *tqe)
 		tqe->prev= NULL;
 		p->txq[q_num].txq_head=tqe;
 		p->txq[q_num].txq_tail = tqe;
-	} else {
+	} else if (p->txq[q_num].txq_head->type != WILC_CFG_PKT) {
 		tqe->next = p->txq[q_num].txq_head;
 		tqe->prev= NULL;
 		p->txq[q_num].txq_head->prev=tqe;
 		p->txq[q_num].txq_head = tqe;
+	} else {
+		/* several cfg frames can be in flight: keep them in order ahead of the data */
+		struct txq_entry_t *last = p->txq[q_num].txq_head;
+
+		while (last->next != NULL && last->next->type == WILC_CFG_PKT)
+			last = last->next;
+		tqe->next = last->next;
+		tqe->prev = last;
+		if (last->next != NULL)
+			last->next->prev = tqe;
+		else
+			p->txq[q_num].txq_tail = tqe;
+		last->next = tqe;
 	}
 	p->txq_entries+=1;
 	p->txq[q_num].count++;
@@ -601,7 +802,6 @@ static int wilc_wlan_txq_add_cfg_pkt(uint8_t *buffer, uint32_t buffer_size)
 	PRINT_D(TX_DBG,"Adding config packet ...\n");
 	if (p->quit){
 		PRINT_D(TX_DBG,"Return due to clear function\n");
-		p->os_func.os_signal(p->cfg_wait);
 		return 0;
 		}
 
@@ -857,6 +1057,60 @@ static struct rxq_entry_t *wilc_wlan_rxq_remove(void)
 	return NULL;
 }
 
+/*
+ * Config and management frames are copied out of the RX burst buffer and
+ * handed to the cfg RX worker, so that parsing scan results or passing
+ * frames up to cfg80211 does not hold up data delivery.
+ */
+static int wilc_wlan_cfg_rxq_add(int is_mgmt, uint8_t *buffer, int size)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	struct cfg_rxq_entry_t *cqe;
+
+	if (p->quit)
+		return 0;
+
+	cqe = (struct cfg_rxq_entry_t *)p->os_func.os_malloc(sizeof(struct cfg_rxq_entry_t) + size);
+	if (cqe == NULL) {
+		wilc_debug(N_ERR, "[wilc rxq]: fail alloc cfg rx entry, drop frame (%d)...\n", size);
+		return 0;
+	}
+	cqe->next = NULL;
+	cqe->is_mgmt = is_mgmt;
+	cqe->buffer = (uint8_t *)(cqe + 1);
+	cqe->buffer_size = size;
+	memcpy(cqe->buffer, buffer, size);
+
+	p->os_func.os_enter_cs(p->cfg_rxq_lock);
+	if (p->cfg_rxq_head == NULL)
+		p->cfg_rxq_head = cqe;
+	else
+		p->cfg_rxq_tail->next = cqe;
+	p->cfg_rxq_tail = cqe;
+	p->cfg_rxq_entries += 1;
+	p->os_func.os_leave_cs(p->cfg_rxq_lock);
+
+	p->os_func.os_signal(p->cfg_rxq_wait);
+	return 1;
+}
+
+static struct cfg_rxq_entry_t *wilc_wlan_cfg_rxq_remove(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	struct cfg_rxq_entry_t *cqe;
+
+	p->os_func.os_enter_cs(p->cfg_rxq_lock);
+	cqe = p->cfg_rxq_head;
+	if (cqe != NULL) {
+		p->cfg_rxq_head = cqe->next;
+		if (p->cfg_rxq_head == NULL)
+			p->cfg_rxq_tail = NULL;
+		p->cfg_rxq_entries -= 1;
+	}
+	p->os_func.os_leave_cs(p->cfg_rxq_lock);
+	return cqe;
+}
+
 
 /********************************************
 
@@ -866,12 +1120,47 @@ static struct rxq_entry_t *wilc_wlan_rxq_remove(void)
 
 
 
+/*
+ * One polling step while waiting for the chip to wake: busy-wait in short
+ * steps first, since most wakes finish quickly, then sleep with a doubling
+ * interval capped at WILC_WAKE_SLEEP_MAX.
+ */
+static void chip_wakeup_wait(uint32_t *waited, uint32_t *step)
+{
+	if (*waited < WILC_WAKE_SPIN_TIME) {
+		udelay(WILC_WAKE_SPIN_STEP);
+		*waited += WILC_WAKE_SPIN_STEP;
+	} else {
+		usleep_range(*step, *step + (*step >> 2));
+		*waited += *step;
+		*step <<= 1;
+		if (*step > WILC_WAKE_SLEEP_MAX)
+			*step = WILC_WAKE_SLEEP_MAX;
+	}
+}
+
+static void chip_wakeup_record(uint32_t latency)
+{
+	int i = 0;
+
+	/* bucket i holds latencies below (WILC_WAKE_LAT_HIST_BASE << i) us */
+	while (i < WILC_WAKE_LAT_HIST_SIZE - 1 && latency >= (WILC_WAKE_LAT_HIST_BASE << i))
+		i++;
+	g_wlan.wake_lat_hist[i]++;
+}
+
 #ifdef WILC_OPTIMIZE_SLEEP_INT
 
 void chip_allow_sleep(void)
 {
 	uint32_t reg = 0;
 
+	if (g_wlan.sleep_gov.chip_awake) {
+		wilc_sleep_gov_account(ktime_get());
+		g_wlan.sleep_gov.chip_awake = 0;
+		g_wlan.sleep_gov.sleeps++;
+	}
+
 	/* Clear bit 1 */
 	g_wlan.hif_func.hif_read_reg(WILC_WAKEUP_REG , &reg);
 
@@ -882,8 +1171,10 @@ void chip_allow_sleep(void)
 void chip_wakeup(void)
 {
 	uint32_t reg , clk_status_reg; 
-	uint32_t trials = 0; 
+	uint32_t waited, step;
 	uint32_t val32;
+	ktime_t start = ktime_get();
+	uint32_t latency;
 	
 	g_wlan.hif_func.hif_write_reg(WILC_FROM_INTERFACE_TO_WF_REG , 1);
 	udelay(200);
@@ -896,28 +1187,20 @@ void chip_wakeup(void)
 		// Check the clock status
 		g_wlan.hif_func.hif_read_reg(WILC_CLK_STATUS_REG , &clk_status_reg);
 
-		// in case of clocks off, wait 2ms, and check it again.
-		// if still off, wait for another 2ms, for a total wait of 6ms.
-		// If still off, redo the wake up sequence
-		while( ((clk_status_reg & (WILC_CLK_STATUS_BIT)) == 0) && ((trials%3) != 0))
+		// in case of clocks off, poll with a short spin and then growing sleeps,
+		// for a total wait of 6ms. If still off, redo the wake up sequence
+		waited = 0;
+		step = WILC_WAKE_SLEEP_MIN;
+		while( ((clk_status_reg & (WILC_CLK_STATUS_BIT)) == 0) && (waited < WILC_WAKE_ATTEMPT_MAX))
 		{
-			/* Wait for the chip to stabilize*/
-			WILC_Sleep(2);
-
-			// Make sure chip is awake. This is an extra step that can be removed
-			// later to avoid the bus access overhead
+			chip_wakeup_wait(&waited, &step);
 			g_wlan.hif_func.hif_read_reg(WILC_CLK_STATUS_REG , &clk_status_reg);
-			if((clk_status_reg & (WILC_CLK_STATUS_BIT)) == 0)
-			{
-				wilc_debug(N_ERR, "clocks still OFF. Wake up failed\n");
-			}
-			
-			trials++;
 		}
 		
 		// in case of failure, Reset the wakeup bit to introduce a new edge on the next loop
 		if((clk_status_reg & (WILC_CLK_STATUS_BIT)) == 0)
 		{
+			wilc_debug(N_ERR, "clocks still OFF. Wake up failed\n");
 			// Reset bit 0
 			g_wlan.hif_func.hif_write_reg(WILC_WAKEUP_REG , reg & (~ (WILC_WAKEUP_BIT)));
 		}
@@ -938,11 +1221,21 @@ void chip_wakeup(void)
 		}
 	}
 	genuChipPSstate = CHIP_WAKEDUP;
+
+	wilc_sleep_gov_account(start);
+	latency = (uint32_t)ktime_us_delta(ktime_get(), start);
+	chip_wakeup_record(latency);
+	g_wlan.sleep_gov.chip_awake = 1;
+	g_wlan.sleep_gov.wakes++;
+	g_wlan.sleep_gov.wake_lat_total += latency;
+	if (latency > g_wlan.sleep_gov.wake_lat_max)
+		g_wlan.sleep_gov.wake_lat_max = latency;
 }
 #else
 INLINE void chip_wakeup(void)
 {
-	uint32_t reg, trials=0;
+	uint32_t reg, waited, step, chipid;
+	ktime_t start = ktime_get();
 	do
 	{
 		if ((g_wlan.io_func.io_type & 0x1) == HIF_SPI)
@@ -966,22 +1259,22 @@ INLINE void chip_wakeup(void)
 			 g_wlan.hif_func.hif_write_reg(0xf0, reg  & ~(1 << 0));
 		}
 
+		/* Wait for the chip to stabilize, a readable chip id means it is awake */
+		waited = 0;
+		step = WILC_WAKE_SLEEP_MIN;
 		do
 		{
-			/* Wait for the chip to stabilize*/
-//			WILC_Sleep(2);
-			mdelay(3);
-
-			// Make sure chip is awake. This is an extra step that can be removed
-			// later to avoid the bus access overhead
-			if((wilc_get_chipid(WILC_TRUE) == 0))
-			{
-				wilc_debug(N_ERR, "Couldn't read chip id. Wake up failed\n");
-			}
-		}while((wilc_get_chipid(WILC_TRUE) == 0) && ((++trials %3) == 0));
+			chip_wakeup_wait(&waited, &step);
+			chipid = wilc_get_chipid(WILC_TRUE);
+		}while((chipid == 0) && (waited < WILC_WAKE_ATTEMPT_MAX));
 
-	}while(wilc_get_chipid(WILC_TRUE) == 0);
+		if(chipid == 0)
+		{
+			wilc_debug(N_ERR, "Couldn't read chip id. Wake up failed\n");
+		}
+	}while(chipid == 0);
 
+	chip_wakeup_record((uint32_t)ktime_us_delta(ktime_get(), start));
 	genuChipPSstate = CHIP_WAKEDUP;
 }
 #endif
@@ -1017,10 +1310,76 @@ void host_wakeup_notify(void)
 void host_sleep_notify(void)
 {
 	acquire_bus(ACQUIRE_ONLY);
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+	/* do not leave the chip held awake by the governor while the host sleeps */
+	if (g_wlan.sleep_gov.chip_awake)
+		chip_allow_sleep();
+#endif
 	g_wlan.hif_func.hif_write_reg(0x10ac, 1);
 	release_bus(RELEASE_ONLY);
 }
 
+#ifdef HAS_SUSPEND_RESUME
+/*
+ * Record what the chip looks like before the host goes to sleep
+ * with the chip still powered. wilc_wlan_resume_state_retained() compares
+ * against it to decide whether the chip kept its firmware running.
+ */
+void wilc_wlan_suspend_snapshot(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	/* the registers read back as garbage while the chip sleeps */
+	acquire_bus(ACQUIRE_AND_WAKEUP);
+	p->hif_func.hif_read_reg(WILC_GP_REG_1, &p->suspend_state.gp_reg_1);
+	p->hif_func.hif_read_reg(WILC_GLB_RESET_0, &p->suspend_state.glb_reset);
+	release_bus(RELEASE_ONLY);
+
+	PRINT_D(GENERIC_DBG, "Suspend snapshot: gp_reg_1 %x, glb_reset %x\n",
+		p->suspend_state.gp_reg_1, p->suspend_state.glb_reset);
+}
+
+/*
+ * The host config register written by wilc_wlan_start() resets to 0 on a
+ * power loss, and bit 10 of the global reset register keeps the CPU running.
+ * If both survived, the firmware and its association are still there.
+ */
+int wilc_wlan_resume_state_retained(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t gp_reg_1 = 0, glb_reset = 0;
+
+	acquire_bus(ACQUIRE_AND_WAKEUP);
+	p->hif_func.hif_read_reg(WILC_GP_REG_1, &gp_reg_1);
+	p->hif_func.hif_read_reg(WILC_GLB_RESET_0, &glb_reset);
+	release_bus(RELEASE_ONLY);
+
+	PRINT_D(GENERIC_DBG, "Resume check: gp_reg_1 %x, glb_reset %x, txq %d, rxq %d\n",
+		gp_reg_1, glb_reset, p->txq_entries, p->rxq_entries);
+
+	return (gp_reg_1 == p->suspend_state.gp_reg_1) &&
+		(p->suspend_state.glb_reset & (1ul << 10)) &&
+		(glb_reset & (1ul << 10));
+}
+
+void wilc_wlan_resume_done(ktime_t start, int warm)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	if (warm)
+		p->warm_resumes++;
+	else
+		p->cold_resumes++;
+	p->resume_start = start;
+	p->resume_lat = (uint32_t)ktime_us_delta(ktime_get(), start);
+	p->resume_rx_pending = 1;
+
+	/* flush whatever was queued for TX while the host was asleep */
+	if (warm && p->txq_entries)
+		p->os_func.os_signal(p->txq_wait);
+}
+#endif
+
 /********************************************
 
 	Tx, Rx queue handle functions
@@ -1513,12 +1872,62 @@ _end_:
 	return ret;
 }
 
+static void wilc_wlan_handle_cfg_pkt(uint8_t *buffer, int size)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	wilc_cfg_rsp_t rsp;
+
+	rsp.type = 0;
+	p->cif_func.rx_indicate(buffer, size, &rsp);
+	if (rsp.type == WILC_CFG_RSP) {
+		/**
+			wake up the waiting task...
+		**/
+		PRINT_D(RX_DBG,"rsp.seq_no = %d\n",rsp.seq_no);
+		wilc_wlan_cfg_complete(rsp.seq_no, 0);
+	} else if (rsp.type == WILC_CFG_RSP_STATUS) {
+		/**
+			Call back to indicate status...
+		**/
+		if (p->indicate_func.mac_indicate) {
+			p->indicate_func.mac_indicate(WILC_MAC_INDICATE_STATUS);
+		}
+
+	} else if (rsp.type == WILC_CFG_RSP_SCAN) {
+		if (p->indicate_func.mac_indicate)
+			p->indicate_func.mac_indicate(WILC_MAC_INDICATE_SCAN);
+	}
+}
+
+static void wilc_wlan_handle_cfg_rxq(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	struct cfg_rxq_entry_t *cqe;
+
+	while (!p->quit) {
+		cqe = wilc_wlan_cfg_rxq_remove();
+		if (cqe == NULL)
+			break;
+
+		if (cqe->is_mgmt) {
+#ifdef USE_WIRELESS
+			WILC_WFI_mgmt_rx(cqe->buffer, cqe->buffer_size);
+#endif
+		} else {
+			wilc_wlan_handle_cfg_pkt(cqe->buffer, cqe->buffer_size);
+		}
+		p->os_func.os_free((void *)cqe);
+	}
+}
+
 static void wilc_wlan_handle_rxq(void)
 {
 	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
 	int offset = 0, size, has_packet = 0;
 	uint8_t *buffer;
 	struct rxq_entry_t *rqe;
+	wilc_rx_pkt_t batch[WILC_RX_BATCH_MAX];
+	uint32_t batch_cnt = 0;
 
 	p->rxq_exit = 0;
 
@@ -1528,7 +1937,7 @@ static void wilc_wlan_handle_rxq(void)
 	do {
 		if (p->quit){
 			PRINT_D(RX_DBG,"exit 1st do-while due to Clean_UP function \n");
-			p->os_func.os_signal(p->cfg_wait);
+			wilc_wlan_cfg_abort_all();
 			break;
 		}
 		rqe = wilc_wlan_rxq_remove();
@@ -1578,10 +1987,7 @@ static void wilc_wlan_handle_rxq(void)
 					//reset mgmt indicator bit, to use pkt_offeset in furthur calculations
 					pkt_offset &= ~(IS_MANAGMEMENT | IS_MANAGMEMENT_CALLBACK | IS_MGMT_STATUS_SUCCES);
 
-#ifdef USE_WIRELESS
-					WILC_WFI_mgmt_rx(&buffer[offset+HOST_HDR_OFFSET],pkt_len);
-
-#endif
+					wilc_wlan_cfg_rxq_add(1, &buffer[offset+HOST_HDR_OFFSET], pkt_len);
 
 				}
 
@@ -1593,39 +1999,36 @@ static void wilc_wlan_handle_rxq(void)
 
 			if (!is_cfg_packet) {
 
-				if (p->net_func.rx_indicate) {
+#ifdef HAS_SUSPEND_RESUME
+				if (p->resume_rx_pending) {
+					p->resume_rx_lat = (uint32_t)ktime_us_delta(ktime_get(), p->resume_start);
+					p->resume_rx_pending = 0;
+				}
+#endif
+				if (p->net_func.rx_indicate_batch) {
+					batch[batch_cnt].buff = &buffer[offset];
+					batch[batch_cnt].size = pkt_len;
+					batch[batch_cnt].pkt_offset = pkt_offset;
+					if (++batch_cnt == WILC_RX_BATCH_MAX) {
+						p->net_func.rx_indicate_batch(batch, batch_cnt);
+						batch_cnt = 0;
+					}
+					has_packet = 1;
+				} else if (p->net_func.rx_indicate) {
 					if (pkt_len > 0) {
 						p->net_func.rx_indicate(&buffer[offset], pkt_len,pkt_offset);
 						has_packet = 1;
 					}
 				}
 			} else {
-				wilc_cfg_rsp_t rsp;
-
-
-
-				p->cif_func.rx_indicate(&buffer[pkt_offset+offset], pkt_len, &rsp);
-				if (rsp.type == WILC_CFG_RSP) {
-					/**
-						wake up the waiting task...
-					**/
-				PRINT_D(RX_DBG,"p->cfg_seq_no = %d - rsp.seq_no = %d\n",p->cfg_seq_no,rsp.seq_no);
-					if (p->cfg_seq_no == rsp.seq_no) {
-						p->os_func.os_signal(p->cfg_wait);
-					}
-					//p->os_func.os_signal(p->cfg_wait);
-				} else if (rsp.type == WILC_CFG_RSP_STATUS) {
-					/**
-						Call back to indicate status...
-					**/
-					if (p->indicate_func.mac_indicate) {
-						p->indicate_func.mac_indicate(WILC_MAC_INDICATE_STATUS);
-					}
-
-				} else if (rsp.type == WILC_CFG_RSP_SCAN) {
-					if (p->indicate_func.mac_indicate)
-						p->indicate_func.mac_indicate(WILC_MAC_INDICATE_SCAN);
-				}
+				/**
+					Config responses complete a waiting wilc_wlan_cfg_set/get,
+					handle them right here. Everything else can wait.
+				**/
+				if (buffer[pkt_offset+offset] == 'R')
+					wilc_wlan_handle_cfg_pkt(&buffer[pkt_offset+offset], pkt_len);
+				else
+					wilc_wlan_cfg_rxq_add(0, &buffer[pkt_offset+offset], pkt_len);
 			}
 		}
 			offset += tp_len;
@@ -1633,6 +2036,11 @@ static void wilc_wlan_handle_rxq(void)
 				break;
 		} while (1);
 
+		/* batch entries point into buffer, hand them up before it is freed */
+		if (batch_cnt > 0) {
+			p->net_func.rx_indicate_batch(batch, batch_cnt);
+			batch_cnt = 0;
+		}
 
 #ifndef MEMORY_STATIC
 		if (buffer != NULL)
@@ -1684,18 +2092,88 @@ static void wilc_sleeptimer_isr_ext(uint32_t int_stats1)
 #endif
 }
 
-static void wilc_wlan_handle_isr_ext(uint32_t int_status)
+static int wilc_wlan_rx_burst(uint32_t size)
 {
 	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
 #ifdef MEMORY_STATIC
 	uint32_t offset = p->rx_buffer_offset;
 #endif
 	uint8_t *buffer = NULL;
-	uint32_t size;
-	uint32_t retries=0;
 	int ret = 0;
 	struct rxq_entry_t *rqe;
 
+#ifdef MEMORY_STATIC
+	if (p->rx_buffer_size - offset < size)
+		offset = 0;
+
+	if(p->rx_buffer)
+		buffer = &p->rx_buffer[offset];
+	else
+	{
+		wilc_debug(N_ERR, "[wilc isr]: fail Rx Buffer is NULL...drop the packets (%d)\n", size);
+		goto _end_;
+	}
+
+#else
+	buffer = p->os_func.os_malloc(size);
+	if (buffer == NULL) {
+		wilc_debug(N_ERR, "[wilc isr]: fail alloc host memory...drop the packets (%d)\n", size);
+		WILC_Sleep(100);
+		goto _end_;
+	}
+#endif
+
+	/**
+		clear the chip's interrupt	 after getting size some register getting corrupted after clear the interrupt
+	**/
+	p->hif_func.hif_clear_int_ext(DATA_INT_CLR|ENABLE_RX_VMM);
+
+
+	/**
+	start transfer
+	**/
+	ret = p->hif_func.hif_block_rx_ext(0, buffer, size);
+
+	if (!ret) {
+		wilc_debug(N_ERR, "[wilc isr]: fail block rx...\n");
+		goto _end_;
+	}
+_end_:
+
+
+	if (ret) {
+#ifdef MEMORY_STATIC
+		offset += size;
+		p->rx_buffer_offset = offset;
+#endif
+		/**
+			add to rx queue
+		**/
+		rqe = (struct rxq_entry_t *)p->os_func.os_malloc(sizeof(struct rxq_entry_t));
+		if (rqe != NULL) {
+			rqe->buffer = buffer;
+			rqe->buffer_size = size;
+			PRINT_D(RX_DBG,"rxq entery Size= %d - Address = %p\n",rqe->buffer_size,rqe->buffer);
+			wilc_wlan_rxq_add(rqe);
+			p->os_func.os_signal(p->rxq_wait);
+		}
+	} else {
+#ifndef MEMORY_STATIC
+		if (buffer != NULL)
+			p->os_func.os_free(buffer);
+#endif
+	}
+
+	return ret;
+}
+
+static void wilc_wlan_handle_isr_ext(uint32_t int_status)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t size;
+	uint32_t retries=0;
+	uint32_t bursts = 0;
+
 
 	/**
 		Get the rx size
@@ -1715,80 +2193,42 @@ static void wilc_wlan_handle_isr_ext(uint32_t int_status)
 
 	}
 
-	if (size > 0) {
-#ifdef MEMORY_STATIC
-		if (p->rx_buffer_size - offset < size)
-			offset = 0;
-
-		if(p->rx_buffer)
-			buffer = &p->rx_buffer[offset];
-		else
-		{
-			wilc_debug(N_ERR, "[wilc isr]: fail Rx Buffer is NULL...drop the packets (%d)\n", size);
-			goto _end_;
-		}
-
-#else
-		buffer = p->os_func.os_malloc(size);
-		if (buffer == NULL) {
-			wilc_debug(N_ERR, "[wilc isr]: fail alloc host memory...drop the packets (%d)\n", size);
-			WILC_Sleep(100);
-			goto _end_;
-		}
-#endif
+	/**
+		Drain everything the chip has buffered while we own the bus,
+		instead of taking another interrupt round trip per burst.
+	**/
+	while (size > 0) {
+		bursts++;
+		if (!wilc_wlan_rx_burst(size))
+			break;
+		if (bursts >= WILC_RX_BURST_BUDGET || p->quit)
+			break;
 
+		p->hif_func.hif_read_size(&size);
+		size = ((size & 0x7fff) << 2);
+#ifdef MEMORY_STATIC
 		/**
-			clear the chip's interrupt	 after getting size some register getting corrupted after clear the interrupt
+			rx_buffer wraps to the start when it runs out of room, which
+			would overwrite bursts still waiting in the rxq. Leave this one
+			to the next interrupt, the chip keeps it buffered meanwhile.
 		**/
-		p->hif_func.hif_clear_int_ext(DATA_INT_CLR|ENABLE_RX_VMM);
-
+		if (size > 0 && p->rx_buffer_size - p->rx_buffer_offset < size)
+			break;
+#endif
+	}
+	p->rx_burst_hist[bursts]++;
 
-		/**
-		start transfer
-		**/
-		ret = p->hif_func.hif_block_rx_ext(0, buffer, size);
+#ifdef TCP_ENHANCEMENTS
+	wilc_wlan_handle_rxq();
+#endif
+}
 
- 		if (!ret) {
-			wilc_debug(N_ERR, "[wilc isr]: fail block rx...\n");
-			goto _end_;
-		}
-_end_:
+void wilc_handle_isr(void)
+{
+	uint32_t int_status;
 
-
-		if (ret) {
-#ifdef MEMORY_STATIC
-			offset += size;
-			p->rx_buffer_offset = offset;
-#endif
-			/**
-				add to rx queue
-			**/
-			rqe = (struct rxq_entry_t *)p->os_func.os_malloc(sizeof(struct rxq_entry_t));
-			if (rqe != NULL) {
-				rqe->buffer = buffer;
-				rqe->buffer_size = size;
-				PRINT_D(RX_DBG,"rxq entery Size= %d - Address = %p\n",rqe->buffer_size,rqe->buffer);
-				wilc_wlan_rxq_add(rqe);
-				p->os_func.os_signal(p->rxq_wait);
-			}
-		} else {
-#ifndef MEMORY_STATIC
-			if (buffer != NULL)
-				p->os_func.os_free(buffer);
-#endif
-		}
-	}
-#ifdef TCP_ENHANCEMENTS
-	wilc_wlan_handle_rxq();
-#endif
-}
-
-void wilc_handle_isr(void)
-{
-	uint32_t int_status;
-
-	acquire_bus(ACQUIRE_AND_WAKEUP);
-	g_wlan.hif_func.hif_read_int(&int_status);
+	acquire_bus(ACQUIRE_AND_WAKEUP);
+	g_wlan.hif_func.hif_read_int(&int_status);
 
 	if(int_status & PLL_INT_EXT){
 		wilc_pllupdate_isr_ext(int_status);
@@ -1821,25 +2261,208 @@ void wilc_handle_isr(void)
 	Firmware download
 
 ********************************************/
+/*
+ * The image can be sent to the bus as is when it sits in the kernel linear
+ * map (kmalloc'd, not vmalloc'd like most request_firmware() images).
+ */
+static int wilc_wlan_fw_dma_able(const uint8_t *buffer, uint32_t buffer_size)
+{
+	return virt_addr_valid(buffer) && virt_addr_valid(buffer + buffer_size - 1);
+}
+
+#ifdef WILC_FW_LZ4
+static int wilc_wlan_fw_inflate(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,11,0)
+	return LZ4_decompress_safe((const char *)src, (char *)dst, src_size, dst_size);
+#else
+	size_t len = dst_size;
+
+	if (lz4_decompress_unknownoutputsize(src, src_size, dst, &len))
+		return -1;
+	return len;
+#endif
+}
+
+/*
+ * Download a compressed image (see WILC_FW_LZ4_MAGIC) one block at a time.
+ * Each block is inflated into the bounce buffer and its section data is
+ * sent from there, so the uncompressed image never exists in full. A
+ * section header, or the odd bytes of a section that keep chip addresses
+ * word aligned, can straddle two blocks: they are carried over in front
+ * of the next block.
+ */
+static int wilc_wlan_firmware_download_lz4(const uint8_t *buffer, uint32_t buffer_size)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t offset = 4, raw_size = 0;
+	uint32_t addr = 0, size = 0;
+	uint32_t csize, rsize, len, pos, carry = 0, n;
+	uint8_t *dma_buffer, *out, *data, *tx_buffer;
+	int ret = 1;
+
+#if (defined WILC_PREALLOC_AT_BOOT)
+	PRINT_ER("Compressed firmware needs a %d byte buffer, not supported with WILC_PREALLOC_AT_BOOT\n",
+		 WILC_FW_LZ4_BLOCK_MAX);
+	return -5;
+#endif
+	/* slack at the end: the bus rounds transfers up to a word */
+	dma_buffer = (uint8_t *)p->os_func.os_malloc(WILC_FW_LZ4_CARRY + WILC_FW_LZ4_BLOCK_MAX + 4);
+	if (dma_buffer == NULL) {
+		PRINT_ER("Can't allocate buffer for firmware download IO error\n ");
+		return -5;
+	}
+	out = dma_buffer + WILC_FW_LZ4_CARRY;
+
+	PRINT_D(INIT_DBG,"Downloading compressed firmware size = %d ...\n",buffer_size);
+	while (offset < buffer_size) {
+		if (buffer_size - offset < 8)
+			goto _bad_image_;
+		memcpy(&csize, &buffer[offset], 4);
+		memcpy(&rsize, &buffer[offset+4], 4);
+#ifdef BIG_ENDIAN
+		csize = BYTE_SWAP(csize);
+		rsize = BYTE_SWAP(rsize);
+#endif
+		offset += 8;
+		if (csize > buffer_size - offset || rsize > WILC_FW_LZ4_BLOCK_MAX)
+			goto _bad_image_;
+		if ((rsize & 0x3) && offset + csize < buffer_size)
+			goto _bad_image_;
+
+		if (wilc_wlan_fw_inflate(&buffer[offset], csize, out, rsize) != (int)rsize)
+			goto _bad_image_;
+		offset += csize;
+		raw_size += rsize;
+
+		data = out - carry;
+		len = carry + rsize;
+		pos = 0;
+
+		acquire_bus(ACQUIRE_ONLY);
+		while (pos < len) {
+			if (size == 0) {
+				if (len - pos < 8)
+					break;
+				memcpy(&addr, &data[pos], 4);
+				memcpy(&size, &data[pos+4], 4);
+#ifdef BIG_ENDIAN
+				addr = BYTE_SWAP(addr);
+				size = BYTE_SWAP(size);
+#endif
+				pos += 8;
+				continue;
+			}
+			n = len - pos;
+			if (n >= size)
+				n = size;
+			else
+				n &= ~0x3;	/* the rest of the section comes with the next block */
+			if (n == 0)
+				break;
+
+			tx_buffer = &data[pos];
+			if ((unsigned long)tx_buffer & 0x3) {
+				/* only consumed bytes get overwritten */
+				memmove(dma_buffer, tx_buffer, n);
+				tx_buffer = dma_buffer;
+			}
+			ret = p->hif_func.hif_block_tx(addr, tx_buffer, n);
+			if (!ret)
+				break;
+
+			addr += n;
+			size -= n;
+			pos += n;
+		}
+		release_bus(RELEASE_ONLY);
+
+		if (!ret) {
+			PRINT_ER("Can't download firmware IO error\n ");
+			ret = -5;
+			goto _fail_;
+		}
+
+		carry = len - pos;
+		if (carry > WILC_FW_LZ4_CARRY)
+			goto _bad_image_;
+		memmove(out - carry, &data[pos], carry);
+	}
+
+	if (carry || size)
+		goto _bad_image_;
+
+	p->fw_download_size = raw_size;
+	p->fw_compressed_size = buffer_size;
+	p->fw_download_chunk = WILC_FW_LZ4_BLOCK_MAX;
+	ret = 0;
+	goto _fail_;
+
+_bad_image_:
+	PRINT_ER("Corrupted compressed firmware image at offset %d\n", offset);
+	ret = -5;
+_fail_:
+	p->os_func.os_free(dma_buffer);
+	return ret;
+}
+#endif
+
 static int wilc_wlan_firmware_download(const uint8_t *buffer, uint32_t buffer_size)
 {
 	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
 	uint32_t offset;
 	uint32_t addr, size, size2, blksz;
-	uint8_t *dma_buffer;
+	uint8_t *dma_buffer, *tx_buffer;
 	int ret = 0;
+	int zero_copy;
+	ktime_t start = ktime_get();
+
+	p->fw_zero_copy_bytes = 0;
+	p->fw_compressed_size = 0;
+
+	if (buffer_size >= 4) {
+		uint32_t magic;
 
-	blksz = (1ul << 12); /* Bug 4703: 4KB Good enough size for most platforms = PAGE_SIZE. */
-	/* Allocate a DMA coherent  buffer. */
+		memcpy(&magic, buffer, 4);
+#ifdef BIG_ENDIAN
+		magic = BYTE_SWAP(magic);
+#endif
+		if (magic == WILC_FW_LZ4_MAGIC) {
+#ifndef WILC_FW_LZ4
+			PRINT_ER("Compressed firmware is not supported by this build\n");
+			return -1;
+#endif
+			ret = wilc_wlan_firmware_download_lz4(buffer, buffer_size);
+			if (ret == 0) {
+				p->fw_download_time = (uint32_t)ktime_us_delta(ktime_get(), start);
+				PRINT_INFO(INIT_DBG,"Firmware downloaded: %d bytes from %d compressed in %u us\n",
+					   p->fw_download_size,buffer_size,p->fw_download_time);
+			}
+			return ret;
+		}
+	}
 
 #if (defined WILC_PREALLOC_AT_BOOT)
+	blksz = WILC_FW_CHUNK_MIN; /* size of the buffer reserved at boot */
 {
 	extern void * get_fw_buffer(void);
 	dma_buffer = (uint8_t *)get_fw_buffer();
 	PRINT_D(TX_DBG, "fw_buffer = 0x%x\n", dma_buffer);
 }
 #else
+	blksz = p->fw_chunk_size;
+	if (blksz < WILC_FW_CHUNK_MIN)
+		blksz = WILC_FW_CHUNK_MIN;
+	else if (blksz > WILC_FW_CHUNK_MAX)
+		blksz = WILC_FW_CHUNK_MAX;
+	blksz &= ~(WILC_FW_CHUNK_MIN - 1);
+
+	/* Allocate a DMA coherent  buffer. Fall back to the old 4KB if a big one is not available */
 	dma_buffer = (uint8_t *)g_wlan.os_func.os_malloc(blksz);
+	if (dma_buffer == NULL && blksz > WILC_FW_CHUNK_MIN) {
+		blksz = WILC_FW_CHUNK_MIN;
+		dma_buffer = (uint8_t *)g_wlan.os_func.os_malloc(blksz);
+	}
 #endif
 	if (dma_buffer == NULL) {
 		/*EIO	5*/
@@ -1848,7 +2471,10 @@ static int wilc_wlan_firmware_download(const uint8_t *buffer, uint32_t buffer_si
 		goto _fail_1;
 	}
 
-	PRINT_D(INIT_DBG,"Downloading firmware size = %d ...\n",buffer_size);
+	zero_copy = wilc_wlan_fw_dma_able(buffer, buffer_size);
+
+	PRINT_D(INIT_DBG,"Downloading firmware size = %d, chunk = %d%s ...\n",buffer_size,blksz,
+		zero_copy ? ", zero copy" : "");
 	/**
 		load the firmware
 	**/
@@ -1868,9 +2494,19 @@ static int wilc_wlan_firmware_download(const uint8_t *buffer, uint32_t buffer_si
 			} else {
 				size2 = blksz;
 			}
-			/* Copy firmware into a DMA coherent buffer */
-			memcpy(dma_buffer, &buffer[offset], size2);
-			ret = p->hif_func.hif_block_tx(addr, dma_buffer, size2);
+			/*
+			 * The bus rounds transfers up to a word, so only send straight
+			 * from the image when that can't read past the chunk.
+			 */
+			if (zero_copy && !(((unsigned long)&buffer[offset] | size2) & 0x3)) {
+				tx_buffer = (uint8_t *)&buffer[offset];
+				p->fw_zero_copy_bytes += size2;
+			} else {
+				/* Copy firmware into a DMA coherent buffer */
+				memcpy(dma_buffer, &buffer[offset], size2);
+				tx_buffer = dma_buffer;
+			}
+			ret = p->hif_func.hif_block_tx(addr, tx_buffer, size2);
 			if (!ret) break;
 
 			addr += size2;
@@ -1888,6 +2524,11 @@ static int wilc_wlan_firmware_download(const uint8_t *buffer, uint32_t buffer_si
 		PRINT_D(INIT_DBG,"Offset = %d\n",offset);
 	} while (offset < buffer_size);
 
+	p->fw_download_time = (uint32_t)ktime_us_delta(ktime_get(), start);
+	p->fw_download_size = buffer_size;
+	p->fw_download_chunk = blksz;
+	PRINT_INFO(INIT_DBG,"Firmware downloaded: %d bytes in %u us\n",buffer_size,p->fw_download_time);
+
 _fail_:
 
 #if (defined WILC_PREALLOC_AT_BOOT)
@@ -1901,53 +2542,271 @@ _fail_1:
 	return (ret < 0)? ret:0;
 }
 
+#if defined(WILC_DEBUGFS)
 /********************************************
 
-	Common
+	Firmware download check
 
 ********************************************/
-static int wilc_wlan_start(void)
+/*
+ * Both download paths are run against a hif_block_tx stub that checksums
+ * what would be written to the chip, and the results are compared. Other
+ * users of the bus keep the real function while the check runs.
+ */
+#ifdef WILC_FW_LZ4
+static struct {
+	struct task_struct *task;
+	int (*block_tx)(uint32_t, uint8_t *, uint32_t);
+	uint32_t crc;
+	uint32_t next_addr;
+	uint32_t bytes;
+} fw_check;
+static DEFINE_MUTEX(fw_check_lock);
+
+static int wilc_wlan_fw_check_block_tx(uint32_t addr, uint8_t *data, uint32_t size)
 {
-	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
-	uint32_t reg = 0;
-	int ret;
-	uint32_t chipid;
+	uint32_t le;
 
-	/**
-		Set the host interface
-	**/
-#ifdef OLD_FPGA_BITFILE
-	acquire_bus(ACQUIRE_ONLY);
-	ret = p->hif_func.hif_read_reg(WILC_VMM_CORE_CTL, &reg);
-	if (!ret) {
-		wilc_debug(N_ERR, "[wilc start]: fail read reg vmm_core_ctl...\n");
-		release_bus(RELEASE_ALLOW_SLEEP);
- 		return ret;
+	if (current != fw_check.task)
+		return fw_check.block_tx(addr, data, size);
+
+	/* the address only counts where it jumps, so how a section is cut into transfers doesn't matter */
+	if (fw_check.bytes == 0 || addr != fw_check.next_addr) {
+		le = cpu_to_le32(addr);
+		fw_check.crc = crc32_le(fw_check.crc, (uint8_t *)&le, 4);
 	}
-	reg |= (p->io_func.io_type<<2);
-	ret = p->hif_func.hif_write_reg(WILC_VMM_CORE_CTL, reg);
-	if (!ret) {
-		wilc_debug(N_ERR, "[wilc start]: fail write reg vmm_core_ctl...\n");
-		release_bus(RELEASE_ONLY);
- 		return ret;
+	fw_check.crc = crc32_le(fw_check.crc, data, size);
+	fw_check.next_addr = addr + size;
+	fw_check.bytes += size;
+	return 1;
+}
+
+static int wilc_wlan_fw_check_run(const uint8_t *image, uint32_t image_size)
+{
+	fw_check.crc = ~0;
+	fw_check.next_addr = 0;
+	fw_check.bytes = 0;
+	return wilc_wlan_firmware_download(image, image_size);
+}
+
+static void wilc_wlan_fw_check_put32(uint8_t *dst, uint32_t val)
+{
+#ifdef BIG_ENDIAN
+	val = BYTE_SWAP(val);
+#endif
+	memcpy(dst, &val, 4);
+}
+
+/*
+ * Compressed form of a raw image, cut every blksz bytes. The blocks are
+ * stored as LZ4 literal runs: nothing is compressed, but the blocks end
+ * wherever blksz puts them, in the middle of section headers and data.
+ */
+static uint8_t *wilc_wlan_fw_check_pack(const uint8_t *raw, uint32_t raw_size, uint32_t blksz, uint32_t *packed_size)
+{
+	uint32_t nblocks = DIV_ROUND_UP(raw_size, blksz);
+	uint32_t off, pos, n, len, rem;
+	uint8_t *out, *blk;
+
+	/* per block: the two sizes, the token and its length bytes */
+	out = vmalloc(4 + nblocks * (10 + blksz / 255) + raw_size);
+	if (out == NULL)
+		return NULL;
+
+	wilc_wlan_fw_check_put32(out, WILC_FW_LZ4_MAGIC);
+	pos = 4;
+	for (off = 0; off < raw_size; off += n) {
+		n = min(blksz, raw_size - off);
+		blk = &out[pos + 8];
+		len = 0;
+		if (n < 15) {
+			blk[len++] = n << 4;
+		} else {
+			blk[len++] = 0xf0;
+			for (rem = n - 15; rem >= 255; rem -= 255)
+				blk[len++] = 255;
+			blk[len++] = rem;
+		}
+		memcpy(&blk[len], &raw[off], n);
+		len += n;
+
+		wilc_wlan_fw_check_put32(&out[pos], len);
+		wilc_wlan_fw_check_put32(&out[pos + 4], n);
+		pos += 8 + len;
+	}
+
+	*packed_size = pos;
+	return out;
+}
+
+/* Inflate a whole compressed image, NULL if it is corrupted */
+static uint8_t *wilc_wlan_fw_check_unpack(const uint8_t *image, uint32_t image_size, uint32_t *raw_size)
+{
+	uint32_t offset, csize, rsize, total = 0;
+	uint8_t *raw;
+
+	for (offset = 4; offset + 8 <= image_size; offset += 8 + csize) {
+		memcpy(&csize, &image[offset], 4);
+		memcpy(&rsize, &image[offset + 4], 4);
+#ifdef BIG_ENDIAN
+		csize = BYTE_SWAP(csize);
+		rsize = BYTE_SWAP(rsize);
+#endif
+		if (csize > image_size - offset - 8 || rsize > WILC_FW_LZ4_BLOCK_MAX)
+			return NULL;
+		total += rsize;
+	}
+	if (offset != image_size || total == 0)
+		return NULL;
+
+	raw = vmalloc(total);
+	if (raw == NULL)
+		return NULL;
+
+	total = 0;
+	for (offset = 4; offset < image_size; offset += 8 + csize) {
+		memcpy(&csize, &image[offset], 4);
+		memcpy(&rsize, &image[offset + 4], 4);
+#ifdef BIG_ENDIAN
+		csize = BYTE_SWAP(csize);
+		rsize = BYTE_SWAP(rsize);
+#endif
+		if (wilc_wlan_fw_inflate(&image[offset + 8], csize, &raw[total], rsize) != (int)rsize) {
+			vfree(raw);
+			return NULL;
+		}
+		total += rsize;
 	}
+
+	*raw_size = total;
+	return raw;
+}
+
+static int wilc_wlan_fw_check_line(char *buf, int size, const char *name, int ret, uint32_t crc, uint32_t bytes)
+{
+	if (ret < 0)
+		return scnprintf(buf, size, "%-12s failed (%d)\n", name, ret);
+	return scnprintf(buf, size, "%-12s %9u %08x %s\n", name, fw_check.bytes, fw_check.crc,
+			(fw_check.crc == crc && fw_check.bytes == bytes) ? "ok" : "MISMATCH");
+}
+#endif
+
+/*
+ * Download image, the cached firmware, through both paths without touching
+ * the chip: as is and compressed if it is a raw image, inflated and as is
+ * if it is compressed, and re-cut with a few block sizes that make section
+ * headers and data straddle blocks. Every compressed download has to write
+ * the same bytes to the same addresses as the raw one.
+ */
+int wilc_wlan_fw_download_check(const uint8_t *image, uint32_t image_size, char *buf, int size)
+{
+#ifndef WILC_FW_LZ4
+	return scnprintf(buf, size, "compressed firmware is not supported by this build\n");
 #else
-	if (p->io_func.io_type == HIF_SDIO) {
-		reg = 0;
-		reg |= (1 << 3); /* bug 4456 and 4557 */
-	} else if (p->io_func.io_type == HIF_SPI) {
-		reg = 1;
+	static const uint32_t blksz[] = { WILC_FW_LZ4_BLOCK_MAX, 4096, 1020, 12 };
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t saved_time, saved_size, saved_chunk, saved_zero_copy, saved_compressed;
+	uint32_t magic = 0, raw_size = 0, packed_size, crc, bytes;
+	const uint8_t *raw = image;
+	uint8_t *unpacked = NULL, *packed;
+	char name[16];
+	int len = 0, ret, i;
+
+	/* the download paths need the bus lock and os_func from wilc_wlan_init() */
+	if (p->hif_lock == NULL || p->quit)
+		return scnprintf(buf, size, "not initialized\n");
+	if (image_size >= 4)
+		memcpy(&magic, image, 4);
+#ifdef BIG_ENDIAN
+	magic = BYTE_SWAP(magic);
+#endif
+
+	if (magic == WILC_FW_LZ4_MAGIC) {
+		unpacked = wilc_wlan_fw_check_unpack(image, image_size, &raw_size);
+		if (unpacked == NULL)
+			return scnprintf(buf, size, "cached compressed image is corrupted\n");
+		raw = unpacked;
+	} else {
+		raw_size = image_size;
 	}
-	acquire_bus(ACQUIRE_ONLY);
-	ret = p->hif_func.hif_write_reg(WILC_VMM_CORE_CFG, reg);
-	if (!ret) {
-		wilc_debug(N_ERR, "[wilc start]: fail write reg vmm_core_cfg...\n");
-		release_bus(RELEASE_ONLY);
-		/* EIO  5*/
-		ret = -5;
- 		return ret;
+
+	mutex_lock(&fw_check_lock);
+	saved_time = p->fw_download_time;
+	saved_size = p->fw_download_size;
+	saved_chunk = p->fw_download_chunk;
+	saved_zero_copy = p->fw_zero_copy_bytes;
+	saved_compressed = p->fw_compressed_size;
+
+	p->os_func.os_enter_cs(p->hif_lock);
+	fw_check.task = current;
+	fw_check.block_tx = p->hif_func.hif_block_tx;
+	p->hif_func.hif_block_tx = wilc_wlan_fw_check_block_tx;
+	p->os_func.os_leave_cs(p->hif_lock);
+
+	len += scnprintf(buf + len, size - len, "cached image %s, %u bytes, %u raw\n",
+			unpacked ? "compressed" : "raw", image_size, raw_size);
+	len += scnprintf(buf + len, size - len, "%-12s %9s %8s\n", "path", "bytes", "crc");
+
+	ret = wilc_wlan_fw_check_run(raw, raw_size);
+	crc = fw_check.crc;
+	bytes = fw_check.bytes;
+	if (ret < 0) {
+		len += scnprintf(buf + len, size - len, "%-12s failed (%d)\n", "raw", ret);
+		goto _restore_;
 	}
-	reg = 0;
+	len += scnprintf(buf + len, size - len, "%-12s %9u %08x\n", "raw", bytes, crc);
+
+	if (unpacked) {
+		ret = wilc_wlan_fw_check_run(image, image_size);
+		len += wilc_wlan_fw_check_line(buf + len, size - len, "lz4 cached", ret, crc, bytes);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(blksz); i++) {
+		snprintf(name, sizeof(name), "lz4/%u", blksz[i]);
+		packed = wilc_wlan_fw_check_pack(raw, raw_size, blksz[i], &packed_size);
+		if (packed == NULL) {
+			len += scnprintf(buf + len, size - len, "%-12s out of memory\n", name);
+			continue;
+		}
+		ret = wilc_wlan_fw_check_run(packed, packed_size);
+		len += wilc_wlan_fw_check_line(buf + len, size - len, name, ret, crc, bytes);
+		vfree(packed);
+	}
+
+_restore_:
+	p->os_func.os_enter_cs(p->hif_lock);
+	p->hif_func.hif_block_tx = fw_check.block_tx;
+	fw_check.task = NULL;
+	p->os_func.os_leave_cs(p->hif_lock);
+
+	p->fw_download_time = saved_time;
+	p->fw_download_size = saved_size;
+	p->fw_download_chunk = saved_chunk;
+	p->fw_zero_copy_bytes = saved_zero_copy;
+	p->fw_compressed_size = saved_compressed;
+	mutex_unlock(&fw_check_lock);
+
+	if (unpacked)
+		vfree(unpacked);
+
+	return len;
+#endif
+}
+#endif
+
+/********************************************
+
+	Common
+
+********************************************/
+/*
+ * Host configuration handed to the firmware in WILC_GP_REG_1 at start.
+ * Also used to tell whether a running firmware is the one we started.
+ */
+static uint32_t wilc_wlan_host_cfg(void)
+{
+	uint32_t reg = 0;
+
 #ifdef WILC_SDIO_IRQ_GPIO
 	reg |= WILC_HAVE_SDIO_IRQ_GPIO;
 #endif
@@ -1993,6 +2852,52 @@ static int wilc_wlan_start(void)
 	reg |= WILC_HAVE_DISABLE_WILC_UART;
 #endif
 
+	return reg;
+}
+
+static int wilc_wlan_start(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t reg = 0;
+	int ret;
+	uint32_t chipid;
+
+	/**
+		Set the host interface
+	**/
+#ifdef OLD_FPGA_BITFILE
+	acquire_bus(ACQUIRE_ONLY);
+	ret = p->hif_func.hif_read_reg(WILC_VMM_CORE_CTL, &reg);
+	if (!ret) {
+		wilc_debug(N_ERR, "[wilc start]: fail read reg vmm_core_ctl...\n");
+		release_bus(RELEASE_ALLOW_SLEEP);
+ 		return ret;
+	}
+	reg |= (p->io_func.io_type<<2);
+	ret = p->hif_func.hif_write_reg(WILC_VMM_CORE_CTL, reg);
+	if (!ret) {
+		wilc_debug(N_ERR, "[wilc start]: fail write reg vmm_core_ctl...\n");
+		release_bus(RELEASE_ONLY);
+ 		return ret;
+	}
+#else
+	if (p->io_func.io_type == HIF_SDIO) {
+		reg = 0;
+		reg |= (1 << 3); /* bug 4456 and 4557 */
+	} else if (p->io_func.io_type == HIF_SPI) {
+		reg = 1;
+	}
+	acquire_bus(ACQUIRE_ONLY);
+	ret = p->hif_func.hif_write_reg(WILC_VMM_CORE_CFG, reg);
+	if (!ret) {
+		wilc_debug(N_ERR, "[wilc start]: fail write reg vmm_core_cfg...\n");
+		release_bus(RELEASE_ONLY);
+		/* EIO  5*/
+		ret = -5;
+ 		return ret;
+	}
+	reg = wilc_wlan_host_cfg();
+
 	ret = p->hif_func.hif_write_reg(WILC_GP_REG_1, reg);
 	if (!ret) {
 		wilc_debug(N_ERR, "[wilc start]: fail write WILC_GP_REG_1 ...\n");
@@ -2039,6 +2944,37 @@ static int wilc_wlan_start(void)
 	return (ret<0)?ret:0;
 }
 
+/*
+ * True if the chip CPU is running with the host configuration this driver
+ * writes at start, i.e. firmware we booted earlier and have not stopped.
+ */
+static int wilc_wlan_fw_running(int wakeup)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t gp_reg_1 = 0, glb_reset = 0;
+	int ret;
+
+	/**
+		Without wakeup this may be called before any firmware was loaded,
+		when a wakeup would never complete, so the registers are read as
+		they are. A firmware this driver booted and left running is
+		normally asleep and only shows up in them once woken.
+	**/
+	acquire_bus(wakeup ? ACQUIRE_AND_WAKEUP : ACQUIRE_ONLY);
+	ret = p->hif_func.hif_read_reg(WILC_GP_REG_1, &gp_reg_1);
+	if (ret)
+		ret = p->hif_func.hif_read_reg(WILC_GLB_RESET_0, &glb_reset);
+	release_bus(wakeup ? RELEASE_ALLOW_SLEEP : RELEASE_ONLY);
+
+	return ret && (gp_reg_1 == wilc_wlan_host_cfg()) && (glb_reset & (1ul << 10));
+}
+
+/* Leave the firmware running on the next cleanup, see wilc_wlan_cleanup() */
+static void wilc_wlan_keep_fw(int keep)
+{
+	g_wlan.keep_fw = keep;
+}
+
 void wilc_wlan_global_reset(void)
 {
 
@@ -2136,6 +3072,16 @@ static void wilc_wlan_cleanup(void)
 	uint8_t ac;
 
 	p->quit = 1;
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+	cancel_delayed_work_sync(&p->sleep_gov.sleep_work);
+	/* the cancelled work may have been the one to let the chip sleep */
+	acquire_bus(ACQUIRE_ONLY);
+	if (p->sleep_gov.chip_awake)
+		chip_allow_sleep();
+	release_bus(RELEASE_ONLY);
+#endif
+	/* nobody will answer the cfg frames still in flight */
+	wilc_wlan_cfg_abort_all();
 	/**
 		wait for queue end
 	**/
@@ -2173,6 +3119,13 @@ static void wilc_wlan_cleanup(void)
 		p->os_func.os_free((void *)rqe);
 	} while (1);
 
+	do {
+		struct cfg_rxq_entry_t *cqe = wilc_wlan_cfg_rxq_remove();
+		if (cqe == NULL)
+			break;
+		p->os_func.os_free((void *)cqe);
+	} while (1);
+
 	/**
 		clean up buffer
 	**/
@@ -2194,6 +3147,8 @@ static void wilc_wlan_cleanup(void)
 	}
 #endif
 
+	/* firmware is kept running for the next bring up, don't abort it */
+	if (!p->keep_fw) {
 	acquire_bus(ACQUIRE_AND_WAKEUP);
 
 
@@ -2209,6 +3164,7 @@ static void wilc_wlan_cleanup(void)
 		release_bus(RELEASE_ALLOW_SLEEP);
 	}
 	release_bus(RELEASE_ALLOW_SLEEP);
+	}
 	/**
 		io clean up
 	**/
@@ -2216,12 +3172,12 @@ static void wilc_wlan_cleanup(void)
 
 }
 
-static int wilc_wlan_cfg_commit(int type,uint32_t drvHandler)
+static int wilc_wlan_cfg_commit(wilc_cfg_slot_t *slot, int type, uint32_t drvHandler)
 {
 	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
-	wilc_cfg_frame_t *cfg = &p->cfg_frame;
+	wilc_cfg_frame_t *cfg = &slot->frame;
 	int total_len = p->cfg_frame_offset+4+ DRIVER_HANDLER_SIZE ;
-	int seq_no = p->cfg_seq_no%256;
+	int seq_no = slot->seq_no;
 	int driver_handler=(WILC_Uint32)drvHandler;
 
 
@@ -2240,7 +3196,6 @@ static int wilc_wlan_cfg_commit(int type,uint32_t drvHandler)
 	cfg->wid_header[5] = (uint8_t)(driver_handler>>8);
 	cfg->wid_header[6] = (uint8_t)(driver_handler>>16);
 	cfg->wid_header[7] = (uint8_t)(driver_handler>>24);
-	p->cfg_seq_no = seq_no;
 
 	/**
 		Add to TX queue
@@ -2253,81 +3208,449 @@ static int wilc_wlan_cfg_commit(int type,uint32_t drvHandler)
 	return 0;
 }
 
-static int wilc_wlan_cfg_set(int start, uint32_t wid, uint8_t *buffer, uint32_t buffer_size, int commit,uint32_t drvHandler)
+/*
+ * cfg frame slots. A frame takes the slot of its sequence number from the
+ * moment its transaction starts packing it until its response has been
+ * handled, so responses are matched by rsp.seq_no alone and up to
+ * WILC_CFG_SLOTS frames can be in flight. A synchronous caller collects
+ * its frames itself; an asynchronous frame is freed when it completes.
+ */
+static void wilc_wlan_cfg_complete(int seq_no, int status)
 {
 	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
-	uint32_t offset;
-	int ret_size;
+	wilc_cfg_slot_t *slot = &p->cfg_slot[seq_no % WILC_CFG_SLOTS];
+	wilc_cfg_done_func_t done = NULL;
+	void *priv = NULL;
+	unsigned long flags;
+	int i, freed = 0;
 
+	spin_lock_irqsave(&p->cfg_slot_lock, flags);
+	if (slot->state != WILC_CFG_SLOT_PENDING || slot->seq_no != seq_no) {
+		spin_unlock_irqrestore(&p->cfg_slot_lock, flags);
+		PRINT_D(RX_DBG,"No cfg frame waiting for seq_no %d\n",seq_no);
+		return;
+	}
+	p->cfg_inflight--;
+	if (slot->status)
+		status = slot->status;
+
+	if (status) {
+		/* the rest of the transaction reports the failure too */
+		for (i = 0; i < WILC_CFG_SLOTS; i++) {
+			if (p->cfg_slot[i].state == WILC_CFG_SLOT_PENDING && p->cfg_slot[i].txn == slot->txn)
+				p->cfg_slot[i].status = status;
+		}
+	}
 
-	if (p->cfg_frame_in_use)
-		return 0;
+	if (slot->async) {
+		done = slot->done;
+		priv = slot->priv;
+		slot->state = WILC_CFG_SLOT_FREE;
+		p->cfg_async_done++;
+		freed = 1;
+	} else {
+		slot->status = status;
+		slot->state = WILC_CFG_SLOT_DONE;
+		complete(&slot->comp);
+	}
+	spin_unlock_irqrestore(&p->cfg_slot_lock, flags);
 
-	if (start)
-		p->cfg_frame_offset = 0;
+	if (freed)
+		wake_up(&p->cfg_slot_free);
+	if (done)
+		done(priv, status);
+}
 
-	offset = p->cfg_frame_offset;
-	ret_size = p->cif_func.cfg_wid_set(p->cfg_frame.frame, offset, (uint16_t)wid, buffer, buffer_size);
-	offset += ret_size;
-	p->cfg_frame_offset = offset;
+/* Fail every frame still in flight, the chip is going away */
+static void wilc_wlan_cfg_abort_all(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	int i;
 
-	if (commit) {
-		PRINT_D(TX_DBG,"[WILC]PACKET Commit with sequence number %d\n",p->cfg_seq_no);
-		PRINT_D(RX_DBG,"Processing cfg_set()\n");
-		p->cfg_frame_in_use = 1;
+	for (i = 0; i < WILC_CFG_SLOTS; i++) {
+		if (p->cfg_slot[i].state == WILC_CFG_SLOT_PENDING)
+			wilc_wlan_cfg_complete(p->cfg_slot[i].seq_no, -1);
+	}
+}
 
-		/*Edited by Amr - BugID_4720*/
-		if(wilc_wlan_cfg_commit(WILC_CFG_SET,drvHandler))
-			ret_size = 0;	//BugID_5213
+/* Wait for a synchronous frame and free its slot */
+static int wilc_wlan_cfg_slot_collect(wilc_cfg_slot_t *slot)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	unsigned long flags;
+	int status;
 
-		if(p->os_func.os_wait(p->cfg_wait,CFG_PKTS_TIMEOUT))
-		{
-			PRINT_D(TX_DBG, "Set Timed Out\n");
-			ret_size = 0;
+	wait_for_completion_timeout(&slot->comp, msecs_to_jiffies(CFG_PKTS_TIMEOUT));
+
+	spin_lock_irqsave(&p->cfg_slot_lock, flags);
+	if (slot->state == WILC_CFG_SLOT_PENDING) {
+		PRINT_D(TX_DBG, "cfg frame %d Timed Out\n", slot->seq_no);
+		p->cfg_inflight--;
+		p->cfg_timeouts++;
+		status = -1;
+	} else {
+		status = slot->status;
+	}
+	slot->state = WILC_CFG_SLOT_FREE;
+	spin_unlock_irqrestore(&p->cfg_slot_lock, flags);
+	wake_up(&p->cfg_slot_free);
+
+	return status;
+}
+
+/*
+ * Reserve the slot of the next sequence number for the open transaction.
+ * When all slots are in flight this waits for the oldest frame.
+ */
+static wilc_cfg_slot_t *wilc_wlan_cfg_slot_get(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	int seq_no = p->cfg_seq_no % 256;
+	wilc_cfg_slot_t *slot = &p->cfg_slot[seq_no % WILC_CFG_SLOTS];
+	int tries;
+
+	for (tries = 0; tries < 2 && slot->state != WILC_CFG_SLOT_FREE; tries++) {
+		if (!slot->async && slot->txn == p->cfg_txns) {
+			/* an earlier frame of this transaction */
+			if (wilc_wlan_cfg_slot_collect(slot))
+				p->cfg_txn_failed = 1;
+		} else if (slot->async && slot->state == WILC_CFG_SLOT_PENDING &&
+			   time_after(jiffies, slot->deadline)) {
+			PRINT_D(TX_DBG, "cfg frame %d Timed Out\n", slot->seq_no);
+			p->cfg_timeouts++;
+			wilc_wlan_cfg_complete(slot->seq_no, -1);
+		} else {
+			wait_event_timeout(p->cfg_slot_free, slot->state == WILC_CFG_SLOT_FREE,
+					   msecs_to_jiffies(CFG_PKTS_TIMEOUT));
 		}
-		p->cfg_frame_in_use = 0;
-		p->cfg_frame_offset = 0;
-		p->cfg_seq_no += 1;
+	}
+	if (slot->state != WILC_CFG_SLOT_FREE) {
+		wilc_debug(N_ERR, "[wilc cfg]: no free cfg frame...\n");
+		return NULL;
+	}
+
+	slot->state = WILC_CFG_SLOT_BUILDING;
+	slot->seq_no = seq_no;
+	slot->txn = p->cfg_txns;
+	slot->async = 0;
+	slot->status = 0;
+	slot->done = NULL;
+	slot->priv = NULL;
+	init_completion(&slot->comp);	/* nobody waits on a free slot */
+	p->cfg_seq_no = seq_no + 1;
+
+	return slot;
+}
+
+/* Queue a packed frame. Its response is not waited for here. */
+static int wilc_wlan_cfg_send(wilc_cfg_slot_t *slot, int type, uint32_t drvHandler, int wids)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	unsigned long flags;
+
+	PRINT_D(TX_DBG,"[WILC]PACKET Commit with sequence number %d, %d WIDs\n",slot->seq_no,wids);
 
+	slot->deadline = jiffies + msecs_to_jiffies(CFG_PKTS_TIMEOUT);
+	spin_lock_irqsave(&p->cfg_slot_lock, flags);
+	slot->state = WILC_CFG_SLOT_PENDING;
+	p->cfg_inflight++;
+	if (p->cfg_inflight > p->cfg_inflight_max)
+		p->cfg_inflight_max = p->cfg_inflight;
+	spin_unlock_irqrestore(&p->cfg_slot_lock, flags);
+
+	p->cfg_frames_sent++;
+	p->cfg_wids_sent += wids;
+
+	/*Edited by Amr - BugID_4720*/
+	if(wilc_wlan_cfg_commit(slot, type, drvHandler)) {
+		wilc_wlan_cfg_complete(slot->seq_no, -1);	//BugID_5213
+		return -1;
 	}
 
-	return ret_size;
+	return 0;
 }
-static int wilc_wlan_cfg_get(int start, uint32_t wid, int commit,uint32_t drvHandler)
+
+/*
+ * Config transactions. WIDs added between start and commit are packed into
+ * as few frames as MAX_CFG_FRAME_SIZE allows: a frame is only sent when the
+ * next WID doesn't fit, or when the transaction switches between set and
+ * query. Frames are queued as they fill up without waiting for each
+ * other's responses. The transaction lock keeps other callers out until
+ * commit, so every start must be paired with a commit, also on error.
+ */
+static int wilc_wlan_cfg_txn_start(uint32_t drvHandler)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	p->os_func.os_enter_cs(p->cfg_txn_lock);
+	p->cfg_txn_type = WILC_CFG_SET;
+	p->cfg_txn_drv = drvHandler;
+	p->cfg_txn_wids = 0;
+	p->cfg_txn_total = 0;
+	p->cfg_txn_frames = 0;
+	p->cfg_txn_failed = 0;
+	p->cfg_txn_slot = NULL;
+	p->cfg_txn_first_seq = p->cfg_seq_no % 256;
+	p->cfg_frame_offset = 0;
+	p->cfg_txns++;
+
+	return 1;
+}
+
+static int wilc_wlan_cfg_txn_flush(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	if (p->cfg_txn_wids == 0)
+		return 0;
+
+	if (wilc_wlan_cfg_send(p->cfg_txn_slot, p->cfg_txn_type, p->cfg_txn_drv, p->cfg_txn_wids))
+		p->cfg_txn_failed = 1;
+	p->cfg_txn_slot = NULL;
+	p->cfg_txn_frames++;
+	p->cfg_txn_wids = 0;
+	p->cfg_frame_offset = 0;
+
+	return p->cfg_txn_failed ? -1 : 0;
+}
+
+static int wilc_wlan_cfg_txn_pack(int type, uint32_t wid, uint8_t *buffer, uint32_t buffer_size)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	if (p->cfg_txn_slot == NULL) {
+		p->cfg_txn_slot = wilc_wlan_cfg_slot_get();
+		if (p->cfg_txn_slot == NULL)
+			return 0;
+	}
+
+	if (type == WILC_CFG_SET)
+		return p->cif_func.cfg_wid_set(p->cfg_txn_slot->frame.frame, p->cfg_frame_offset, (uint16_t)wid, buffer, buffer_size);
+	return p->cif_func.cfg_wid_get(p->cfg_txn_slot->frame.frame, p->cfg_frame_offset, (uint16_t)wid);
+}
+
+static int wilc_wlan_cfg_txn_add(int type, uint32_t wid, uint8_t *buffer, uint32_t buffer_size)
 {
 	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
-	uint32_t offset;
 	int ret_size;
 
+	if (p->cfg_txn_failed)
+		return 0;
+
+	if (type != p->cfg_txn_type) {
+		if (wilc_wlan_cfg_txn_flush())
+			return 0;
+		p->cfg_txn_type = type;
+	}
+
+	ret_size = wilc_wlan_cfg_txn_pack(type, wid, buffer, buffer_size);
+	if (ret_size == 0 && p->cfg_txn_wids > 0) {
+		/* frame is full, send it and start the next one */
+		if (wilc_wlan_cfg_txn_flush())
+			return 0;
+		p->cfg_frame_splits++;
+		ret_size = wilc_wlan_cfg_txn_pack(type, wid, buffer, buffer_size);
+	}
 
-	if (p->cfg_frame_in_use)
+	if (ret_size == 0) {
+		wilc_debug(N_ERR, "[wilc cfg]: can't pack wid (0x%x)...\n", wid);
+		p->cfg_txn_failed = 1;
 		return 0;
+	}
+
+	p->cfg_frame_offset += ret_size;
+	p->cfg_txn_wids++;
+	p->cfg_txn_total++;
+
+	return ret_size;
+}
+
+static int wilc_wlan_cfg_txn_set(uint32_t wid, uint8_t *buffer, uint32_t buffer_size)
+{
+	return wilc_wlan_cfg_txn_add(WILC_CFG_SET, wid, buffer, buffer_size);
+}
+
+static int wilc_wlan_cfg_txn_get(uint32_t wid)
+{
+	return wilc_wlan_cfg_txn_add(WILC_CFG_QUERY, wid, NULL, 0);
+}
+
+/* Send what is left; a failed transaction drops its unsent frame */
+static void wilc_wlan_cfg_txn_close(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	if (!p->cfg_txn_failed)
+		wilc_wlan_cfg_txn_flush();
+
+	if (p->cfg_txn_slot != NULL) {
+		p->cfg_txn_slot->state = WILC_CFG_SLOT_FREE;
+		p->cfg_txn_slot = NULL;
+		wake_up(&p->cfg_slot_free);
+	}
+
+	p->cfg_last_txn_wids = p->cfg_txn_total;
+	p->cfg_last_txn_frames = p->cfg_txn_frames;
+	p->cfg_txn_wids = 0;
+	p->cfg_frame_offset = 0;
+}
+
+/* Wait for the responses of a closed transaction */
+static int wilc_wlan_cfg_txn_collect(uint32_t txn, int first, int frames, int failed)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	wilc_cfg_slot_t *slot;
+	int i, seq_no;
+
+	for (i = 0; i < frames; i++) {
+		seq_no = (first + i) % 256;
+		slot = &p->cfg_slot[seq_no % WILC_CFG_SLOTS];
+		if (slot->state != WILC_CFG_SLOT_FREE && slot->seq_no == seq_no &&
+		    slot->txn == txn && !slot->async) {
+			if (wilc_wlan_cfg_slot_collect(slot))
+				failed = 1;
+		}
+	}
+
+	return failed ? -1 : frames;
+}
+
+/*
+ * Send what is left and release the transaction, then wait for its
+ * responses. Other transactions can be built and sent meanwhile. Returns
+ * the number of frames (round trips) the transaction took, or -1 if any
+ * WID failed.
+ */
+static int wilc_wlan_cfg_txn_commit(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	uint32_t txn = p->cfg_txns;
+	int first, frames, failed;
+
+	wilc_wlan_cfg_txn_close();
+	first = p->cfg_txn_first_seq;
+	frames = p->cfg_txn_frames;
+	failed = p->cfg_txn_failed;
+
+	p->os_func.os_leave_cs(p->cfg_txn_lock);
+
+	return wilc_wlan_cfg_txn_collect(txn, first, frames, failed);
+}
+
+/*
+ * Like wilc_wlan_cfg_txn_commit(), but the transaction stays locked until
+ * wilc_wlan_cfg_txn_end(). Queried values land in the WID value tables
+ * shared by every transaction, so a query reads them back with
+ * wlan_cfg_get_value() before ending, when no other query can be answered
+ * over them.
+ */
+static int wilc_wlan_cfg_txn_commit_hold(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	wilc_wlan_cfg_txn_close();
+
+	return wilc_wlan_cfg_txn_collect(p->cfg_txns, p->cfg_txn_first_seq,
+					 p->cfg_txn_frames, p->cfg_txn_failed);
+}
+
+static void wilc_wlan_cfg_txn_end(void)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+
+	p->os_func.os_leave_cs(p->cfg_txn_lock);
+}
+
+/*
+ * Send what is left and release the transaction without waiting. done is
+ * called with the outcome of the whole transaction, inline in the RX path
+ * that handled the last response, which can be the interrupt handler with
+ * the bus held: it must not block, take sleeping locks or touch the bus. It can also run right here, from
+ * the caller, when every response is already in. Returns -1 if the
+ * transaction failed before being sent, done is not called then.
+ */
+static int wilc_wlan_cfg_txn_commit_async(wilc_cfg_done_func_t done, void *priv)
+{
+	wilc_wlan_dev_t *p = (wilc_wlan_dev_t *)&g_wlan;
+	wilc_cfg_slot_t *slot, *last = NULL;
+	uint32_t txn = p->cfg_txns;
+	unsigned long flags;
+	int i, seq_no, status, freed = 0;
+
+	wilc_wlan_cfg_txn_close();
+
+	spin_lock_irqsave(&p->cfg_slot_lock, flags);
+	for (i = 0; i < p->cfg_txn_frames; i++) {
+		seq_no = (p->cfg_txn_first_seq + i) % 256;
+		slot = &p->cfg_slot[seq_no % WILC_CFG_SLOTS];
+		if (slot->state == WILC_CFG_SLOT_FREE || slot->seq_no != seq_no || slot->txn != txn)
+			continue;
+		if (slot->state == WILC_CFG_SLOT_DONE) {
+			if (slot->status)
+				p->cfg_txn_failed = 1;
+			slot->state = WILC_CFG_SLOT_FREE;
+			freed = 1;
+		} else {
+			slot->async = 1;
+			last = slot;
+		}
+	}
+	if (last != NULL) {
+		last->done = done;
+		last->priv = priv;
+		if (p->cfg_txn_failed)
+			last->status = -1;
+	}
+	status = p->cfg_txn_failed ? -1 : 0;
+	spin_unlock_irqrestore(&p->cfg_slot_lock, flags);
+
+	p->os_func.os_leave_cs(p->cfg_txn_lock);
+
+	if (freed)
+		wake_up(&p->cfg_slot_free);
+	/* everything was answered already */
+	if (last == NULL && status == 0 && done)
+		done(priv, 0);
+
+	return (last == NULL) ? status : 0;
+}
+
+/*
+ * Legacy interface: start opens a transaction and commit closes it, so a
+ * sequence started here must end with a commit.
+ */
+static int wilc_wlan_cfg_set(int start, uint32_t wid, uint8_t *buffer, uint32_t buffer_size, int commit,uint32_t drvHandler)
+{
+	int ret_size;
 
 	if (start)
-		p->cfg_frame_offset = 0;
+		wilc_wlan_cfg_txn_start(drvHandler);
 
-	offset = p->cfg_frame_offset;
-	ret_size = p->cif_func.cfg_wid_get(p->cfg_frame.frame, offset, (uint16_t)wid);
-	offset += ret_size;
-	p->cfg_frame_offset = offset;
+	ret_size = wilc_wlan_cfg_txn_set(wid, buffer, buffer_size);
 
 	if (commit) {
-		p->cfg_frame_in_use = 1;
+		PRINT_D(RX_DBG,"Processing cfg_set()\n");
+		g_wlan.cfg_txn_drv = drvHandler;
+		if (wilc_wlan_cfg_txn_commit() < 0)
+			ret_size = 0;
+	}
+
+	return ret_size;
+}
+static int wilc_wlan_cfg_get(int start, uint32_t wid, int commit,uint32_t drvHandler)
+{
+	int ret_size;
 
-		/*Edited by Amr - BugID_4720*/
-		if(wilc_wlan_cfg_commit(WILC_CFG_QUERY,drvHandler))
-			ret_size = 0;	//BugID_5213
+	if (start)
+		wilc_wlan_cfg_txn_start(drvHandler);
 
+	ret_size = wilc_wlan_cfg_txn_get(wid);
 
-		if(p->os_func.os_wait(p->cfg_wait,CFG_PKTS_TIMEOUT))
-		{
-			PRINT_D(TX_DBG, "Get Timed Out\n");
+	if (commit) {
+		g_wlan.cfg_txn_drv = drvHandler;
+		if (wilc_wlan_cfg_txn_commit() < 0)
 			ret_size = 0;
-		}
 		PRINT_D(GENERIC_DBG, "[WILC]Get Response received\n");
-		p->cfg_frame_in_use = 0;
-		p->cfg_frame_offset = 0;
-		p->cfg_seq_no += 1;
 	}
 
 	return ret_size;
@@ -2525,6 +3848,14 @@ int wilc_wlan_init(wilc_wlan_inp_t *inp, wilc_wlan_oup_t *oup)
 	memcpy((void *)&g_wlan.io_func, (void *)&inp->io_func, sizeof(wilc_wlan_io_func_t));
 	memcpy((void *)&g_wlan.net_func, (void *)&inp->net_func, sizeof(wilc_wlan_net_func_t));
 	memcpy((void *)&g_wlan.indicate_func, (void *)&inp->indicate_func, sizeof(wilc_wlan_net_func_t));
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+	INIT_DELAYED_WORK(&g_wlan.sleep_gov.sleep_work, wilc_sleep_gov_work);
+#endif
+	spin_lock_init(&g_wlan.cfg_slot_lock);
+	init_waitqueue_head(&g_wlan.cfg_slot_free);
+	for (ret = 0; ret < WILC_CFG_SLOTS; ret++)
+		init_completion(&g_wlan.cfg_slot[ret].comp);
+	ret = 0;
 	g_wlan.hif_lock = inp->os_context.hif_critical_section;
 	g_wlan.txq_lock = inp->os_context.txq_critical_section;
 
@@ -2537,8 +3868,12 @@ int wilc_wlan_init(wilc_wlan_inp_t *inp, wilc_wlan_oup_t *oup)
 	g_wlan.rxq_lock = inp->os_context.rxq_critical_section;
 	g_wlan.txq_wait = inp->os_context.txq_wait_event;
 	g_wlan.rxq_wait = inp->os_context.rxq_wait_event;
+	g_wlan.cfg_rxq_lock = inp->os_context.cfg_rxq_critical_section;
+	g_wlan.cfg_txn_lock = inp->os_context.cfg_txn_critical_section;
+	g_wlan.cfg_rxq_wait = inp->os_context.cfg_rxq_wait_event;
 	g_wlan.cfg_wait = inp->os_context.cfg_wait_event;
 	g_wlan.tx_buffer_size = inp->os_context.tx_buffer_size;
+	g_wlan.fw_chunk_size = inp->os_context.fw_chunk_size;
 #if defined (MEMORY_STATIC)
 	g_wlan.rx_buffer_size = inp->os_context.rx_buffer_size;
 #endif
@@ -2635,14 +3970,25 @@ int wilc_wlan_init(wilc_wlan_inp_t *inp, wilc_wlan_oup_t *oup)
 	oup->wlan_firmware_download = wilc_wlan_firmware_download;
 	oup->wlan_start = wilc_wlan_start;
 	oup->wlan_stop = wilc_wlan_stop;
+	oup->wlan_fw_running = wilc_wlan_fw_running;
+	oup->wlan_keep_fw = wilc_wlan_keep_fw;
 	oup->wlan_add_to_tx_que = wilc_wlan_txq_add_net_pkt;
 	oup->wlan_handle_tx_que = wilc_wlan_handle_txq;
 	oup->wlan_handle_rx_que = wilc_wlan_handle_rxq;
+	oup->wlan_handle_cfg_rx_que = wilc_wlan_handle_cfg_rxq;
 	//oup->wlan_handle_rx_isr = wilc_wlan_handle_isr;
 	oup->wlan_handle_rx_isr = wilc_handle_isr;
 	oup->wlan_cleanup = wilc_wlan_cleanup;
 	oup->wlan_cfg_set = wilc_wlan_cfg_set;
 	oup->wlan_cfg_get = wilc_wlan_cfg_get;
+	oup->wlan_cfg_txn_start = wilc_wlan_cfg_txn_start;
+	oup->wlan_cfg_txn_set = wilc_wlan_cfg_txn_set;
+	oup->wlan_cfg_txn_get = wilc_wlan_cfg_txn_get;
+	oup->wlan_cfg_txn_commit = wilc_wlan_cfg_txn_commit;
+	oup->wlan_cfg_txn_commit_async = wilc_wlan_cfg_txn_commit_async;
+	oup->wlan_cfg_txn_commit_hold = wilc_wlan_cfg_txn_commit_hold;
+	oup->wlan_cfg_txn_end = wilc_wlan_cfg_txn_end;
+	oup->wlan_cfg_abort_all = wilc_wlan_cfg_abort_all;
 	oup->wlan_cfg_get_value = wilc_wlan_cfg_get_val;
 
 	/*Bug3959: transmitting mgmt frames received from host*/
@@ -2721,6 +4067,127 @@ WILC_Uint16 Set_machw_change_vir_if(WILC_Bool bValue)
 	return ret;
 }
 
+#if defined(WILC_DEBUGFS)
+int wilc_wlan_dump_rx_burst_stats(char *buf, int size)
+{
+	int i, len = 0;
+
+	len += scnprintf(buf + len, size - len, "bursts/isr  count\n");
+	for (i = 0; i <= WILC_RX_BURST_BUDGET; i++)
+		len += scnprintf(buf + len, size - len, "%2d%s  %u\n", i,
+				(i == WILC_RX_BURST_BUDGET) ? "+" : " ", g_wlan.rx_burst_hist[i]);
+
+	return len;
+}
+
+int wilc_wlan_dump_wake_latency(char *buf, int size)
+{
+	int i, len = 0;
+
+	len += scnprintf(buf + len, size - len, "wake latency (us)  count\n");
+	for (i = 0; i < WILC_WAKE_LAT_HIST_SIZE - 1; i++)
+		len += scnprintf(buf + len, size - len, "< %-16u %u\n",
+				WILC_WAKE_LAT_HIST_BASE << i, g_wlan.wake_lat_hist[i]);
+	len += scnprintf(buf + len, size - len, ">= %-15u %u\n",
+			WILC_WAKE_LAT_HIST_BASE << (WILC_WAKE_LAT_HIST_SIZE - 2), g_wlan.wake_lat_hist[i]);
+
+	return len;
+}
+
+int wilc_wlan_dump_fw_stats(char *buf, int size)
+{
+	return scnprintf(buf, size,
+			"download size        %u\n"
+			"download time        %u us\n"
+			"chunk size           %u\n"
+			"zero copy bytes      %u\n"
+			"compressed size      %u\n",
+			g_wlan.fw_download_size, g_wlan.fw_download_time,
+			g_wlan.fw_download_chunk, g_wlan.fw_zero_copy_bytes,
+			g_wlan.fw_compressed_size);
+}
+
+int wilc_wlan_dump_cfg_stats(char *buf, int size)
+{
+	uint32_t saved = 0;
+
+	if (g_wlan.cfg_wids_sent > g_wlan.cfg_frames_sent)
+		saved = g_wlan.cfg_wids_sent - g_wlan.cfg_frames_sent;
+
+	return scnprintf(buf, size,
+			"transactions         %u\n"
+			"frames sent          %u\n"
+			"wids sent            %u\n"
+			"round trips saved    %u\n"
+			"full frame splits    %u\n"
+			"last transaction     %u wids in %u frames\n"
+			"in flight            %d (max %u)\n"
+			"async completions    %u\n"
+			"timeouts             %u\n",
+			g_wlan.cfg_txns, g_wlan.cfg_frames_sent, g_wlan.cfg_wids_sent,
+			saved, g_wlan.cfg_frame_splits,
+			g_wlan.cfg_last_txn_wids, g_wlan.cfg_last_txn_frames,
+			g_wlan.cfg_inflight, g_wlan.cfg_inflight_max,
+			g_wlan.cfg_async_done, g_wlan.cfg_timeouts);
+}
+
+#ifdef HAS_SUSPEND_RESUME
+int wilc_wlan_dump_resume_stats(char *buf, int size)
+{
+	return scnprintf(buf, size,
+			"warm resumes         %u\n"
+			"cold resumes         %u\n"
+			"last resume          %u us\n"
+			"last resume to rx    %u us%s\n",
+			g_wlan.warm_resumes, g_wlan.cold_resumes, g_wlan.resume_lat,
+			g_wlan.resume_rx_lat, g_wlan.resume_rx_pending ? " (waiting for rx)" : "");
+}
+#endif
+
+#ifdef WILC_OPTIMIZE_SLEEP_INT
+int wilc_wlan_dump_sleep_stats(char *buf, int size)
+{
+	wilc_sleep_gov_t *gov = &g_wlan.sleep_gov;
+	uint64_t awake, asleep, avg_lat = 0;
+	ktime_t now = ktime_get();
+	int64_t delta;
+
+	/* the bus lock only exists between wilc_wlan_init() and wilc_wlan_cleanup() */
+	if (g_wlan.hif_lock == NULL || g_wlan.quit)
+		return scnprintf(buf, size, "not initialized\n");
+
+	g_wlan.os_func.os_enter_cs(g_wlan.hif_lock);
+	awake = gov->awake_time;
+	asleep = gov->asleep_time;
+	delta = ktime_us_delta(now, gov->state_since);
+	if (ktime_to_ns(gov->state_since) != 0 && delta > 0) {
+		if (gov->chip_awake)
+			awake += delta;
+		else
+			asleep += delta;
+	}
+	if (gov->wakes)
+		avg_lat = div_u64(gov->wake_lat_total, gov->wakes);
+	g_wlan.os_func.os_leave_cs(g_wlan.hif_lock);
+
+	return scnprintf(buf, size,
+			"state          %s\n"
+			"governor       %s (avg gap %u us, hold %u us)\n"
+			"wakes          %u\n"
+			"wakes avoided  %u\n"
+			"sleeps         %u\n"
+			"awake time     %llu us\n"
+			"asleep time    %llu us\n"
+			"wake latency   avg %llu us, max %u us\n",
+			gov->chip_awake ? "awake" : "sleep allowed",
+			gov->busy ? "holding" : "idle", gov->avg_gap, gov->hold,
+			gov->wakes, gov->wakes_avoided, gov->sleeps,
+			(unsigned long long)awake, (unsigned long long)asleep,
+			(unsigned long long)avg_lat, gov->wake_lat_max);
+}
+#endif
+#endif
+
 #ifdef WILC_FULLY_HOSTING_AP
 wilc_wlan_dev_t* Get_wlan_context(WILC_Uint16* pu16size)
 {
@@ -251,6 +251,65 @@
 
 /*time for expiring the semaphores of cfg packets*/
 #define CFG_PKTS_TIMEOUT	2000
+
+/*
+ * cfg frames in flight at once. Slots are indexed by sequence number, so
+ * this must be a power of 2 that divides the 256 sequence numbers.
+ */
+#define WILC_CFG_SLOTS		4
+
+/*max number of RX bursts drained from the chip per DATA interrupt*/
+#define WILC_RX_BURST_BUDGET	8
+/*max number of data packets handed up in one rx_indicate_batch call*/
+#define WILC_RX_BATCH_MAX	16
+
+/*
+ * Sleep governor (WILC_OPTIMIZE_SLEEP_INT). While the averaged gap between
+ * bus accesses stays short the chip is kept awake for a while after the
+ * last access instead of being allowed to sleep straight away.
+ * Gaps are in microseconds.
+ */
+#define WILC_SLEEP_GOV_ENTER_GAP	2000	/* start holding below this */
+#define WILC_SLEEP_GOV_EXIT_GAP		8000	/* stop holding above this */
+#define WILC_SLEEP_GOV_MAX_GAP		16000	/* clamp a single gap sample */
+#define WILC_SLEEP_GOV_MIN_HOLD		1000
+#define WILC_SLEEP_GOV_MAX_HOLD		20000
+
+/*
+ * chip_wakeup() polling, in microseconds: spin in WILC_WAKE_SPIN_STEP steps
+ * for up to WILC_WAKE_SPIN_TIME, then sleep starting at WILC_WAKE_SLEEP_MIN
+ * and doubling up to WILC_WAKE_SLEEP_MAX. After WILC_WAKE_ATTEMPT_MAX the
+ * wake sequence is restarted. The caps match the old fixed 2ms/6ms waits.
+ */
+#define WILC_WAKE_SPIN_STEP		25
+#define WILC_WAKE_SPIN_TIME		200
+#define WILC_WAKE_SLEEP_MIN		100
+#define WILC_WAKE_SLEEP_MAX		2000
+#define WILC_WAKE_ATTEMPT_MAX		6000
+
+/*
+ * Firmware download chunk size. The upper bound keeps a single SDIO CMD53
+ * within its 511 block limit and the bounce buffer a sane kmalloc size.
+ */
+#define WILC_FW_CHUNK_MIN		(4*1024)
+#define WILC_FW_CHUNK_DEFAULT		(32*1024)
+#define WILC_FW_CHUNK_MAX		(128*1024)
+
+/*
+ * Compressed firmware image: the WILC_FW_LZ4_MAGIC word, then LZ4 blocks,
+ * each prefixed by its compressed and uncompressed sizes (32 bit little
+ * endian). Inflated back to back the blocks give the usual addr/size
+ * section stream. Every block but the last inflates to a multiple of 4
+ * bytes and to at most WILC_FW_LZ4_BLOCK_MAX.
+ */
+#define WILC_FW_LZ4_MAGIC		0x345a4c57	/* "WLZ4" */
+#define WILC_FW_LZ4_BLOCK_MAX		(32*1024)
+/* room in front of a block for the bytes carried over from the one before */
+#define WILC_FW_LZ4_CARRY		8
+
+/* wake latency histogram: power of 2 buckets starting below 64us */
+#define WILC_WAKE_LAT_HIST_BASE		64
+#define WILC_WAKE_LAT_HIST_SIZE		10
 /********************************************
 
 	Debug Type
@@ -283,6 +342,14 @@ struct rxq_entry_t  {
 	int buffer_size;
 };
 
+/* Non-data frame deferred from the data RX path, payload follows the entry */
+struct cfg_rxq_entry_t {
+	struct cfg_rxq_entry_t *next;
+	int is_mgmt;
+	uint8_t *buffer;
+	int buffer_size;
+};
+
 /********************************************
 
 	Host IF Structure
@@ -324,6 +391,26 @@ typedef struct {
 	uint8_t frame[MAX_CFG_FRAME_SIZE];
 } wilc_cfg_frame_t;
 
+typedef enum {
+	WILC_CFG_SLOT_FREE = 0,
+	WILC_CFG_SLOT_BUILDING,		/* WIDs being packed by the open transaction */
+	WILC_CFG_SLOT_PENDING,		/* queued, waiting for its response */
+	WILC_CFG_SLOT_DONE,		/* answered, a synchronous caller has yet to collect it */
+} wilc_cfg_slot_state_t;
+
+typedef struct {
+	wilc_cfg_slot_state_t state;
+	int seq_no;
+	uint32_t txn;			/* transaction the frame belongs to */
+	int async;			/* nobody waits: freed on completion */
+	int status;
+	unsigned long deadline;		/* jiffies */
+	wilc_cfg_done_func_t done;
+	void *priv;
+	struct completion comp;
+	wilc_cfg_frame_t frame;
+} wilc_cfg_slot_t;
+
 typedef struct {
 	int (*wlan_tx)(uint8_t *, uint32_t, wilc_tx_complete_func_t);
 } wilc_wlan_cfg_func_t;
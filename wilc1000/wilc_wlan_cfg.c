@@ -42,8 +42,14 @@ typedef struct {
 	uint8_t assoc_req[256];
 	uint8_t assoc_rsp[256];
 	uint8_t firmware_info[8];
-	uint8_t scan_result[256];
-	uint8_t scan_result1[256];
+	/*
+	 * WID_SITE_SURVEY_RESULTS is queried twice per frame and answered
+	 * with one fragment per query: fragment n of a response lands in
+	 * scan_result[n] and the n-th value read returns it.
+	 */
+	uint8_t scan_result[WILC_CFG_SURVEY_FRAGS][256];
+	int scan_result_rcvd;
+	int scan_result_read;
 } wilc_mac_cfg_t;
 
 static wilc_mac_cfg_t g_mac;
@@ -149,8 +155,7 @@ static wilc_cfg_str_t g_cfg_str[] = {
 	{WID_PHY_VERSION, g_mac.phyversion},
 	{WID_SUPP_USERNAME, g_mac.supp_username},
 	{WID_SUPP_PASSWORD, g_mac.supp_password},
-	{WID_SITE_SURVEY_RESULTS, g_mac.scan_result},
-	{WID_SITE_SURVEY_RESULTS, g_mac.scan_result1},
+	{WID_SITE_SURVEY_RESULTS, g_mac.scan_result[0]},
 	//{WID_RX_POWER_LEVEL, g_mac.channel_rssi},
 	{WID_ASSOC_REQ_INFO, g_mac.assoc_req},
 	{WID_ASSOC_RES_INFO, g_mac.assoc_rsp},
@@ -160,6 +165,18 @@ static wilc_cfg_str_t g_cfg_str[] = {
 	{WID_NIL, NULL}
 };
 
+/*
+ * WID -> table slot, keyed by the WID type and the low byte of its id.
+ * The low byte is unique within each type for every WID in the tables
+ * above, so a lookup is a single probe. Built once by wilc_wlan_cfg_init();
+ * a WID that collides with another one is left to a linear scan.
+ */
+#define WILC_CFG_TYPES		4
+#define WILC_CFG_HASH(wid)	((wid) & 0xff)
+
+static uint8_t g_cfg_index[WILC_CFG_TYPES][256];	/* slot + 1, 0 if none */
+static int g_cfg_collisions;
+
 /********************************************
 
 	Configuration Functions
@@ -279,87 +296,120 @@ static int wilc_wlan_cfg_set_bin(uint8_t *frame, uint32_t offset, uint16_t id, u
 
 ********************************************/
 
+static uint32_t wilc_wlan_cfg_id(uint32_t type, int i)
+{
+	switch (type) {
+	case WID_CHAR:
+		return g_cfg_byte[i].id;
+	case WID_SHORT:
+		return g_cfg_hword[i].id;
+	case WID_INT:
+		return g_cfg_word[i].id;
+	case WID_STR:
+		return g_cfg_str[i].id;
+	default:
+		return WID_NIL;
+	}
+}
+
+static void wilc_wlan_cfg_build_index(void)
+{
+	uint32_t type, id;
+	int i;
+
+	memset(g_cfg_index, 0, sizeof(g_cfg_index));
+	g_cfg_collisions = 0;
+
+	for (type = 0; type < WILC_CFG_TYPES; type++) {
+		for (i = 0; (id = wilc_wlan_cfg_id(type, i)) != WID_NIL; i++) {
+			/* an entry of another type can never be looked up in this table */
+			if (((id >> 12) & 0x7) != type)
+				continue;
+			if (g_cfg_index[type][WILC_CFG_HASH(id)]) {
+				g_mac.dPrint(N_ERR, "[CFG]: wid (%04x) not indexed, slot taken\n", id);
+				g_cfg_collisions++;
+				continue;
+			}
+			g_cfg_index[type][WILC_CFG_HASH(id)] = i + 1;
+		}
+	}
+}
+
+/* Table slot holding wid, -1 if the driver doesn't keep it */
+static int wilc_wlan_cfg_find(uint32_t type, uint32_t wid)
+{
+	uint32_t id;
+	int i;
+
+	if (type >= WILC_CFG_TYPES)
+		return -1;
+
+	i = g_cfg_index[type][WILC_CFG_HASH(wid)];
+	if (i && wilc_wlan_cfg_id(type, i - 1) == wid)
+		return i - 1;
+
+	if (g_cfg_collisions) {
+		for (i = 0; (id = wilc_wlan_cfg_id(type, i)) != WID_NIL; i++) {
+			if (id == wid)
+				return i;
+		}
+	}
+
+	return -1;
+}
+
 static void wilc_wlan_parse_response_frame(uint8_t *info, int size)
 {
-	uint32_t wid, len=0, i;
+	uint32_t wid, len=0;
+	int i, frags = 0;
 	static int seq = 0;
 
 	while (size>0) {
-		i = 0;
 		wid = info[0] | (info[1] << 8);
 #ifdef BIG_ENDIAN
 		wid = BYTE_SWAP(wid);
 #endif
 		PRINT_INFO(GENERIC_DBG,"Processing response for %d seq %d\n",wid,seq++);
+		i = wilc_wlan_cfg_find((wid >> 12) & 0x7, wid);
 		switch ((wid >> 12) & 0x7) {
 		case WID_CHAR:
-			do {
-				if (g_cfg_byte[i].id == WID_NIL)
-					break;
-
-				if (g_cfg_byte[i].id == wid) {
-					g_cfg_byte[i].val = info[4];
-					break;
-				} 
-				i++;
-			} while (1);
+			if (i >= 0)
+				g_cfg_byte[i].val = info[4];
 			len = 3;
 			break;
 		case WID_SHORT:
-			do {
-				if (g_cfg_hword[i].id == WID_NIL)
-					break;
-
-				if (g_cfg_hword[i].id == wid) {
+			if (i >= 0) {
 #ifdef BIG_ENDIAN
-					g_cfg_hword[i].val = (info[4]<<8)|(info[5]);
+				g_cfg_hword[i].val = (info[4]<<8)|(info[5]);
 #else
-					g_cfg_hword[i].val = info[4]|(info[5]<<8);
+				g_cfg_hword[i].val = info[4]|(info[5]<<8);
 #endif
-					break;
-				} 
-				i++;
-			} while (1);
+			}
 			len = 4;
 			break;
 		case WID_INT:
-			do {
-				if (g_cfg_word[i].id == WID_NIL)
-					break;
-
-				if (g_cfg_word[i].id == wid) {
+			if (i >= 0) {
 #ifdef BIG_ENDIAN
-					g_cfg_word[i].val = (info[4]<<24)|(info[5]<<16)|(info[6]<<8)|(info[7]);
+				g_cfg_word[i].val = (info[4]<<24)|(info[5]<<16)|(info[6]<<8)|(info[7]);
 #else
-					g_cfg_word[i].val = info[4]|(info[5]<<8)|(info[6]<<16)|(info[7]<<24);
+				g_cfg_word[i].val = info[4]|(info[5]<<8)|(info[6]<<16)|(info[7]<<24);
 #endif
-					break;
-				} 
-				i++;
-			} while (1);
+			}
 			len = 6;
 			break;
 		case WID_STR:
-			do {
-				if (g_cfg_str[i].id == WID_NIL)
-					break;
-
-				if (g_cfg_str[i].id == wid) {
-					if(wid == WID_SITE_SURVEY_RESULTS)
-					{
-						static int toggle = 0;
-						PRINT_INFO(GENERIC_DBG,"Site survey results received[%d]\n",
-								size);
-
-						PRINT_INFO(GENERIC_DBG,"Site survey results value[%d]toggle[%d]\n",size,toggle);
-						i += toggle;
-						toggle ^= 1;
-					}
-					memcpy(g_cfg_str[i].str, &info[2], (info[2]+2));
-					break;
-				} 
-				i++;
-			} while (1);
+			if (wid == WID_SITE_SURVEY_RESULTS) {
+				PRINT_INFO(GENERIC_DBG,"Site survey results received[%d] fragment[%d]\n",size,frags);
+				if (frags < WILC_CFG_SURVEY_FRAGS) {
+					memcpy(g_mac.scan_result[frags], &info[2], (info[2]+2));
+					frags++;
+					/* a new response replaces the previous fragments */
+					g_mac.scan_result_rcvd = frags;
+					g_mac.scan_result_read = 0;
+				}
+			} else if (i >= 0) {
+				memcpy(g_cfg_str[i].str, &info[2], (info[2]+2));
+			}
 			len = 2+info[2];
 			break;
 		default:
@@ -472,69 +522,45 @@ static int wilc_wlan_cfg_get_wid_value(uint16_t wid, uint8_t *buffer, uint32_t b
 		return 4; 
 	}
 
-	i = 0;
+	if (type >= WILC_CFG_TYPES) {
+		g_mac.dPrint(N_ERR, "[CFG]: illegal type (%08x)\n", wid);
+		return 0;
+	}
+
+	i = wilc_wlan_cfg_find(type, wid);
+	if (i < 0)
+		return 0;
+
 	if (type == 0) {					/* byte command */
-		do {
-			if (g_cfg_byte[i].id == WID_NIL)
-				break;
-
-			if (g_cfg_byte[i].id == wid) {
-				memcpy(buffer,  &g_cfg_byte[i].val, 1);
-				ret = 1;
-				break;
-			}
-			i++;
-		} while (1);
+		memcpy(buffer,  &g_cfg_byte[i].val, 1);
+		ret = 1;
 	} else if (type == 1) {			/* half word command */
-		do {
-			if (g_cfg_hword[i].id == WID_NIL)
-				break;
-
-			if (g_cfg_hword[i].id == wid) {
-				memcpy(buffer,  &g_cfg_hword[i].val, 2);
-				ret = 2;
-				break;
-			}
-			i++;
-		} while (1);
+		memcpy(buffer,  &g_cfg_hword[i].val, 2);
+		ret = 2;
 	} else if (type == 2) {			/* word command */
-		do {
-			if (g_cfg_word[i].id == WID_NIL)
-				break;
-
-			if (g_cfg_word[i].id == wid) {
-				memcpy(buffer,  &g_cfg_word[i].val, 4);
-				ret = 4;
-				break;
-			}
-			i++;
-		} while (1);
+		memcpy(buffer,  &g_cfg_word[i].val, 4);
+		ret = 4;
 	} else if (type == 3) {			/* string command */
-		do {
-			if (g_cfg_str[i].id == WID_NIL)
-				break;
-
-			if (g_cfg_str[i].id == wid) {
-				uint32_t size =  (g_cfg_str[i].str[0])|(g_cfg_str[i].str[1]<<8);
-				if (buffer_size >= size) {
-					if(g_cfg_str[i].id == WID_SITE_SURVEY_RESULTS)
-					{
-						static int toggle = 0;
-						PRINT_INFO(GENERIC_DBG,"Site survey results value[%d]\n",
-								size);
-						i += toggle;
-						toggle ^= 1;
-
-					}
-					memcpy(buffer,  &g_cfg_str[i].str[2], size);
-					ret = size;
-				}
-				break;
+		uint8_t *str = g_cfg_str[i].str;
+		uint32_t size;
+
+		if (wid == WID_SITE_SURVEY_RESULTS) {
+			/* fragments go out in the order they came in */
+			if (g_mac.scan_result_read >= g_mac.scan_result_rcvd)
+				return 0;
+			str = g_mac.scan_result[g_mac.scan_result_read];
+		}
+
+		size = (str[0])|(str[1]<<8);
+		if (buffer_size >= size) {
+			if (wid == WID_SITE_SURVEY_RESULTS) {
+				PRINT_INFO(GENERIC_DBG,"Site survey results value[%d] fragment[%d]\n",
+						size,g_mac.scan_result_read);
+				g_mac.scan_result_read++;
 			}
-			i++;
-		} while (1);
-	} else {
-		g_mac.dPrint(N_ERR, "[CFG]: illegal type (%08x)\n", wid);
+			memcpy(buffer,  &str[2], size);
+			ret = size;
+		}
 	}
 
 	return ret;
@@ -632,6 +658,7 @@ static int wilc_wlan_cfg_init(wilc_debug_func func)
 {
 	memset((void *)&g_mac, 0, sizeof(wilc_mac_cfg_t));
 	g_mac.dPrint = func;
+	wilc_wlan_cfg_build_index();
 	return 1;
 }
 
@@ -642,3 +669,151 @@ wilc_cfg_func_t mac_cfg = {
 	wilc_wlan_cfg_indicate_rx,
 	wilc_wlan_cfg_init,
 };
+
+#if defined(WILC_DEBUGFS)
+/********************************************
+
+	Response Parsing Benchmark
+
+********************************************/
+#define WILC_CFG_BENCH_FRAMES	20000
+
+/* The lookup the index replaced: a scan of the table of the WID type */
+static int wilc_wlan_cfg_find_linear(uint32_t type, uint32_t wid)
+{
+	uint32_t id;
+	int i;
+
+	for (i = 0; (id = wilc_wlan_cfg_id(type, i)) != WID_NIL; i++) {
+		if (id == wid)
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Fill a response frame with every WID of every table, round after round
+ * until it is full, each encoded as its type says. Returns the frame size.
+ */
+static int wilc_wlan_cfg_bench_frame(uint8_t *frame, int *wids)
+{
+	static uint8_t str[8] = "wilc";
+	uint32_t offset = 0, type, id;
+	int i, n, added;
+
+	*wids = 0;
+	do {
+		added = 0;
+		for (type = 0; type < WILC_CFG_TYPES; type++) {
+			for (i = 0; (id = wilc_wlan_cfg_id(type, i)) != WID_NIL; i++) {
+				switch ((id >> 12) & 0x7) {
+				case WID_CHAR:
+					n = wilc_wlan_cfg_set_byte(frame, offset, id, 1);
+					break;
+				case WID_SHORT:
+					n = wilc_wlan_cfg_set_hword(frame, offset, id, 1);
+					break;
+				case WID_INT:
+					n = wilc_wlan_cfg_set_word(frame, offset, id, 1);
+					break;
+				case WID_STR:
+					n = wilc_wlan_cfg_set_str(frame, offset, id, str, sizeof(str));
+					break;
+				default:
+					n = 0;
+					break;
+				}
+				if (n) {
+					offset += n;
+					added++;
+				}
+			}
+		}
+		*wids += added;
+	} while (added);
+
+	return offset;
+}
+
+/*
+ * Walk a response frame as wilc_wlan_parse_response_frame() does and look
+ * up each WID with find, without storing the values. Returns the WIDs found.
+ */
+static int wilc_wlan_cfg_bench_walk(uint8_t *info, int size, int (*find)(uint32_t, uint32_t))
+{
+	uint32_t wid, len;
+	int found = 0;
+
+	while (size > 0) {
+		wid = info[0] | (info[1] << 8);
+		if (find((wid >> 12) & 0x7, wid) >= 0)
+			found++;
+		switch ((wid >> 12) & 0x7) {
+		case WID_CHAR:
+			len = 3;
+			break;
+		case WID_SHORT:
+			len = 4;
+			break;
+		case WID_INT:
+			len = 6;
+			break;
+		case WID_STR:
+			len = 2+info[2];
+			break;
+		default:
+			len = 0;
+			break;
+		}
+		size -= (2 + len);
+		info += (2 + len);
+	}
+
+	return found;
+}
+
+int wilc_wlan_cfg_bench_parse(char *buf, int size)
+{
+	static const struct {
+		const char *name;
+		int (*find)(uint32_t, uint32_t);
+	} lookup[] = {
+		{ "indexed", wilc_wlan_cfg_find },
+		{ "linear", wilc_wlan_cfg_find_linear },
+	};
+	uint8_t *frame;
+	int frame_size, wids, found, i, n, len = 0;
+	uint64_t ns;
+	ktime_t start;
+
+	/* the index is built by wilc_wlan_cfg_init() */
+	if (g_mac.dPrint == NULL)
+		return scnprintf(buf, size, "not initialized\n");
+
+	frame = kmalloc(MAX_CFG_FRAME_SIZE, GFP_KERNEL);
+	if (frame == NULL)
+		return scnprintf(buf, size, "out of memory\n");
+
+	frame_size = wilc_wlan_cfg_bench_frame(frame, &wids);
+	len += scnprintf(buf + len, size - len, "%u frames of %d bytes, %d wids each, %d wids not indexed\n",
+			WILC_CFG_BENCH_FRAMES, frame_size, wids, g_cfg_collisions);
+	len += scnprintf(buf + len, size - len, "%-8s %9s %7s %6s\n", "lookup", "ns/frame", "ns/wid", "found");
+
+	for (i = 0; i < ARRAY_SIZE(lookup); i++) {
+		found = 0;
+		start = ktime_get();
+		for (n = 0; n < WILC_CFG_BENCH_FRAMES; n++)
+			found += wilc_wlan_cfg_bench_walk(frame, frame_size, lookup[i].find);
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		len += scnprintf(buf + len, size - len, "%-8s %9u %7u %6d\n", lookup[i].name,
+				(uint32_t)div_u64(ns, WILC_CFG_BENCH_FRAMES),
+				wids ? (uint32_t)div_u64(ns, (uint32_t)WILC_CFG_BENCH_FRAMES * wids) : 0,
+				found / WILC_CFG_BENCH_FRAMES);
+	}
+
+	kfree(frame);
+
+	return len;
+}
+#endif
@@ -10,6 +10,9 @@
 #ifndef WILC_WLAN_CFG_H
 #define WILC_WLAN_CFG_H
 
+/* site survey result fragments returned per config response */
+#define WILC_CFG_SURVEY_FRAGS	2
+
 typedef struct {
 	uint16_t id;
 	uint16_t val;
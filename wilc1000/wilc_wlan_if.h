@@ -123,8 +123,16 @@ typedef struct {
 	} u;
 } wilc_wlan_io_func_t;
 
+typedef struct {
+	uint8_t *buff;
+	uint32_t size;
+	uint32_t pkt_offset;
+} wilc_rx_pkt_t;
+
 typedef struct {
 	void (*rx_indicate)(uint8_t *, uint32_t,uint32_t);
+	/* optional, takes the data packets of a whole RX buffer at once */
+	void (*rx_indicate_batch)(wilc_rx_pkt_t *, uint32_t);
 	void (*rx_complete)(void);
 } wilc_wlan_net_func_t;
 
@@ -158,7 +166,16 @@ typedef struct {
 	void *rxq_critical_section;
 	void *rxq_wait_event;
 
+	/* config/management frames handed off by the RX path */
+	void *cfg_rxq_critical_section;
+	void *cfg_rxq_wait_event;
+
 	void *cfg_wait_event;
+	/* held by a config transaction from start to commit */
+	void *cfg_txn_critical_section;
+
+	/* firmware download transfer size, clamped to WILC_FW_CHUNK_MIN..MAX */
+	uint32_t fw_chunk_size;
 } wilc_wlan_os_context_t;
 
 typedef struct {
@@ -203,6 +220,8 @@ struct tx_complete_data{
 
 
 typedef void (*wilc_tx_complete_func_t)(void *, int);
+/* config transaction completion: priv, 0 or -1 */
+typedef void (*wilc_cfg_done_func_t)(void *, int);
 
 #define WILC_TX_ERR_NO_BUF (-2)
 
@@ -210,14 +229,29 @@ typedef struct {
 	int (*wlan_firmware_download)(const uint8_t *, uint32_t);
 	int (*wlan_start)(void);
 	int (*wlan_stop)(void);
+	/* wake the chip first only if this driver booted the firmware */
+	int (*wlan_fw_running)(int);
+	void (*wlan_keep_fw)(int);
 	int (*wlan_add_to_tx_que)(void *, uint8_t *, uint32_t, wilc_tx_complete_func_t);
 	int (*wlan_handle_tx_que)(uint32_t *);
 	void (*wlan_handle_rx_que)(void);
+	void (*wlan_handle_cfg_rx_que)(void);
 	void (*wlan_handle_rx_isr)(void);
 	void (*wlan_cleanup)(void);
 	int (*wlan_cfg_set)(int, uint32_t, uint8_t *, uint32_t, int,uint32_t);
 	int (*wlan_cfg_get)(int, uint32_t, int,uint32_t);
 	int (*wlan_cfg_get_value)(uint32_t, uint8_t *, uint32_t);
+	/* config transaction: WIDs packed into as few frames as fit, one wait per frame */
+	int (*wlan_cfg_txn_start)(uint32_t);
+	int (*wlan_cfg_txn_set)(uint32_t, uint8_t *, uint32_t);
+	int (*wlan_cfg_txn_get)(uint32_t);
+	int (*wlan_cfg_txn_commit)(void);
+	int (*wlan_cfg_txn_commit_async)(wilc_cfg_done_func_t, void *);
+	/* commit a query, wlan_cfg_txn_end() once its values are read */
+	int (*wlan_cfg_txn_commit_hold)(void);
+	void (*wlan_cfg_txn_end)(void);
+	/* fail every cfg frame still waiting for an answer */
+	void (*wlan_cfg_abort_all)(void);
 	/*Bug3959: transmitting mgmt frames received from host*/
 	#if defined(WILC_AP_EXTERNAL_MLME) || defined(WILC_P2P)
 	int(*wlan_add_mgmt_to_tx_que)(void *, uint8_t *, uint32_t, wilc_tx_complete_func_t);